@@ -0,0 +1,358 @@
+#include "Batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+// Quote a CSV field when it holds a separator, a quote or a line break
+static string csvField(const string &s) {
+    if (s.find_first_of(",\"\r\n") == string::npos) return s;
+    string quoted = "\"";
+    for (char c : s) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+// Print the command-line usage
+void Batch::usage(ostream &out) {
+    out << "Usage: FEUP_DA_Project_2 --edges FILE [options]" << endl;
+    out << "Without arguments, the interactive menus are shown." << endl << endl;
+    out << "  --edges FILE        edges file (origin,destination,distance)" << endl;
+    out << "  --nodes FILE        nodes file (id,longitude,latitude), optional" << endl;
+    out << "  --algorithm NAMES   comma-separated algorithms, or \"all\" (default: triangular); without --deadline," << endl;
+    out << "                      \"all\" skips backtracking above " << Data::EXACT_MAX_VERTICES << " vertices," << endl;
+    out << "                      and the insertion heuristics above " << Data::INSERTION_MAX_VERTICES << " vertices even with it" << endl;
+    out << "  --start ID          starting vertex of backtracking, ant-colony and real-world-nearest-neighbor;" << endl;
+    out << "                      the others ignore it (default: 0)" << endl;
+    out << "  --time SECONDS      time budget of the metaheuristics (default: 10)" << endl;
+    out << "  --threads N         threads of the shared pool and replicas of the metaheuristics, 0 for all (default: 0)" << endl;
+    out << "  --format json|csv   output format (default: json)" << endl;
+    out << "  --output FILE       write the results to FILE instead of standard output" << endl;
+    out << "  --tour              include the tours in the results" << endl;
+    out << "  --portfolio         race several algorithms in parallel and report the best tour and its finder" << endl;
+    out << "  --deadline SECONDS  stop every run after SECONDS and report the best tour found by then" << endl;
+    out << "  --progress          print every better tour found to standard error, with its time" << endl;
+    out << "  --perf              measure every run with the CPU performance counters (Linux)" << endl;
+    out << "  --trace FILE        write a timeline of the phases and threads for chrome://tracing or Perfetto" << endl;
+    out << "  --index-cache DIR   save the shortest path index of large road networks in DIR, and reuse it" << endl;
+    out << "  --help              show this message" << endl << endl;
+    out << "Algorithms:";
+    for (const string &name : Data::algorithmNames()) out << ' ' << name;
+    out << endl;
+}
+
+// Parse the command-line arguments
+void Batch::parse(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "--tour") {
+            printTours = true;
+            continue;
+        }
+        if (option == "--perf") {
+            hardwareCounters = true;
+            continue;
+        }
+        if (option == "--progress") {
+            printProgress = true;
+            continue;
+        }
+        if (option == "--portfolio") {
+            portfolio = true;
+            continue;
+        }
+        if (i + 1 == argc) throw runtime_error("Missing value for " + option + ".");
+        string value = argv[++i];
+
+        try {
+            if (option == "--edges") edgesFilePath = value;
+            else if (option == "--nodes") nodesFilePath = value;
+            else if (option == "--output") outputFilePath = value;
+            else if (option == "--trace") traceFilePath = value;
+            else if (option == "--index-cache") indexCacheFolder = value;
+            else if (option == "--start") startingVertexId = stoi(value);
+            else if (option == "--time") {
+                timeBudget = stod(value);
+                if (!(timeBudget > 0)) throw invalid_argument(value);
+            }
+            else if (option == "--deadline") {
+                deadline = stod(value);
+                if (!(deadline > 0)) throw invalid_argument(value);
+            }
+            else if (option == "--threads") {
+                int n = stoi(value);
+                if (n < 0) throw invalid_argument(value);
+                threads = n;
+            }
+            else if (option == "--format") {
+                if (value != "json" && value != "csv") throw invalid_argument(value);
+                format = value;
+            }
+            else if (option == "--algorithm") {
+                stringstream ss(value);
+                string name;
+                while (getline(ss, name, ',')) {
+                    if (name == "all") {
+                        const vector<string> &names = Data::algorithmNames();
+                        algorithms.insert(algorithms.end(), names.begin(), names.end());
+                        continue;
+                    }
+                    const vector<string> &names = Data::algorithmNames();
+                    if (find(names.begin(), names.end(), name) == names.end())
+                        throw runtime_error("Unknown algorithm: " + name + ".");
+                    algorithms.push_back(name);
+                    namedAlgorithms.push_back(name);
+                }
+            }
+            else throw runtime_error("Unknown option: " + option + ".");
+        } catch (const logic_error &) {
+            throw runtime_error("Invalid value for " + option + ": " + value + ".");
+        }
+    }
+
+    if (edgesFilePath.empty()) throw runtime_error("The edges file is missing (--edges).");
+    if (portfolio && !algorithms.empty()) throw runtime_error("--portfolio chooses its own algorithms (no --algorithm).");
+    if (algorithms.empty() && !portfolio) algorithms.emplace_back("triangular");
+}
+
+// Write the results as a JSON object
+void Batch::writeJson(ostream &out, const Data &data, const Instrumentation::Snapshot &load, const Memory::Report &memory,
+                      const vector<TSPRun> &runs, const PortfolioRun *race, double lowerBound) const {
+    const GraphAnalysis &analysis = data.getAnalysis();
+    out << "{" << endl;
+    out << "  \"edges\": " << Instrumentation::jsonString(edgesFilePath.string()) << "," << endl;
+    out << "  \"nodes\": " << (nodesFilePath.empty() ? "null" : Instrumentation::jsonString(nodesFilePath.string()))
+        << "," << endl;
+    out << "  \"vertices\": " << analysis.vertices << "," << endl;
+    out << "  \"components\": " << analysis.components << "," << endl;
+    out << "  \"coordinates\": " << (analysis.coordinates ? "true" : "false") << "," << endl;
+    out << "  \"lowerBound\": ";
+    if (isnan(lowerBound)) out << "null";
+    else out << lowerBound;
+    out << "," << endl;
+    out << "  \"loadSeconds\": " << load.seconds[Instrumentation::LOAD] + load.seconds[Instrumentation::PREPROCESSING] << "," << endl;
+    out << "  \"load\": {";
+    Instrumentation::writeJson(out, load);
+    out << "}," << endl;
+    out << "  ";
+    Memory::writeJson(out, memory);
+    out << "," << endl;
+    out << "  \"timeBudget\": " << timeBudget << "," << endl;
+    out << "  \"threads\": " << threads << "," << endl;
+    out << "  \"deadline\": ";
+    if (isfinite(deadline)) out << deadline;
+    else out << "null";
+    out << "," << endl;
+    if (race) {
+        out << "  \"portfolio\": {\"winner\": ";
+        if (race->winner >= 0) out << Instrumentation::jsonString(runs[race->winner].algorithm);
+        else out << "null";
+        out << ", \"optimal\": " << (race->optimal ? "true" : "false") << ", \"seconds\": " << race->seconds << "}," << endl;
+    }
+    out << "  \"runs\": [";
+    for (size_t i = 0; i < runs.size(); i++) {
+        const TSPRun &run = runs[i];
+        out << (i ? "," : "") << endl << "    {";
+        out << "\"algorithm\": " << Instrumentation::jsonString(run.algorithm);
+        out << ", \"start\": ";
+        if (Data::usesStartingVertex(run.algorithm)) out << startingVertexId;
+        else out << "null";
+        out << ", \"solved\": " << (run.solved ? "true" : "false");
+        out << ", \"cost\": ";
+        if (run.solved) out << run.cost;
+        else out << "null";
+        out << ", \"gap\": ";
+        if (run.solved && lowerBound > 0) out << run.cost / lowerBound - 1;
+        else out << "null";
+        out << ", \"seconds\": " << run.seconds;
+        out << ", \"stopped\": " << (run.stopped ? "true" : "false");
+        out << ", \"error\": " << (run.solved ? "null" : Instrumentation::jsonString(run.error)) << ", ";
+        Instrumentation::writeJson(out, run.profile);
+        if (hardwareCounters) {
+            out << ", ";
+            HardwareCounters::writeJson(out, run.hardware);
+        }
+        out << ", ";
+        Memory::writeJson(out, run.memory);
+        if (printTours) {
+            out << ", \"tour\": [";
+            for (size_t j = 0; j < run.tour.size(); j++) out << (j ? ", " : "") << run.tour[j];
+            out << "]";
+        }
+        out << "}";
+    }
+    out << endl << "  ]" << endl << "}" << endl;
+}
+
+// Write the results as CSV, one line per run
+void Batch::writeCsv(ostream &out, const Data &data, const Instrumentation::Snapshot &load, const Memory::Report &memory,
+                     const vector<TSPRun> &runs, const PortfolioRun *race, double lowerBound) const {
+    const GraphAnalysis &analysis = data.getAnalysis();
+    double loadSeconds = load.seconds[Instrumentation::LOAD] + load.seconds[Instrumentation::PREPROCESSING];
+    out << "edges,nodes,vertices,load_seconds,algorithm,start,time_budget,threads,solved,cost,lower_bound,gap,seconds,stopped,error";
+    for (int p = 0; p < Instrumentation::PHASES; p++) out << ",phase_" << Instrumentation::phaseName((Instrumentation::Phase) p) << "_seconds";
+    if (Instrumentation::COUNTERS_ENABLED) {
+        for (int c = 0; c < Instrumentation::COUNTERS; c++) out << ',' << Instrumentation::counterName((Instrumentation::Counter) c);
+    }
+    if (hardwareCounters) {
+        for (int e = 0; e < HardwareCounters::EVENTS; e++) out << ',' << HardwareCounters::eventName((HardwareCounters::Event) e);
+    }
+    out << ",load_structure_bytes,structure_bytes,peak_resident_kb";
+    if (Memory::HEAP_TRACKING) out << ",peak_heap_bytes";
+    if (race) out << ",winner,optimal";
+    if (printTours) out << ",tour";
+    out << endl;
+    for (size_t i = 0; i < runs.size(); i++) {
+        const TSPRun &run = runs[i];
+        out << csvField(edgesFilePath.string()) << ',' << csvField(nodesFilePath.string()) << ','
+            << analysis.vertices << ',' << loadSeconds << ',' << run.algorithm << ',';
+        if (Data::usesStartingVertex(run.algorithm)) out << startingVertexId;
+        out << ',' << timeBudget << ',' << threads << ',' << (run.solved ? "true" : "false") << ',';
+        if (run.solved) out << run.cost;
+        out << ',';
+        if (!isnan(lowerBound)) out << lowerBound;
+        out << ',';
+        if (run.solved && lowerBound > 0) out << run.cost / lowerBound - 1;
+        out << ',' << run.seconds << ',' << (run.stopped ? "true" : "false") << ',' << csvField(run.error);
+        for (double seconds : run.profile.seconds) out << ',' << seconds;
+        if (Instrumentation::COUNTERS_ENABLED) {
+            for (uint64_t count : run.profile.counts) out << ',' << count;
+        }
+        if (hardwareCounters) {
+            for (int e = 0; e < HardwareCounters::EVENTS; e++) {
+                out << ',';
+                if (run.hardware.available[e]) out << run.hardware.counts[e];
+            }
+        }
+        out << ',' << memory.structureBytes() << ',' << run.memory.structureBytes() << ',' << run.memory.peakResidentKB;
+        if (Memory::HEAP_TRACKING) out << ',' << run.memory.heapPeakBytes;
+        if (race) {
+            bool winner = race->winner == (int) i;
+            out << ',' << (winner ? "true" : "false") << ',' << (winner && race->optimal ? "true" : "false");
+        }
+        if (printTours) {
+            out << ',';
+            for (size_t j = 0; j < run.tour.size(); j++) out << (j ? " " : "") << run.tour[j];
+        }
+        out << endl;
+    }
+}
+
+// Run the batch mode: parse the arguments, load the graph, solve and write the results
+int Batch::run(int argc, char *argv[]) {
+    Batch batch;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--help" || string(argv[i]) == "-h") {
+            usage(cout);
+            return 0;
+        }
+    }
+    try {
+        batch.parse(argc, argv);
+    } catch (const runtime_error &e) {
+        cerr << e.what() << endl << endl;
+        usage(cerr);
+        return 2;
+    }
+
+    // Open the output files first, so that a bad path does not throw away the runs
+    ofstream outputFile, traceFile;
+    if (!batch.outputFilePath.empty()) {
+        outputFile.open(batch.outputFilePath);
+        if (!outputFile.is_open()) {
+            cerr << "Error opening the output file." << endl;
+            return 1;
+        }
+    }
+    if (!batch.traceFilePath.empty()) {
+        traceFile.open(batch.traceFilePath);
+        if (!traceFile.is_open()) {
+            cerr << "Error opening the trace file." << endl;
+            return 1;
+        }
+    }
+
+    Data data;
+    data.setThreads(batch.threads);
+    data.setEdgesFilePath(batch.edgesFilePath);
+    if (!batch.nodesFilePath.empty()) data.setNodesFilePath(batch.nodesFilePath);
+    data.setIndexCacheFolder(batch.indexCacheFolder);
+    Instrumentation::reset();
+    if (!batch.traceFilePath.empty()) Instrumentation::startTrace();
+    try {
+        data.readFiles();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    Instrumentation::Snapshot load = Instrumentation::snapshot();
+    Memory::Report memory = data.memoryReport();
+    double lowerBound = data.lowerBound();
+    data.setHardwareCounters(batch.hardwareCounters);
+
+    // Every run gets its own deadline, and prints the better tours it finds when asked to
+    auto control = [&batch](const string &name) {
+        auto control = make_unique<SolveControl>(batch.deadline);
+        if (batch.printProgress) {
+            control->setProgress([name](double cost, const vector<Vertex *> &, double seconds) {
+                cerr << name << ": " << fixed << setprecision(1) << cost << " at " << setprecision(2) << seconds
+                     << "s" << defaultfloat << endl;
+            });
+        }
+        return control;
+    };
+
+    vector<TSPRun> runs;
+    PortfolioRun race;
+    if (batch.portfolio) {
+        race = data.solvePortfolio(batch.startingVertexId, batch.timeBudget, batch.threads, control("portfolio").get());
+        runs = race.entrants;
+        cerr << "portfolio: " << (race.winner >= 0 ? "won by " + runs[race.winner].algorithm : "not solved")
+             << (race.optimal ? " (proven optimal)" : "") << " in " << fixed << setprecision(2) << race.seconds
+             << "s" << defaultfloat << endl;
+    }
+    // "all" leaves out, unless they are also named, the algorithms that would take too long on this graph
+    const size_t vertices = data.getAnalysis().vertices;
+    auto skipReason = [&batch, vertices](const string &algorithm) -> string {
+        const vector<string> &named = batch.namedAlgorithms;
+        if (find(named.begin(), named.end(), algorithm) != named.end()) return "";
+        if (algorithm == "backtracking" && !isfinite(batch.deadline) && vertices > Data::EXACT_MAX_VERTICES)
+            return "Skipped: more than " + to_string(Data::EXACT_MAX_VERTICES) + " vertices (name it or give --deadline to run it).";
+        if ((algorithm == "cheapest-insertion" || algorithm == "farthest-insertion") && vertices > Data::INSERTION_MAX_VERTICES)
+            return "Skipped: more than " + to_string(Data::INSERTION_MAX_VERTICES) + " vertices (name it to run it).";
+        return "";
+    };
+    for (const string &algorithm : batch.algorithms) {
+        string skip = skipReason(algorithm);
+        if (!skip.empty()) {
+            TSPRun skipped;
+            skipped.algorithm = algorithm;
+            skipped.error = skip;
+            runs.push_back(skipped);
+            cerr << algorithm << ": skipped" << endl;
+            continue;
+        }
+        runs.push_back(data.solve(algorithm, batch.startingVertexId, batch.timeBudget, batch.threads,
+                                  control(algorithm).get()));
+        cerr << algorithm << ": " << (runs.back().solved ? "solved" : "not solved") << " in " << fixed
+             << setprecision(2) << runs.back().seconds << "s" << defaultfloat
+             << (runs.back().stopped ? " (stopped at the deadline)" : "") << endl;
+    }
+    if (batch.hardwareCounters && !runs.empty() && !runs.front().hardware.error.empty())
+        cerr << "Some hardware counters are unavailable (" << runs.front().hardware.error << ")." << endl;
+
+    if (!batch.traceFilePath.empty()) {
+        Instrumentation::stopTrace();
+        Instrumentation::writeTrace(traceFile);
+    }
+
+    ostream &out = batch.outputFilePath.empty() ? cout : outputFile;
+    out << setprecision(12);
+    const PortfolioRun *raced = batch.portfolio ? &race : nullptr;
+    if (batch.format == "json") batch.writeJson(out, data, load, memory, runs, raced, lowerBound);
+    else batch.writeCsv(out, data, load, memory, runs, raced, lowerBound);
+    return 0;
+}
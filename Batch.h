@@ -0,0 +1,112 @@
+#ifndef FEUP_DA_PROJECT_2_BATCH_H
+#define FEUP_DA_PROJECT_2_BATCH_H
+
+#include "Data.h"
+
+/**
+* @brief Non-interactive mode: loads a graph, runs algorithms on it and writes the results as JSON or CSV.
+*
+* @details Used instead of the menus when the program is given command-line arguments, so that scripts can
+* run many instances without driving the menus through standard input. Results go to standard output (or to
+* the output file) and everything meant for people, errors included, goes to standard error.
+*/
+
+class Batch {
+private:
+    filesystem::path nodesFilePath;
+    filesystem::path edgesFilePath;
+    filesystem::path outputFilePath;
+    filesystem::path traceFilePath;
+    filesystem::path indexCacheFolder;  // see Data::setIndexCacheFolder
+    vector<string> algorithms;
+    vector<string> namedAlgorithms; // asked for by name, not only through "all"
+    int startingVertexId = 0;
+    double timeBudget = 10;
+    unsigned int threads = 0;
+    string format = "json";
+    bool printTours = false;
+    bool hardwareCounters = false;
+    double deadline = numeric_limits<double>::infinity();   // wall-clock limit of every run, in seconds
+    bool printProgress = false;
+    bool portfolio = false;     // race the portfolio entrants instead of running the algorithms in turn
+
+    /**
+    * @brief Parses the command-line arguments into the options of the run.
+    *
+    * @param argc The number of arguments.
+    * @param argv The arguments, the program name first.
+    *
+    * @throws std::runtime_error if an option is unknown, lacks its value or has an invalid one.
+    */
+    void parse(int argc, char *argv[]);
+
+    /**
+    * @brief Writes the results as a JSON object, with one entry per run in "runs".
+    *
+    * @details The starting vertex is written with the runs that start from it (see Data::usesStartingVertex),
+    * and as null with the others. The lower bound on the cost of the tours is written as "lowerBound", and the gap
+    * of every tour to it, cost / bound - 1, as "gap"; both are null when the graph has no bound.
+    *
+    * @param out The stream to write to.
+    * @param data The loaded data.
+    * @param load The profile of the loading of the files.
+    * @param memory The memory report after the loading.
+    * @param runs The results of the runs.
+    * @param race The race the runs come from, written as "portfolio", or nullptr if they ran in turn.
+    * @param lowerBound The lower bound on the cost of the tours (see Data::lowerBound), NaN if there is none.
+    */
+    void writeJson(ostream &out, const Data &data, const Instrumentation::Snapshot &load, const Memory::Report &memory,
+                   const vector<TSPRun> &runs, const PortfolioRun *race, double lowerBound) const;
+
+    /**
+    * @brief Writes the results as CSV, a header line and then one line per run.
+    *
+    * @details Every run gets a column per phase with its time and, when the counters are compiled in, a column
+    * per counter, followed by a column per CPU event when the hardware counters are on (empty when the event
+    * could not be counted). The start column is empty for the algorithms that ignore the starting vertex (see
+    * Data::usesStartingVertex). The lower_bound and gap columns give the lower bound on
+    * the cost of the tours and the gap of the tour to it, cost / bound - 1, and are empty when the graph has no
+    * bound. The stopped column tells if the deadline cut the run short. The memory columns give the bytes of the structures after the load and after the
+    * run, and the peak memory of the run. After a race, the winner column marks the entrant with the best tour
+    * and the optimal column tells if that tour is proven optimal. Tours, when asked for, are written as vertex ids
+    * separated by spaces in the last column.
+    *
+    * @param out The stream to write to.
+    * @param data The loaded data.
+    * @param load The profile of the loading of the files.
+    * @param memory The memory report after the loading.
+    * @param runs The results of the runs.
+    * @param race The race the runs come from, or nullptr if they ran in turn.
+    * @param lowerBound The lower bound on the cost of the tours (see Data::lowerBound), NaN if there is none.
+    */
+    void writeCsv(ostream &out, const Data &data, const Instrumentation::Snapshot &load, const Memory::Report &memory,
+                  const vector<TSPRun> &runs, const PortfolioRun *race, double lowerBound) const;
+public:
+    /**
+    * @brief Prints the command-line usage.
+    *
+    * @param out The stream to print to.
+    */
+    static void usage(ostream &out);
+
+    /**
+    * @brief Runs the batch mode.
+    *
+    * @details Parses the arguments, loads the graph, runs every requested algorithm in turn on it (or races the
+    * portfolio, see Data::solvePortfolio) and writes the results. Algorithms that find no tour are reported as
+    * unsolved, with the reason, and do not stop the others. Algorithms that "--algorithm all" adds without
+    * naming them are skipped when they would take too long: backtracking without a deadline on graphs of more
+    * than Data::EXACT_MAX_VERTICES vertices, which it would never finish, and the insertion heuristics on graphs
+    * of more than Data::INSERTION_MAX_VERTICES vertices. Skipped algorithms are reported as unsolved too.
+    *
+    * @param argc The number of arguments.
+    * @param argv The arguments, the program name first.
+    *
+    * @return The exit status: 0 if the results were written, 1 if the graph, the output file or the trace file
+    * could not be opened, 2 if the arguments are invalid.
+    */
+    static int run(int argc, char *argv[]);
+};
+
+
+#endif //FEUP_DA_PROJECT_2_BATCH_H
@@ -0,0 +1,449 @@
+#include <fstream>
+#include <cstring>
+#include <array>
+#include "ContractionHierarchy.h"
+
+/************************* ContractionHierarchy  **************************/
+
+// Constructor: contract every vertex, least important first, and keep the upward edges and shortcuts
+ContractionHierarchy::ContractionHierarchy(const vector<Vertex *> &nodes) : n((int) nodes.size()) {
+    unordered_map<int, int> indices;
+    for (int i = 0; i < n; ++i) indices[nodes[i]->getId()] = i;
+    checksum = edgesChecksum(nodes);
+
+    // Working graph: the edges and shortcuts of every vertex to the vertices not contracted yet
+    vector<vector<Arc>> adjacency(n);
+    auto addArc = [&](int u, int w, double weight, int middle) {
+        for (Arc &arc : adjacency[u]) {
+            if (arc.target != w) continue;
+            if (weight < arc.weight) arc = {w, weight, middle};
+            return;
+        }
+        adjacency[u].push_back({w, weight, middle});
+    };
+
+    for (int i = 0; i < n; ++i) {
+        for (auto &pair : nodes[i]->getAdj()) {
+            auto it = indices.find(pair.first);
+            if (it == indices.end() || it->second == i) continue;
+            Edge *reverse = nodes[it->second]->findEdge(nodes[i]->getId());
+            if (!reverse || reverse->getWeight() != pair.second->getWeight())
+                throw runtime_error("Contraction hierarchies need an undirected graph");
+            addArc(i, it->second, pair.second->getWeight(), -1);
+        }
+    }
+
+    // Witness search: distances from u avoiding v, settling at most settledLimit vertices up to maxDist, and
+    // stopping early once the targets (marked in the second search of the workspace) are all settled
+    Workspace workspace;
+    auto witnessSearch = [&](int u, int v, double maxDist, int settledLimit, int targets) {
+        MutablePriorityQueue<Label, 4> queue;
+        Label &s = workspace.label(0, u);
+        s.dist = 0;
+        queue.insert(&s);
+
+        for (int settled = 0; !queue.empty() && settled < settledLimit && targets > 0; ++settled) {
+            Label *x = queue.extractMin();
+            TSP_COUNT(NODE_EXPANDED);
+            if (x->dist > maxDist) break;
+            if (workspace.touched(1, x->index)) targets--;
+            for (const Arc &arc : adjacency[x->index]) {
+                if (arc.target == v) continue;
+                Label &y = workspace.label(0, arc.target);
+                double dist = x->dist + arc.weight;
+                if (dist >= y.dist) continue;
+                y.dist = dist;
+                if (y.queueIndex) queue.decreaseKey(&y);
+                else queue.insert(&y);
+            }
+        }
+    };
+
+    // Shortcuts needed to contract v: one per pair of neighbours without a witness path
+    auto neededShortcuts = [&](int v, int settledLimit, vector<Arc> *added, vector<int> *from) {
+        int count = 0;
+        const vector<Arc> &arcs = adjacency[v];
+        for (size_t a = 0; a + 1 < arcs.size(); ++a) {
+            double maxDist = 0;
+            for (size_t b = a + 1; b < arcs.size(); ++b) maxDist = max(maxDist, arcs[a].weight + arcs[b].weight);
+            workspace.start(n);
+            for (size_t b = a + 1; b < arcs.size(); ++b) workspace.label(1, arcs[b].target);
+            witnessSearch(arcs[a].target, v, maxDist, settledLimit, (int) (arcs.size() - a - 1));
+
+            for (size_t b = a + 1; b < arcs.size(); ++b) {
+                double via = arcs[a].weight + arcs[b].weight;
+                int w = arcs[b].target;
+                if (workspace.touched(0, w) && workspace.labels[0][w].dist <= via) continue; // Witness found
+                count++;
+                if (added) {
+                    added->push_back({w, via, v});
+                    from->push_back(arcs[a].target);
+                }
+            }
+        }
+        return count;
+    };
+
+    // Importance: edge difference (shortcuts added minus edges removed), plus terms that spread the contracted
+    // vertices evenly over the graph: the number of neighbours already contracted and the level in the hierarchy
+    vector<int> contractedNeighbours(n, 0), level(n, 0);
+    auto importance = [&](int v) {
+        double edgeDifference = neededShortcuts(v, 20, nullptr, nullptr) - (double) adjacency[v].size();
+        return 2 * edgeDifference + contractedNeighbours[v] + level[v];
+    };
+
+    // Contraction order, updated lazily: outdated entries are skipped, and a vertex whose importance grew
+    // past the next one in the queue goes back in it
+    vector<double> priority(n);
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> order;
+    for (int v = 0; v < n; ++v) {
+        priority[v] = importance(v);
+        order.push({priority[v], v});
+    }
+
+    rank.assign(n, -1);
+    vector<vector<Arc>> upward(n);
+    int nextRank = 0;
+    while (!order.empty()) {
+        auto top = order.top();
+        order.pop();
+        int v = top.second;
+        if (rank[v] >= 0 || top.first != priority[v]) continue;
+
+        priority[v] = importance(v);
+        if (!order.empty() && priority[v] > order.top().first) {
+            order.push({priority[v], v});
+            continue;
+        }
+
+        // Contract v: add its shortcuts and take it out of the working graph
+        vector<Arc> added;
+        vector<int> from;
+        neededShortcuts(v, 200, &added, &from);
+        for (size_t k = 0; k < added.size(); ++k) {
+            addArc(from[k], added[k].target, added[k].weight, v);
+            addArc(added[k].target, from[k], added[k].weight, v);
+        }
+        shortcuts += (int) added.size();
+
+        rank[v] = nextRank++;
+        upward[v] = adjacency[v];
+        for (const Arc &arc : adjacency[v]) {
+            vector<Arc> &arcs = adjacency[arc.target];
+            arcs.erase(remove_if(arcs.begin(), arcs.end(), [v](const Arc &a) { return a.target == v; }), arcs.end());
+            contractedNeighbours[arc.target]++;
+            level[arc.target] = max(level[arc.target], level[v] + 1);
+        }
+        adjacency[v].clear();
+        adjacency[v].shrink_to_fit();
+
+        for (const Arc &arc : upward[v]) {
+            priority[arc.target] = importance(arc.target);
+            order.push({priority[arc.target], arc.target});
+        }
+    }
+
+    upOffsets.assign(n + 1, 0);
+    for (int v = 0; v < n; ++v) {
+        up.insert(up.end(), upward[v].begin(), upward[v].end());
+        upOffsets[v + 1] = (int) up.size();
+    }
+}
+
+// Getter for the number of vertices
+int ContractionHierarchy::size() const {
+    return n;
+}
+
+// Heap bytes of the ranks and the upward arcs
+size_t ContractionHierarchy::memoryBytes() const {
+    return Memory::vectorBytes(rank) + Memory::vectorBytes(upOffsets) + Memory::vectorBytes(up);
+}
+
+// Getter for the number of shortcuts
+int ContractionHierarchy::shortcutCount() const {
+    return shortcuts;
+}
+
+// Shortest-path distance between two vertices
+double ContractionHierarchy::distance(int source, int target, Workspace &workspace) const {
+    return search(source, target, workspace, nullptr);
+}
+
+// Shortest path between two vertices, unpacking the shortcuts as the vertices are visited
+bool ContractionHierarchy::path(int source, int target, Workspace &workspace, const function<void(int)> &visit) const {
+    int meeting = source;
+    if (search(source, target, workspace, &meeting) == numeric_limits<double>::max()) return false;
+
+    // Up from source to the meeting vertex: the arcs are found from the top, so they are gathered first
+    vector<int> arcs;
+    for (int v = meeting; v != source; v = workspace.labels[0][v].parent) {
+        arcs.push_back(workspace.labels[0][v].parentArc);
+    }
+    int from = source;
+    for (auto it = arcs.rbegin(); it != arcs.rend(); ++it) {
+        unpack(from, up[*it].target, *it, visit);
+        from = up[*it].target;
+    }
+
+    // Down from the meeting vertex to target, following the arcs of the backward search
+    for (int v = meeting; v != target; v = workspace.labels[1][v].parent) {
+        const Label &label = workspace.labels[1][v];
+        unpack(v, label.parent, label.parentArc, visit);
+    }
+    return true;
+}
+
+// Bidirectional upward search between source and target
+double ContractionHierarchy::search(int source, int target, Workspace &workspace, int *meeting) const {
+    workspace.start(n);
+    if (source == target) return 0;
+
+    MutablePriorityQueue<Label, 4> queues[2];
+    for (int direction = 0; direction < 2; ++direction) {
+        Label &s = workspace.label(direction, direction == 0 ? source : target);
+        s.dist = 0;
+        queues[direction].insert(&s);
+    }
+
+    // The searches take turns; a search stops once it settles a vertex no closer than the best path seen
+    double best = numeric_limits<double>::max();
+    bool done[2] = {false, false};
+    for (int direction = 0; !done[0] || !done[1]; direction = 1 - direction) {
+        if (done[direction]) continue;
+        if (queues[direction].empty()) {
+            done[direction] = true;
+            continue;
+        }
+
+        Label *u = queues[direction].extractMin();
+        TSP_COUNT(NODE_EXPANDED);
+        if (u->dist >= best) {
+            done[direction] = true;
+            continue;
+        }
+        if (workspace.touched(1 - direction, u->index) &&
+            u->dist + workspace.labels[1 - direction][u->index].dist < best) {
+            best = u->dist + workspace.labels[1 - direction][u->index].dist;
+            if (meeting) *meeting = u->index;
+        }
+        if (stalled(*u, direction, workspace)) continue;
+
+        for (int a = upOffsets[u->index]; a < upOffsets[u->index + 1]; ++a) {
+            Label &v = workspace.label(direction, up[a].target);
+            double dist = u->dist + up[a].weight;
+            if (dist >= v.dist) continue;
+            v.dist = dist;
+            v.parent = u->index;
+            v.parentArc = a;
+            if (v.queueIndex) queues[direction].decreaseKey(&v);
+            else queues[direction].insert(&v);
+        }
+    }
+    return best;
+}
+
+// Upward arc from low to high, if any
+int ContractionHierarchy::findArc(int low, int high) const {
+    for (int a = upOffsets[low]; a < upOffsets[low + 1]; ++a) {
+        if (up[a].target == high) return a;
+    }
+    return -1;
+}
+
+// Unpack an arc: a shortcut from - to through middle stands for the arcs middle - from and middle - to, both
+// held by middle, which was contracted before either end
+void ContractionHierarchy::unpack(int from, int to, int arc, const function<void(int)> &visit) const {
+    vector<array<int, 3>> pending = {{from, to, arc}};
+    while (!pending.empty()) {
+        auto [a, b, current] = pending.back();
+        pending.pop_back();
+
+        int middle = up[current].middle;
+        if (middle < 0) {
+            visit(b);
+            continue;
+        }
+        pending.push_back({middle, b, findArc(middle, b)});  // Second half, done after the first one
+        pending.push_back({a, middle, findArc(middle, a)});
+    }
+}
+
+// Stall-on-demand: the graph is undirected, so an upward arc (u, v) is also a way down from v to u. If the
+// search already reached v with a distance that makes u closer than its label, u is not on a shortest path
+// and relaxing its arcs would only grow the search
+bool ContractionHierarchy::stalled(const Label &u, int direction, const Workspace &workspace) const {
+    for (int a = upOffsets[u.index]; a < upOffsets[u.index + 1]; ++a) {
+        int v = up[a].target;
+        if (workspace.touched(direction, v) && workspace.labels[direction][v].dist + up[a].weight < u.dist) return true;
+    }
+    return false;
+}
+
+// Many-to-many table using buckets filled by the upward searches of the targets
+vector<double> ContractionHierarchy::table(const vector<int> &sources, const vector<int> &targets) const {
+    Workspace workspace;
+    unordered_map<int, vector<pair<int, double>>> buckets;  // vertex -> (target position, distance)
+    for (int t = 0; t < (int) targets.size(); ++t) {
+        upwardSearch(targets[t], 1, workspace, [&](int v, double dist) { buckets[v].push_back({t, dist}); });
+    }
+
+    const size_t columns = targets.size();
+    vector<double> result(sources.size() * columns, numeric_limits<double>::max());
+    for (size_t s = 0; s < sources.size(); ++s) {
+        double *row = result.data() + s * columns;
+        upwardSearch(sources[s], 0, workspace, [&](int v, double dist) {
+            auto it = buckets.find(v);
+            if (it == buckets.end()) return;
+            for (auto &entry : it->second) row[entry.first] = min(row[entry.first], dist + entry.second);
+        });
+    }
+    return result;
+}
+
+// Upward search from one vertex until its queue is empty
+template <class Visit>
+void ContractionHierarchy::upwardSearch(int source, int direction, Workspace &workspace, Visit visit) const {
+    workspace.start(n);
+    MutablePriorityQueue<Label, 4> queue;
+    Label &s = workspace.label(direction, source);
+    s.dist = 0;
+    queue.insert(&s);
+
+    while (!queue.empty()) {
+        Label *u = queue.extractMin();
+        TSP_COUNT(NODE_EXPANDED);
+        if (stalled(*u, direction, workspace)) continue;
+        visit(u->index, u->dist);
+        for (int a = upOffsets[u->index]; a < upOffsets[u->index + 1]; ++a) {
+            Label &v = workspace.label(direction, up[a].target);
+            double dist = u->dist + up[a].weight;
+            if (dist >= v.dist) continue;
+            v.dist = dist;
+            if (v.queueIndex) queue.decreaseKey(&v);
+            else queue.insert(&v);
+        }
+    }
+}
+
+// Checksum of the edges: an order independent sum of a hash of every edge
+uint64_t ContractionHierarchy::edgesChecksum(const vector<Vertex *> &nodes) {
+    auto mix = [](uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    };
+
+    uint64_t sum = nodes.size();
+    for (Vertex *v : nodes) {
+        for (auto &pair : v->getAdj()) {
+            double weight = pair.second->getWeight();
+            uint64_t bits;
+            memcpy(&bits, &weight, sizeof(bits));
+            sum += mix(mix(mix((uint32_t) v->getId()) ^ (uint32_t) pair.first) ^ bits);
+        }
+    }
+    return sum;
+}
+
+namespace {
+    const char CH_MAGIC[8] = {'T', 'S', 'P', 'C', 'H', '0', '0', '1'};
+
+    template <class T>
+    void writeValue(ofstream &file, const T &value) {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <class T>
+    bool readValue(ifstream &file, T &value) {
+        return (bool) file.read(reinterpret_cast<char *>(&value), sizeof(T));
+    }
+}
+
+// Save the index to a binary file
+void ContractionHierarchy::save(const filesystem::path &file) const {
+    ofstream out(file, ios::binary);
+    if (!out.is_open()) throw runtime_error("Error opening the contraction hierarchy file.");
+
+    out.write(CH_MAGIC, sizeof(CH_MAGIC));
+    writeValue(out, n);
+    writeValue(out, shortcuts);
+    writeValue(out, checksum);
+    for (int r : rank) writeValue(out, r);
+    for (int offset : upOffsets) writeValue(out, offset);
+    for (const Arc &arc : up) {
+        writeValue(out, arc.target);
+        writeValue(out, arc.weight);
+        writeValue(out, arc.middle);
+    }
+    if (!out) throw runtime_error("Error writing the contraction hierarchy file.");
+}
+
+// Load an index saved by save, checking it belongs to the same graph
+unique_ptr<ContractionHierarchy> ContractionHierarchy::load(const filesystem::path &file, const vector<Vertex *> &nodes) {
+    ifstream in(file, ios::binary);
+    if (!in.is_open()) return nullptr;
+
+    char magic[sizeof(CH_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, CH_MAGIC, sizeof(CH_MAGIC)) != 0) return nullptr;
+
+    unique_ptr<ContractionHierarchy> hierarchy(new ContractionHierarchy());
+    ContractionHierarchy &h = *hierarchy;
+    if (!readValue(in, h.n) || !readValue(in, h.shortcuts) || !readValue(in, h.checksum)) return nullptr;
+    if (h.n != (int) nodes.size() || h.checksum != edgesChecksum(nodes)) return nullptr;
+
+    h.rank.resize(h.n);
+    for (int &r : h.rank) {
+        if (!readValue(in, r) || r < 0 || r >= h.n) return nullptr;
+    }
+    h.upOffsets.resize(h.n + 1);
+    for (int &offset : h.upOffsets) {
+        if (!readValue(in, offset) || offset < 0) return nullptr;
+    }
+    if (h.upOffsets[0] != 0 || !is_sorted(h.upOffsets.begin(), h.upOffsets.end())) return nullptr;
+
+    // A truncated or corrupt file must not make us allocate more arcs than it holds
+    const streampos arcsStart = in.tellg();
+    in.seekg(0, ios::end);
+    const streamoff arcBytes = in.tellg() - arcsStart;
+    in.seekg(arcsStart);
+    if (!in || (uintmax_t) h.upOffsets[h.n] > (uintmax_t) arcBytes / (sizeof(Arc::target) + sizeof(Arc::weight) + sizeof(Arc::middle)))
+        return nullptr;
+
+    h.up.resize(h.upOffsets[h.n]);
+    for (Arc &arc : h.up) {
+        if (!readValue(in, arc.target) || !readValue(in, arc.weight) || !readValue(in, arc.middle)) return nullptr;
+        if (arc.target < 0 || arc.target >= h.n || arc.middle < -1 || arc.middle >= h.n) return nullptr;
+    }
+    return hierarchy;
+}
+
+/************************* Workspace  **************************/
+
+// Start a new query, invalidating every label at once
+void ContractionHierarchy::Workspace::start(int n) {
+    if ((int) labels[0].size() != n || ++query == 0) {
+        for (int direction = 0; direction < 2; ++direction) {
+            labels[direction].assign(n, Label());
+            stamps[direction].assign(n, 0);
+        }
+        query = 1;
+    }
+}
+
+// Label of a vertex in one search, reset if it was last touched by an earlier query
+ContractionHierarchy::Label &ContractionHierarchy::Workspace::label(int direction, int index) {
+    Label &label = labels[direction][index];
+    if (stamps[direction][index] != query) {
+        stamps[direction][index] = query;
+        label = Label();
+        label.index = index;
+    }
+    return label;
+}
+
+// Check if a vertex was reached by one search of the current query
+bool ContractionHierarchy::Workspace::touched(int direction, int index) const {
+    return stamps[direction][index] == query;
+}
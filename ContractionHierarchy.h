@@ -0,0 +1,250 @@
+#ifndef FEUP_DA_PROJECT_2_CONTRACTION_HIERARCHY_H
+#define FEUP_DA_PROJECT_2_CONTRACTION_HIERARCHY_H
+
+#include "Graph.h"
+
+#include <memory>
+#include <filesystem>
+#include <functional>
+
+/************************* ContractionHierarchy  **************************/
+
+/**
+ * @brief Contraction hierarchy index for fast shortest-path distance queries on a road network.
+ *
+ * @details Preprocessing contracts the vertices one by one, least important first (by edge difference plus the
+ * number of neighbours already contracted, updated lazily). Contracting v adds a shortcut u - w, through v,
+ * for every pair of remaining neighbours whose shortest path may use v, that is, unless a local witness search
+ * finds a path at most as short that avoids it. Every edge and shortcut is then kept only at its lower ranked
+ * end, pointing upwards, and a query is a bidirectional Dijkstra that only goes up: the two searches meet at
+ * the highest vertex of the shortest path, after settling a few hundred vertices even on large road graphs.
+ * The index is built on a snapshot of the graph and works with vertex indices, the position of each vertex in
+ * the vector given at construction (sorted by id). It supports undirected graphs only, where every edge has a
+ * reverse edge of the same weight. Queries are safe to run from several threads, each with its own Workspace.
+ */
+class ContractionHierarchy {
+    /**
+     * @brief Per-query Dijkstra state of a vertex.
+     */
+    struct Label {
+        double dist = numeric_limits<double>::max();
+        int index = 0;
+        int parentArc = -1; // upward arc the search reached this vertex by
+        int parent = -1;    // vertex that arc belongs to
+        int queueIndex = 0; // required by MutablePriorityQueue
+
+        bool operator<(const Label &other) const { return dist < other.dist; }
+    };
+
+    /**
+     * @brief An edge or shortcut; middle is the contracted vertex a shortcut goes through, -1 for an edge.
+     */
+    struct Arc {
+        int target;
+        double weight;
+        int middle;
+    };
+
+public:
+    /**
+     * @brief Reusable state of queries, with labels reset lazily by query stamps. Must not be shared by threads.
+     */
+    class Workspace {
+        friend class ContractionHierarchy;
+        vector<Label> labels[2];        // upward search from the source and from the target
+        vector<unsigned int> stamps[2];
+        unsigned int query = 0;
+
+        void start(int n);
+        Label &label(int direction, int index);
+        bool touched(int direction, int index) const;
+    };
+
+    /**
+     * @brief Builds the contraction hierarchy of a set of vertices.
+     *
+     * @details Only edges between vertices of the set are considered.
+     *
+     * @param nodes The vertices, sorted by id.
+     *
+     * @throws std::runtime_error If some edge has no reverse edge with the same weight.
+     *
+     * @complexity Depends on the graph; roughly O(|V| log |V|) witness searches of bounded size on road
+     * networks, which contract into few shortcuts.
+     */
+    explicit ContractionHierarchy(const vector<Vertex *> &nodes);
+
+    /**
+     * @brief Returns the number of vertices of the index.
+     *
+     * @return The number of vertices.
+     */
+    int size() const;
+
+    /**
+     * @brief Estimates the heap bytes of the index: its ranks and upward arcs.
+     *
+     * @return The bytes (see Memory).
+     *
+     * @complexity O(1).
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Returns the number of shortcuts added by the preprocessing.
+     *
+     * @return The number of shortcuts.
+     */
+    int shortcutCount() const;
+
+    /**
+     * @brief Shortest-path distance between two vertices.
+     *
+     * @param source The index of the source vertex.
+     * @param target The index of the target vertex.
+     * @param workspace The workspace of the calling thread.
+     *
+     * @return The distance, or infinity (numeric_limits<double>::max()) if target cannot be reached.
+     *
+     * @complexity O(s log s), s being the size of the upward search spaces, which is small on road networks.
+     */
+    double distance(int source, int target, Workspace &workspace) const;
+
+    /**
+     * @brief Visits the vertices of a shortest path between two vertices, in order.
+     *
+     * @details The path found by the query is made of upward arcs, and every shortcut is unpacked into the two
+     * arcs it replaces, recursively (with an explicit stack), until only original edges are left. Vertices are
+     * handed to visit as soon as they are known, so the path is never held in memory.
+     *
+     * @param source The index of the source vertex.
+     * @param target The index of the target vertex.
+     * @param workspace The workspace of the calling thread.
+     * @param visit Called with the index of every vertex of the path after source, target included.
+     *
+     * @return True if target can be reached, false otherwise (and visit is not called).
+     *
+     * @complexity O(s log s + p), s being as in distance and p the number of vertices of the path.
+     */
+    bool path(int source, int target, Workspace &workspace, const function<void(int)> &visit) const;
+
+    /**
+     * @brief Shortest-path distances between every source and every target (many-to-many table).
+     *
+     * @details The upward search space of every target is computed once and stored in per-vertex buckets;
+     * the upward search of each source then reads the buckets of the vertices it reaches. This is much
+     * cheaper than |sources| x |targets| separate queries when building a distance matrix over a subset of
+     * vertices.
+     *
+     * @param sources The indices of the source vertices.
+     * @param targets The indices of the target vertices.
+     *
+     * @return The row-major |sources| x |targets| table; unreachable pairs are infinity.
+     *
+     * @complexity O((|sources| + |targets|) s log s + |sources| |targets|), s being as in distance.
+     */
+    vector<double> table(const vector<int> &sources, const vector<int> &targets) const;
+
+    /**
+     * @brief Saves the index to a binary file.
+     *
+     * @param file The path of the file.
+     *
+     * @throws std::runtime_error If the file cannot be written.
+     */
+    void save(const filesystem::path &file) const;
+
+    /**
+     * @brief Loads an index saved by save, if it was built from the same graph.
+     *
+     * @details The file stores the ids of the vertices and a checksum of the edges it was built from, which
+     * must match the given vertices. The counts it stores are checked against the given vertices and the size of
+     * the file before anything is allocated for them, so a truncated or corrupt file is only rejected.
+     *
+     * @param file The path of the file.
+     * @param nodes The vertices, sorted by id.
+     *
+     * @return The index, or nullptr if the file cannot be read or belongs to another graph.
+     *
+     * @complexity O(|V| + |E|).
+     */
+    static unique_ptr<ContractionHierarchy> load(const filesystem::path &file, const vector<Vertex *> &nodes);
+
+private:
+    int n = 0;
+    int shortcuts = 0;
+    uint64_t checksum = 0;              // of the edges the index was built from
+    vector<int> rank;                   // contraction order
+    vector<int> upOffsets;              // arcs of vertex i towards higher ranks: up[upOffsets[i], upOffsets[i + 1])
+    vector<Arc> up;
+
+    /**
+     * @brief Constructs an empty index, filled by load.
+     */
+    ContractionHierarchy() = default;
+
+    /**
+     * @brief Computes the checksum that ties an index to the edges of a graph.
+     *
+     * @param nodes The vertices, sorted by id.
+     *
+     * @return The checksum.
+     */
+    static uint64_t edgesChecksum(const vector<Vertex *> &nodes);
+
+    /**
+     * @brief Bidirectional upward search between two vertices.
+     *
+     * @param source The index of the source vertex.
+     * @param target The index of the target vertex.
+     * @param workspace The workspace of the calling thread; its labels keep the arcs the searches used.
+     * @param meeting If not null, receives the vertex where the two searches meet on the shortest path.
+     *
+     * @return The distance, or infinity if target cannot be reached.
+     */
+    double search(int source, int target, Workspace &workspace, int *meeting) const;
+
+    /**
+     * @brief Finds the upward arc between two vertices.
+     *
+     * @param low The lower ranked vertex, which holds the arc.
+     * @param high The higher ranked vertex.
+     *
+     * @return The index of the arc in up, or -1 if there is none.
+     */
+    int findArc(int low, int high) const;
+
+    /**
+     * @brief Visits the vertices of an arc after from, unpacking it if it is a shortcut.
+     *
+     * @param from The vertex the arc is traversed from.
+     * @param to The vertex the arc is traversed to.
+     * @param arc The index of the arc in up.
+     * @param visit Called with every vertex after from, to included.
+     */
+    void unpack(int from, int to, int arc, const function<void(int)> &visit) const;
+
+    /**
+     * @brief Checks whether a vertex settled by an upward search can be skipped (stall-on-demand).
+     *
+     * @param u The label of the settled vertex.
+     * @param direction Which of the two searches of the workspace settled it.
+     * @param workspace The workspace of the search.
+     *
+     * @return True if some higher ranked vertex reached by the search gives u a shorter distance than its label.
+     */
+    bool stalled(const Label &u, int direction, const Workspace &workspace) const;
+
+    /**
+     * @brief Runs an upward search to completion, calling visit on every vertex it settles.
+     *
+     * @param source The index of the vertex the search starts from.
+     * @param direction Which of the two searches of the workspace to use.
+     * @param workspace The workspace of the calling thread.
+     * @param visit Called with the index and distance of every settled vertex that is not stalled.
+     */
+    template <class Visit>
+    void upwardSearch(int source, int direction, Workspace &workspace, Visit visit) const;
+};
+
+#endif //FEUP_DA_PROJECT_2_CONTRACTION_HIERARCHY_H
@@ -1,8 +1,32 @@
 #include <set>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
 #include "Data.h"
+#include "MetricClosure.h"
+#include "ContractionHierarchy.h"
 
-// Constructor
-Data::Data() = default;
+// Constructor: a thread pool as large as the hardware allows
+Data::Data() : pool(make_unique<ThreadPool>()) {
+    g.setThreadPool(pool.get());
+}
+
+// Replace the thread pool with one of the given size
+void Data::setThreads(unsigned int threads) {
+    if (isGraphLoaded()) throw runtime_error("The threads must be set before the graph is loaded.");
+    g.setThreadPool(nullptr);
+    pool = make_unique<ThreadPool>(threads);
+    g.setThreadPool(pool.get());
+}
+
+// Set the priority queue of prim and of the metric closure
+void Data::setHeap(const string &name) {
+    if (isGraphLoaded()) throw runtime_error("The heap must be set before the graph is loaded.");
+    const vector<string> &names = heapNames();
+    auto it = find(names.begin(), names.end(), name);
+    if (it == names.end()) throw runtime_error("Unknown heap: " + name + ".");
+    g.setHeap((HeapKind) (it - names.begin()));
+}
 
 // Check if the graph is loaded
 bool Data::isGraphLoaded() {
@@ -19,28 +43,125 @@ void Data::setNodesFilePath(const filesystem::path &file_path) {
     nodesFilePath = file_path; // Assign the provided file path to nodesFilePath
 }
 
+// Set the folder where large contraction hierarchies are saved
+void Data::setIndexCacheFolder(const filesystem::path &folder) {
+    indexCacheFolder = folder;
+}
+
 // Read files and populate graph
 void Data::readFiles() {
     try {
         if(edgesFilePath.empty()) throw runtime_error("Invalid input. Some files are missing in the given path."); // Throw exception if edges file path is empty
 
-        if(!nodesFilePath.empty()) {
-            ifstream nodesFile(nodesFilePath);
-            if (!nodesFile.is_open()) throw runtime_error("Error opening the nodes file."); // Throw exception if nodes file cannot be opened
+        {
+            Instrumentation::PhaseTimer timer(Instrumentation::LOAD);
+            if(!nodesFilePath.empty()) {
+                ifstream nodesFile(nodesFilePath);
+                if (!nodesFile.is_open()) throw runtime_error("Error opening the nodes file."); // Throw exception if nodes file cannot be opened
+
+                readNodesFile(nodesFile); // Read nodes file
+            }
 
-            readNodesFile(nodesFile); // Read nodes file
+            ifstream edgesFile(edgesFilePath);
+            if (!edgesFile.is_open()) throw runtime_error("Error opening the edges file."); // Throw exception if edges file cannot be opened
+
+            readEdgesFile(edgesFile); // Read edges file
         }
 
-        ifstream edgesFile(edgesFilePath);
-        if (!edgesFile.is_open()) throw runtime_error("Error opening the edges file."); // Throw exception if edges file cannot be opened
+        Instrumentation::PhaseTimer timer(Instrumentation::PREPROCESSING);
+        analysis = g.analyse(); // Find out which tours cannot exist, in linear time
 
-        readEdgesFile(edgesFile); // Read edges file
+        buildContractionHierarchy(); // Build the distance index of large road networks
 
     } catch (const exception& e) {
         throw; // Rethrow any caught exceptions
     }
 }
 
+// Get the structural analysis of the graph
+const GraphAnalysis &Data::getAnalysis() const {
+    return analysis;
+}
+
+// Report the memory of the graph, its indexes and analysis, and of the process
+Memory::Report Data::memoryReport() const {
+    Memory::Report report;
+    g.memoryUsage(report);
+    report.analysis = Memory::vectorBytes(analysis.lowDegreeVertices) + Memory::vectorBytes(analysis.articulationPoints)
+            + Memory::vectorBytes(analysis.bridges);
+    Memory::measureProcess(report);
+    return report;
+}
+
+// Get the weight of a minimum spanning tree, when it bounds the cost of every tour
+double Data::lowerBound() const {
+    if (analysis.components != 1) return numeric_limits<double>::quiet_NaN();
+    bool complete = true, coordinates = false;
+    for (auto &pair : g.getVertexSet()) {
+        Vertex *v = pair.second;
+        if ((int) v->getAdj().size() < analysis.vertices - 1) complete = false;
+        if (v->getLongitude() != numeric_limits<double>::max() && v->getLatitude() != numeric_limits<double>::max())
+            coordinates = true;
+    }
+    if (!complete && coordinates) return numeric_limits<double>::quiet_NaN();
+    return g.spanningTreeWeight();
+}
+
+// Refuse to run an algorithm that cannot succeed, explaining why
+bool Data::refuse(const string &obstacle) {
+    if (obstacle.empty()) return false;
+    printFailure(obstacle);
+    return true;
+}
+
+// Print that there is no solution, and why
+void Data::printFailure(const string &reason) {
+    cout << "\033[31m";
+    cout << endl;
+    cout << "There is no possible solution! " << reason << endl << endl; // Output the reason
+    cout << "\033[0m";
+}
+
+// Print a note when the run was stopped before the algorithm finished
+void Data::printStopped(const SolveControl *control) {
+    if (control && control->stopped()) cout << "Stopped early: this is the best tour found in time." << endl;
+}
+
+// Build (or load) the contraction hierarchy of large sparse graphs
+void Data::buildContractionHierarchy() {
+    vector<Vertex *> nodes;
+    size_t edges = 0;
+    for (auto &pair : g.getVertexSet()) {
+        nodes.push_back(pair.second);
+        edges += pair.second->getAdj().size();
+    }
+    if (nodes.size() <= MetricClosure::DENSE_LIMIT || (double) edges / nodes.size() > CH_MAX_AVERAGE_DEGREE) return;
+    sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+
+    filesystem::path indexFilePath = indexCacheFolder / (edgesFilePath.filename().string() + ".ch");
+    bool save = !indexCacheFolder.empty() && nodes.size() >= CH_SAVE_MIN_VERTICES;
+
+    // The index is optional: on failure, distance queries fall back to searches on the graph itself
+    unique_ptr<ContractionHierarchy> hierarchy;
+    if (save) hierarchy = ContractionHierarchy::load(indexFilePath, nodes); // Reuse the saved index if it matches
+    if (!hierarchy) {
+        try {
+            hierarchy = make_unique<ContractionHierarchy>(nodes);
+        } catch (const runtime_error &) {
+            return; // Directed graph
+        }
+        try {
+            if (save) {
+                filesystem::create_directories(indexCacheFolder);
+                hierarchy->save(indexFilePath);
+            }
+        } catch (const exception &) {
+            // Not saved; it will be built again next time
+        }
+    }
+    g.setContractionHierarchy(std::move(hierarchy));
+}
+
 // Read edges file and populate graph
 void Data::readEdgesFile(ifstream &file) {
     string line;
@@ -123,56 +244,448 @@ bool Data::vertexExists(int id) {
 }
 
 // Perform TSP using backtracking algorithm
-void Data::TSPBacktracking() {
-
-    for(auto pair : g.getVertexSet()) {
-        pair.second->setVisited(false); // Reset visited flag for all vertices
-    }
+void Data::TSPBacktracking(SolveControl *control) {
 
-    double res = numeric_limits<double>::max();
-    Vertex *v = g.findVertex(0);
-    v->setVisited(true); // Mark the starting vertex as visited
+    if (refuse(analysis.hamiltonianCycleObstacle())) return;
+    if (refuse(g.findVertex(0) ? "" : "There is no vertex with id 0.")) return;
 
-    g.TSPBacktracking(v, 0, 1, 0, res); // Perform TSP using backtracking
+    double res = 0;
+    vector<Vertex *> tour;
+    try {
+        g.TSPBacktracking(res, tour, 0, control); // Perform TSP using backtracking, keeping the best cycle
+    } catch (const exception &e) {
+        printFailure(e.what());
+        return;
+    }
 
     cout << endl;
     cout << "TSP Backtracking result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
 }
 
 // Perform TSP using triangular approximation algorithm
-void Data::TSPTriangular() {
+void Data::TSPTriangular(SolveControl *control) {
+
+    if (refuse(analysis.distanceObstacle())) return;
 
     double res = 0;
-    g.TSPTriangular(res); // Perform TSP using triangular approximation
+    vector<Vertex *> tour;
+    try {
+        g.TSPTriangular(res, tour, control); // Perform TSP using triangular approximation
+    } catch (const exception &e) {
+        printFailure(e.what()); // Stopped before the tour was complete
+        return;
+    }
 
     cout << endl;
     cout << "TSP Triangular approximation result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
 }
 
 // Perform TSP using nearest neighbor algorithm
-void Data::TSPNearestNeighbor() {
+void Data::TSPNearestNeighbor(SolveControl *control) {
+
+    if (refuse(analysis.distanceObstacle())) return;
 
     double res = 0;
-    g.TSPNearestNeighbor(res); // Perform TSP using nearest neighbor
+    vector<Vertex *> tour;
+    try {
+        g.TSPNearestNeighbor(res, tour, control); // Perform TSP using nearest neighbor
+    } catch (const exception &e) {
+        printFailure(e.what()); // Stopped before the tour was complete
+        return;
+    }
 
     cout << endl;
     cout << "TSP Nearest Neighbor result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
+}
+
+// Perform TSP using parallel simulated annealing
+void Data::TSPSimulatedAnnealing(double timeBudget, SolveControl *control) {
+
+    if (refuse(analysis.distanceObstacle())) return;
+
+    double res = 0;
+    vector<Vertex *> tour;
+    g.TSPSimulatedAnnealing(res, tour, 0, timeBudget, control); // Perform TSP using one replica per hardware thread
+
+    cout << endl;
+    cout << "TSP Simulated Annealing result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
+}
+
+// Perform TSP using an island model genetic algorithm
+void Data::TSPGeneticAlgorithm(double timeBudget, SolveControl *control) {
+
+    if (refuse(analysis.distanceObstacle())) return;
+
+    double res = 0;
+    vector<Vertex *> tour;
+    g.TSPGeneticAlgorithm(res, tour, 0, timeBudget, control); // Perform TSP using one island per hardware thread
+
+    cout << endl;
+    cout << "TSP Genetic Algorithm result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
+}
+
+// Perform TSP using ant colony optimization
+void Data::TSPAntColony(int startingVertexId, double timeBudget, SolveControl *control) {
+
+    if (refuse(analysis.hamiltonianCycleObstacle())) return;
+
+    try {
+        double res = 0;
+        vector<Vertex *> tour;
+        g.TSPAntColony(res, tour, startingVertexId, 0, timeBudget, control); // Perform TSP using one thread per hardware thread
+
+        cout << "Starting vertex id: " << startingVertexId << endl;
+        cout << endl;
+        cout << "TSP Ant Colony result: " << setprecision(1) << res << endl; // Output result
+        printStopped(control);
+    } catch (const exception &e) {
+        printFailure(e.what()); // Output the reason no solution was found
+    }
+}
+
+// Perform TSP using a Hilbert space-filling curve
+void Data::TSPSpaceFillingCurve(SolveControl *control) {
+
+    double res = 0;
+    vector<Vertex *> tour;
+    try {
+        g.TSPSpaceFillingCurve(res, tour, control); // Perform TSP following the Hilbert curve
+    } catch (const exception &e) {
+        printFailure(e.what()); // Stopped before the tour was complete
+        return;
+    }
+
+    cout << endl;
+    cout << "TSP Space-Filling Curve result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
+}
+
+// Perform TSP using the greedy edge heuristic
+void Data::TSPGreedyEdge(SolveControl *control) {
+
+    if (refuse(analysis.distanceObstacle())) return;
+
+    double res = 0;
+    vector<Vertex *> tour;
+    try {
+        g.TSPGreedyEdge(res, tour, control); // Perform TSP taking the lightest candidate edges first
+    } catch (const exception &e) {
+        printFailure(e.what()); // Stopped before the tour was complete
+        return;
+    }
+
+    cout << endl;
+    cout << "TSP Greedy Edge result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
+}
+
+// Perform TSP using the Clarke-Wright savings heuristic
+void Data::TSPSavings(SolveControl *control) {
+
+    if (refuse(analysis.distanceObstacle())) return;
+
+    double res = 0;
+    vector<Vertex *> tour;
+    try {
+        g.TSPSavings(res, tour, control); // Perform TSP merging routes by largest saving
+    } catch (const exception &e) {
+        printFailure(e.what()); // Stopped before the tour was complete
+        return;
+    }
+
+    cout << endl;
+    cout << "TSP Savings result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
+}
+
+// Perform TSP using the cheapest insertion heuristic
+void Data::TSPCheapestInsertion(SolveControl *control) {
+
+    if (refuse(analysis.distanceObstacle())) return;
+
+    double res = 0;
+    vector<Vertex *> tour;
+    try {
+        g.TSPCheapestInsertion(res, tour, control); // Perform TSP inserting the cheapest vertex first
+    } catch (const exception &e) {
+        printFailure(e.what()); // Stopped before the tour was complete
+        return;
+    }
+
+    cout << endl;
+    cout << "TSP Cheapest Insertion result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
+}
+
+// Perform TSP using the farthest insertion heuristic
+void Data::TSPFarthestInsertion(SolveControl *control) {
+
+    if (refuse(analysis.distanceObstacle())) return;
+
+    double res = 0;
+    vector<Vertex *> tour;
+    try {
+        g.TSPFarthestInsertion(res, tour, control); // Perform TSP inserting the farthest vertex first
+    } catch (const exception &e) {
+        printFailure(e.what()); // Stopped before the tour was complete
+        return;
+    }
+
+    cout << endl;
+    cout << "TSP Farthest Insertion result: " << setprecision(1) << res << endl; // Output result
+    printStopped(control);
 }
 
 // Perform TSP using real-world nearest neighbor algorithm
-void Data::TSPRealWorldNearestNeighbor(int startingVertexId) {
+void Data::TSPRealWorldNearestNeighbor(int startingVertexId, const filesystem::path &routeFilePath, SolveControl *control) {
+
+    if (refuse(analysis.closedWalkObstacle())) return;
 
+    // Open the route file first, so that a bad path does not throw away the run
+    ofstream routeFile;
+    if (!routeFilePath.empty()) {
+        routeFile.open(routeFilePath);
+        if (!routeFile.is_open()) {
+            cout << "\033[31m" << "Error opening the route file." << "\033[0m" << endl;
+            return;
+        }
+    }
+
+    vector<Vertex *> tour;
     try {
         double res = 0;
-        g.TSPRealWorldNearestNeighbor(res, startingVertexId); // Perform TSP using real-world nearest neighbor
+        g.TSPRealWorldNearestNeighbor(res, tour, startingVertexId, control); // Perform TSP using real-world nearest neighbor
 
         cout << "Starting vertex id: " << startingVertexId << endl;
         cout << endl;
         cout << "TSP Real World Nearest Neighbor result: " << setprecision(1) << res << endl; // Output result
-    } catch (...) {
-        cout << "\033[31m";
+    } catch (const exception &e) {
+        printFailure(e.what()); // Output the reason no solution was found
+        return;
+    }
+
+    // Stream the route, with every leg expanded into its road vertices, to the route file
+    if (routeFilePath.empty()) return;
+    routeFile << "id\n";
+    g.expandTour(tour, [&routeFile](Vertex *v) { routeFile << v->getId() << '\n'; });
+    cout << "Route written to: " << routeFilePath.string() << endl;
+}
+
+// Race several algorithms on the graph and print the best tour and its finder
+void Data::TSPPortfolio(double timeBudget, SolveControl *control) {
+    PortfolioRun race = solvePortfolio(0, timeBudget, 0, control);
+
+    ios state(nullptr);
+    state.copyfmt(cout);
+    cout << endl;
+    for (const TSPRun &run : race.entrants) {
+        cout << "  " << left << setw(20) << run.algorithm << right;
+        if (run.solved) cout << fixed << setprecision(1) << run.cost << " in " << setprecision(2) << run.seconds << "s";
+        else cout << "no tour: " << run.error;
         cout << endl;
-        cout << "There is no possible solution!" << endl << endl; // Output error message if no solution found
-        cout << "\033[0m";
     }
+    cout.copyfmt(state);
+    if (race.winner < 0) {
+        printFailure("No entrant found a tour.");
+        return;
+    }
+
+    cout << endl;
+    cout << "TSP Portfolio result: " << setprecision(1) << race.entrants[race.winner].cost << endl; // Output result
+    cout << "Found by: " << race.entrants[race.winner].algorithm << (race.optimal ? " (proven optimal)" : "") << endl;
+    printStopped(control);
+}
+
+// Names of the algorithms accepted by solve
+const vector<string> &Data::algorithmNames() {
+    static const vector<string> names = {
+            "backtracking", "triangular", "nearest-neighbor", "simulated-annealing", "genetic-algorithm",
+            "ant-colony", "space-filling-curve", "greedy-edge", "cheapest-insertion", "farthest-insertion",
+            "savings", "real-world-nearest-neighbor"
+    };
+    return names;
+}
+
+// Get the names of the priority queues, in the order of HeapKind
+const vector<string> &Data::heapNames() {
+    static const vector<string> names = {"default", "binary", "4-ary", "pairing", "radix"};
+    return names;
+}
+
+// Tell if the named algorithm starts from the starting vertex
+bool Data::usesStartingVertex(const string &algorithm) {
+    return algorithm == "backtracking" || algorithm == "ant-colony" || algorithm == "real-world-nearest-neighbor";
+}
+
+// Set whether solve reads the CPU performance counters
+void Data::setHardwareCounters(bool enabled) {
+    hardwareCounters = enabled;
+}
+
+// Explain why the named algorithm cannot succeed on the graph, if it cannot
+string Data::obstacle(const string &algorithm) const {
+    if (algorithm == "backtracking" || algorithm == "ant-colony") return analysis.hamiltonianCycleObstacle();
+    if (algorithm == "real-world-nearest-neighbor") return analysis.closedWalkObstacle();
+    if (algorithm != "space-filling-curve") return analysis.distanceObstacle();
+    return "";
+}
+
+// Run the named algorithm on the graph
+void Data::runAlgorithm(const string &algorithm, int startingVertexId, double timeBudget, unsigned int threads,
+                        SolveControl *control, double &res, vector<Vertex *> &tour) {
+    if (algorithm == "backtracking") g.TSPBacktracking(res, tour, startingVertexId, control);
+    else if (algorithm == "triangular") g.TSPTriangular(res, tour, control);
+    else if (algorithm == "nearest-neighbor") g.TSPNearestNeighbor(res, tour, control);
+    else if (algorithm == "simulated-annealing") g.TSPSimulatedAnnealing(res, tour, threads, timeBudget, control);
+    else if (algorithm == "genetic-algorithm") g.TSPGeneticAlgorithm(res, tour, threads, timeBudget, control);
+    else if (algorithm == "ant-colony") g.TSPAntColony(res, tour, startingVertexId, threads, timeBudget, control);
+    else if (algorithm == "space-filling-curve") g.TSPSpaceFillingCurve(res, tour, control);
+    else if (algorithm == "greedy-edge") g.TSPGreedyEdge(res, tour, control);
+    else if (algorithm == "cheapest-insertion") g.TSPCheapestInsertion(res, tour, control);
+    else if (algorithm == "farthest-insertion") g.TSPFarthestInsertion(res, tour, control);
+    else if (algorithm == "savings") g.TSPSavings(res, tour, control);
+    else g.TSPRealWorldNearestNeighbor(res, tour, startingVertexId, control);
+}
+
+// Solve the TSP with the named algorithm, returning the result instead of printing it
+TSPRun Data::solve(const string &algorithm, int startingVertexId, double timeBudget, unsigned int threads,
+                   SolveControl *control) {
+    const vector<string> &names = algorithmNames();
+    if (find(names.begin(), names.end(), algorithm) == names.end())
+        throw runtime_error("Unknown algorithm: " + algorithm);
+
+    TSPRun run;
+    run.algorithm = algorithm;
+
+    // Refuse the graphs on which the algorithm cannot succeed, like the interactive methods
+    run.error = obstacle(algorithm);
+    if (!run.error.empty()) return run;
+
+    double res = 0;
+    vector<Vertex *> tour;
+    Instrumentation::reset();
+    Memory::resetPeaks();
+    unique_ptr<HardwareCounters> counters;
+    if (hardwareCounters) {
+        counters = make_unique<HardwareCounters>(pool->threadIds());
+        counters->start();
+    }
+    auto start = chrono::steady_clock::now();
+    Instrumentation::TraceSpan span(algorithm.c_str());
+    try {
+        runAlgorithm(algorithm, startingVertexId, timeBudget, threads, control, res, tour);
+        run.solved = true;
+        run.cost = res;
+    } catch (const exception &e) {
+        run.error = e.what();
+    }
+    run.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    run.stopped = control && control->shouldStopNow(); // the metaheuristics end on their own at the deadline
+    if (counters) run.hardware = counters->stop();
+    run.profile = Instrumentation::snapshot();
+    run.memory = memoryReport();
+
+    for (Vertex *v : tour) run.tour.push_back(v->getId());
+    return run;
+}
+
+// Names of the algorithms raced by solvePortfolio on this graph
+vector<string> Data::portfolioEntrants() const {
+    vector<string> entrants;
+    if ((size_t) analysis.vertices <= EXACT_MAX_VERTICES) entrants.emplace_back("backtracking");
+    entrants.insert(entrants.end(), {"triangular", "nearest-neighbor", "greedy-edge", "savings", "simulated-annealing"});
+    return entrants;
+}
+
+// Race several algorithms on the graph, one thread each, keeping the cheapest tour
+PortfolioRun Data::solvePortfolio(int startingVertexId, double timeBudget, unsigned int threads, SolveControl *control) {
+    PortfolioRun race;
+    const vector<string> entrants = portfolioEntrants();
+    race.entrants.resize(entrants.size());
+
+    // The entrants share a control of their own, so that cancelling the losers leaves the caller's control alone
+    SolveControl shared(control ? control->remaining() : numeric_limits<double>::infinity());
+    if (control) shared.setProgress([control](double cost, const vector<Vertex *> &tour, double) { control->improve(cost, tour); });
+
+    // The simulated annealing gets a replica per thread left by the other entrants
+    const unsigned int cores = threads ? threads : pool->size();
+    const unsigned int others = (unsigned int) entrants.size() - 1;
+    const unsigned int replicas = cores > others ? cores - others : 1;
+
+    Instrumentation::reset();
+    Memory::resetPeaks();
+    unique_ptr<HardwareCounters> counters;
+    if (hardwareCounters) {
+        counters = make_unique<HardwareCounters>(pool->threadIds());
+        counters->start();
+    }
+    auto start = chrono::steady_clock::now();
+    Instrumentation::TraceSpan span("portfolio");
+
+    mutex finishedMutex;
+    condition_variable finishedChanged;
+    size_t finished = 0;
+    vector<thread> workers;
+    for (size_t i = 0; i < entrants.size(); i++) {
+        workers.emplace_back([&, i]() {
+            TSPRun &run = race.entrants[i];
+            run.algorithm = entrants[i];
+            run.error = obstacle(run.algorithm);
+            if (run.error.empty()) {
+                // Tracks after those of the pool workers
+                Instrumentation::TraceSpan entrant(run.algorithm.c_str(), (int) (pool->size() - 1 + i));
+                double res = 0;
+                vector<Vertex *> tour;
+                try {
+                    runAlgorithm(run.algorithm, startingVertexId, timeBudget, replicas, &shared, res, tour);
+                    run.solved = true;
+                    run.cost = res;
+                } catch (const exception &e) {
+                    run.error = e.what();
+                }
+                run.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                run.stopped = shared.shouldStopNow();
+                for (Vertex *v : tour) run.tour.push_back(v->getId());
+
+                // A search run to the end has found the optimum: the others cannot beat it
+                if (run.algorithm == "backtracking" && run.solved && !run.stopped) {
+                    race.optimal = true;
+                    shared.cancel();
+                }
+            }
+            lock_guard<mutex> lock(finishedMutex);
+            finished++;
+            finishedChanged.notify_one();
+        });
+    }
+
+    // Wait for the entrants, passing on the cancellation or the deadline of the caller's control
+    {
+        unique_lock<mutex> lock(finishedMutex);
+        while (!finishedChanged.wait_for(lock, chrono::milliseconds(20), [&]() { return finished == workers.size(); })) {
+            if (control && control->shouldStopNow()) shared.cancel();
+        }
+    }
+    for (thread &worker : workers) worker.join();
+    race.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    HardwareCounters::Reading hardware;
+    if (counters) hardware = counters->stop();
+    Instrumentation::Snapshot profile = Instrumentation::snapshot();
+    Memory::Report memory = memoryReport();
+    for (size_t i = 0; i < race.entrants.size(); i++) {
+        TSPRun &run = race.entrants[i];
+        run.hardware = hardware;
+        run.profile = profile;
+        run.memory = memory;
+        if (!run.solved) continue;
+        const TSPRun *best = race.winner < 0 ? nullptr : &race.entrants[race.winner];
+        if (!best || run.cost < best->cost || (run.cost == best->cost && run.seconds < best->seconds)) race.winner = (int) i;
+    }
+    return race;
 }
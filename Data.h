@@ -13,6 +13,34 @@ using namespace std;
 #include <limits>
 #include <cmath>
 #include "Graph.h"
+#include "HardwareCounters.h"
+
+/**
+ * @brief The outcome of one run of a TSP algorithm, as returned by Data::solve.
+ */
+struct TSPRun {
+    string algorithm;
+    bool solved = false;
+    double cost = 0;
+    vector<int> tour;           // vertex ids in visiting order, starting vertex first and not repeated at the end
+    string error;               // why there is no tour, when solved is false
+    double seconds = 0;         // wall-clock time of the algorithm alone
+    Instrumentation::Snapshot profile;  // phase times and counters of the run
+    HardwareCounters::Reading hardware; // CPU counters of the run, when enabled (see Data::setHardwareCounters)
+    Memory::Report memory;      // structures after the run, and the peak memory of the process during it
+    bool stopped = false;       // whether the run was cancelled or ended at its deadline, rather than on its own
+};
+
+/**
+ * @brief The outcome of a race of several TSP algorithms on the same graph, as returned by Data::solvePortfolio.
+ */
+struct PortfolioRun {
+    vector<TSPRun> entrants;    // one run per algorithm raced; seconds count from the start of the race, and the
+                                // profile, hardware counts and memory, shared by the threads, cover the whole race
+    int winner = -1;            // index of the entrant with the cheapest tour, -1 if none found one
+    bool optimal = false;       // whether the winner's tour is proven optimal, by a backtracking search run to the end
+    double seconds = 0;         // wall-clock time of the race
+};
 
 /**
  * @brief Class that saves all the program data.
@@ -22,8 +50,105 @@ class Data {
 private:
     filesystem::path edgesFilePath;
     filesystem::path nodesFilePath;
+    filesystem::path indexCacheFolder;  // where large contraction hierarchies are saved, empty for nowhere
+    unique_ptr<ThreadPool> pool;    // runs the parallel algorithms of g, see setThreads
     Graph g;
+    GraphAnalysis analysis;     // computed on load, see readFiles
+    bool hardwareCounters = false;  // whether solve reads the CPU performance counters
+
+    /**
+    * @brief Largest average number of edges per vertex for which the contraction hierarchy is built.
+    */
+    static constexpr double CH_MAX_AVERAGE_DEGREE = 16;
+
+    /**
+    * @brief Smallest number of vertices for which the contraction hierarchy is saved to disk.
+    */
+    static constexpr size_t CH_SAVE_MIN_VERTICES = 100000;
+
+    /**
+    * @brief Explains why an algorithm cannot succeed on the loaded graph, like the interactive methods refuse it.
+    *
+    * @param algorithm One of algorithmNames.
+    *
+    * @return The reason, from the GraphAnalysis of the graph, or an empty string if there is none.
+    */
+    string obstacle(const string &algorithm) const;
+
+    /**
+    * @brief Runs the named algorithm on the graph, for solve and solvePortfolio.
+    *
+    * @param algorithm One of algorithmNames.
+    * @param startingVertexId See solve.
+    * @param timeBudget See solve.
+    * @param threads See solve.
+    * @param control Optional deadline, cancellation and progress (see SolveControl).
+    * @param res Reference to the variable to store the cost of the tour.
+    * @param tour Reference to the vector to store the vertices of the tour in visiting order.
+    *
+    * @throws std::runtime_error if the algorithm finds no tour.
+    */
+    void runAlgorithm(const string &algorithm, int startingVertexId, double timeBudget, unsigned int threads,
+                      SolveControl *control, double &res, vector<Vertex *> &tour);
+
+    /**
+    * @brief Builds the contraction hierarchy index of large road networks.
+    *
+    * @details The index is only useful where the metric closure is not a dense matrix, so it is built for
+    * graphs above MetricClosure::DENSE_LIMIT vertices whose average degree is at most CH_MAX_AVERAGE_DEGREE
+    * (complete graphs are skipped). When an index cache folder was set (see setIndexCacheFolder), the indexes of
+    * graphs of at least CH_SAVE_MIN_VERTICES vertices are saved there, named after the edges file with the ".ch"
+    * extension appended, and loaded from there on later runs, as long as the saved index still matches the graph.
+    * Failures (a directed graph, a read-only folder, a corrupt file) only leave the graph without the index, or
+    * build it again.
+    *
+    * @complexity See the ContractionHierarchy constructor; O(|V| + |E|) when the index is loaded.
+    */
+    void buildContractionHierarchy();
+
+    /**
+    * @brief Refuses to run an algorithm that provably cannot succeed on the loaded graph.
+    *
+    * @details Prints the same message as a failed run, followed by the reason, so that hopeless inputs are
+    * rejected at once instead of after a long search.
+    *
+    * @param obstacle The reason the algorithm cannot succeed, from the GraphAnalysis of the graph, or an
+    * empty string if there is none.
+    *
+    * @return True if the algorithm must not run.
+    *
+    * @complexity O(1).
+    */
+    static bool refuse(const string &obstacle);
+
+    /**
+    * @brief Prints that there is no possible solution, followed by the reason.
+    *
+    * @param reason Why the algorithm found no tour.
+    */
+    static void printFailure(const string &reason);
+
+    /**
+    * @brief Prints a note after a result when the run was stopped by its deadline or cancelled, so the tour
+    * printed is the best one found in time rather than the algorithm's final one.
+    *
+    * @param control The control of the run, or nullptr.
+    */
+    static void printStopped(const SolveControl *control);
 public:
+    /**
+    * @brief Largest number of vertices for which backtracking, which takes (|V| - 1)! steps, is run when it was
+    * not asked for by name: by the portfolio, by "--algorithm all" without a deadline and by tsp_bench.
+    */
+    static constexpr size_t EXACT_MAX_VERTICES = 12;
+
+    /**
+    * @brief Largest number of vertices for which the cheapest and farthest insertion heuristics, which compute
+    * Θ(|V|^2) edge weights, are run when they were not asked for by name: by "--algorithm all" and by tsp_bench
+    * without --algorithm. Around it they take seconds, where nearest neighbor and greedy edge take milliseconds.
+    */
+    static constexpr size_t INSERTION_MAX_VERTICES = 2000;
+
     /**
     * @brief Default constructor for the Data class.
     *
@@ -32,6 +157,34 @@ public:
     */
     Data();
 
+    /**
+    * @brief Sets the number of threads of the pool that runs the parallel algorithms (spanning trees, metric
+    * closure and metaheuristics).
+    *
+    * @details The pool starts with a thread per hardware thread. It is replaced, so set it before loading the
+    * graph, as the metric closure keeps the pool it was built with.
+    *
+    * @param threads The number of threads, the calling thread included. 0 uses the hardware concurrency.
+    *
+    * @throws std::runtime_error if the graph is already loaded.
+    *
+    * @complexity O(threads).
+    */
+    void setThreads(unsigned int threads);
+
+    /**
+    * @brief Sets the priority queue of Prim's algorithm and of the Dijkstra searches of the metric closure.
+    *
+    * @details See HeapKind and Graph::setHeap. Set it before loading the graph, like the threads.
+    *
+    * @param name One of heapNames.
+    *
+    * @throws std::runtime_error if the name is unknown or the graph is already loaded.
+    *
+    * @complexity O(1).
+    */
+    void setHeap(const string &name);
+
     /**
     * @brief Checks if the graph data is loaded.
     *
@@ -66,6 +219,18 @@ public:
     */
     void setNodesFilePath(const filesystem::path &file);
 
+    /**
+    * @brief Sets the folder where the contraction hierarchies of large road networks are saved and reused.
+    *
+    * @details See buildContractionHierarchy. Nothing is saved by default, so loading a graph never writes files.
+    * The folder is created when the first index is saved.
+    *
+    * @param folder The folder, or an empty path to save nothing.
+    *
+    * @complexity O(1).
+    */
+    void setIndexCacheFolder(const filesystem::path &folder);
+
     /**
     * @brief Reads files containing nodes and edges data.
     *
@@ -74,9 +239,47 @@ public:
     * appropriate exceptions are thrown.
     *
     * @throws std::runtime_error if there are issues with file paths or opening files.
+    *
+    * @note Once the files are read, the graph is analysed (see Graph::analyse) so that algorithms that cannot
+    * succeed on it are refused at once, and, for large road networks, the contraction hierarchy index is built
+    * (or loaded); see buildContractionHierarchy.
     */
     void readFiles();
 
+    /**
+    * @brief Returns the structural analysis of the loaded graph.
+    *
+    * @return The analysis computed by readFiles.
+    *
+    * @complexity O(1).
+    */
+    const GraphAnalysis &getAnalysis() const;
+
+    /**
+    * @brief Reports the memory of the loaded graph, its indexes and analysis, and of the process.
+    *
+    * @details See Memory for how the structures are accounted. The metric closure is built by the algorithms
+    * that need it, so it only shows up after one of them ran.
+    *
+    * @return The report.
+    *
+    * @complexity O(|V| + r), r being the number of rows cached by the metric closure.
+    */
+    Memory::Report memoryReport() const;
+
+    /**
+    * @brief Gets a lower bound on the cost of every tour of the loaded graph: the weight of its minimum spanning tree.
+    *
+    * @details See Graph::spanningTreeWeight. The bound only holds when every tour is made of edges of the graph or
+    * of shortest paths over them: on connected graphs that are complete or have no coordinates. Elsewhere, a
+    * distance measured by coordinates may be shorter than any path, and there is no bound.
+    *
+    * @return The bound, or NaN if the graph has none.
+    *
+    * @complexity O((|V| + |E|) log |V| / threads).
+    */
+    double lowerBound() const;
+
     /**
     * @brief Reads edges data from a file.
     *
@@ -133,13 +336,18 @@ public:
     * @details This method initializes the TSP solution process by setting all vertices as unvisited,
     * then starts the backtracking algorithm from the starting vertex (vertex with ID 0). It explores
     * all possible paths using backtracking and calculates the minimum cost of the TSP tour.
-    * The final result is printed to the standard output.
+    * The final result is printed to the standard output. Graphs that cannot have a Hamiltonian cycle over their
+    * edges (disconnected, or with a bridge, an articulation point or a vertex with fewer than two neighbours)
+    * are refused before the search starts.
+    *
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
     *
     * @complexity The time complexity of this function depends on the number of permutations of
     * vertices to explore, resulting in O(V!) in the worst case, where 'V' is the number of
     * vertices in the graph.
     */
-    void TSPBacktracking();
+    void TSPBacktracking(SolveControl *control = nullptr);
 
     /**
     * @brief Solves the Traveling Salesman Problem (TSP) using a triangular approximation.
@@ -147,8 +355,11 @@ public:
     * @details This method approximates the TSP solution by finding a minimum spanning tree
     * (MST) of the graph and then traversing it in a specific manner to form a tour.
     * The length of this tour is calculated and printed as the TSP triangular approximation result.
+    *
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
     */
-    void TSPTriangular();
+    void TSPTriangular(SolveControl *control = nullptr);
 
     /**
     * @brief Solves the Traveling Salesman Problem (TSP) using the nearest neighbor heuristic.
@@ -158,31 +369,292 @@ public:
     * The length of the resulting tour is calculated and printed as the TSP nearest neighbor
     * approximation result.
     *
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
+    *
     * @complexity The time complexity of this function primarily depends on the number of vertices
     * in the graph and the implementation of finding the nearest neighbor, resulting in O(|V|^2),
     * where |V| is the number of vertices.
     */
-    void TSPNearestNeighbor();
+    void TSPNearestNeighbor(SolveControl *control = nullptr);
+
+    /**
+    * @brief Solves the Traveling Salesman Problem (TSP) using parallel simulated annealing.
+    *
+    * @details This method starts from the nearest neighbor tour and improves it with several simulated
+    * annealing replicas running concurrently (one per hardware thread), which periodically share the best
+    * tour found. The search runs for the given wall-clock time and the length of the best tour found
+    * is printed as the TSP simulated annealing result.
+    *
+    * @param timeBudget The wall-clock time budget in seconds.
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
+    *
+    * @throws std::runtime_error if the initial nearest neighbor tour cannot be built.
+    *
+    * @complexity O(|V|^2) for the initial tour, then bounded by the time budget.
+    */
+    void TSPSimulatedAnnealing(double timeBudget, SolveControl *control = nullptr);
+
+    /**
+    * @brief Solves the Traveling Salesman Problem (TSP) using an island model genetic algorithm.
+    *
+    * @details This method evolves one population of tours per hardware thread, seeded with the nearest neighbor
+    * and triangular approximation tours, for the given wall-clock time. The length of the best tour found
+    * is printed as the TSP genetic algorithm result.
+    *
+    * @param timeBudget The wall-clock time budget in seconds.
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
+    *
+    * @throws std::runtime_error if the initial nearest neighbor tour cannot be built.
+    *
+    * @complexity O(|V|^2) for the seed tours, then bounded by the time budget.
+    */
+    void TSPGeneticAlgorithm(double timeBudget, SolveControl *control = nullptr);
+
+    /**
+    * @brief Solves the Traveling Salesman Problem (TSP) using ant colony optimization.
+    *
+    * @details This method runs an ant colony over the existing edges of the graph, so, like the real-world
+    * nearest neighbor heuristic, it works on graphs that are not fully connected. The ants build their tours
+    * in parallel threads for the given wall-clock time, and the length of the best tour found is printed as the
+    * TSP ant colony result. If no ant finds a tour, a message saying there is no solution is printed instead;
+    * graphs that cannot have a Hamiltonian cycle over their edges are refused without starting the colony.
+    *
+    * @param startingVertexId The ID of the starting vertex for the TSP tour.
+    * @param timeBudget The wall-clock time budget in seconds.
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
+    *
+    * @complexity O(m * |V| * k) per iteration, for m ants and k candidate edges per vertex, with the number
+    * of iterations bounded by the time budget.
+    */
+    void TSPAntColony(int startingVertexId, double timeBudget, SolveControl *control = nullptr);
+
+    /**
+    * @brief Solves the Traveling Salesman Problem (TSP) using a Hilbert space-filling curve.
+    *
+    * @details This method visits the vertices in the order in which a Hilbert curve drawn over the map passes
+    * through them. It needs the coordinates from a nodes file, but evaluates no distances to build the tour,
+    * so it is almost instantaneous even on huge graphs. The length of the resulting tour is printed as the TSP
+    * space-filling curve result.
+    *
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
+    *
+    * @throws std::runtime_error if some vertex has no coordinates.
+    *
+    * @complexity O(|V| log |V|).
+    */
+    void TSPSpaceFillingCurve(SolveControl *control = nullptr);
+
+    /**
+    * @brief Solves the Traveling Salesman Problem (TSP) using the greedy edge heuristic.
+    *
+    * @details This method builds the tour by taking the lightest candidate edges first, as long as no vertex
+    * gets three tour edges and no cycle is closed too early. The length of the resulting tour is printed as
+    * the TSP greedy edge result.
+    *
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
+    *
+    * @throws std::runtime_error if the paths built from the candidate edges cannot be joined.
+    *
+    * @complexity O(|V| k log(|V| k)), k being the number of candidate edges per vertex.
+    */
+    void TSPGreedyEdge(SolveControl *control = nullptr);
+
+    /**
+    * @brief Solves the Traveling Salesman Problem (TSP) using the Clarke-Wright savings heuristic.
+    *
+    * @details This method merges the routes from and back to the vertex with the lowest id in order of
+    * largest saving over the candidate pairs of vertices. The length of the resulting tour is printed as the
+    * TSP savings result.
+    *
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
+    *
+    * @throws std::runtime_error if the routes cannot be joined into a tour.
+    *
+    * @complexity O(|V| k log(|V| k)), k being the number of candidates per vertex.
+    */
+    void TSPSavings(SolveControl *control = nullptr);
+
+    /**
+    * @brief Solves the Traveling Salesman Problem (TSP) using the cheapest insertion heuristic.
+    *
+    * @details This method starts from the convex hull of the vertices (or from a two vertex cycle when there are
+    * no coordinates) and repeatedly inserts the vertex whose insertion increases the tour cost the least.
+    * The length of the resulting tour is printed as the TSP cheapest insertion result.
+    *
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
+    *
+    * @throws std::runtime_error if some edge weight cannot be obtained.
+    *
+    * @complexity O(|V|^2 log |V|).
+    */
+    void TSPCheapestInsertion(SolveControl *control = nullptr);
+
+    /**
+    * @brief Solves the Traveling Salesman Problem (TSP) using the farthest insertion heuristic.
+    *
+    * @details This method starts from the convex hull of the vertices (or from a two vertex cycle when there are
+    * no coordinates) and repeatedly inserts the vertex farthest from the tour where it increases the cost the
+    * least. The length of the resulting tour is printed as the TSP farthest insertion result.
+    *
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
+    *
+    * @throws std::runtime_error if some edge weight cannot be obtained.
+    *
+    * @complexity O(|V|^2 log |V|).
+    */
+    void TSPFarthestInsertion(SolveControl *control = nullptr);
 
     /**
     * @brief Solves the Traveling Salesman Problem (TSP) using a real-world nearest neighbor heuristic.
     *
     * @details This method approximates the TSP solution by starting from a user-specified starting vertex
-    * and iteratively selecting the nearest unvisited neighbor until all vertices are visited.
-    * Additionally, it considers constraints specific to real-world scenarios (the graph is not fully connected).
-    * If no solution is found within the constraints, an exception is thrown.
+    * and iteratively selecting the nearest unvisited vertex until all vertices are visited.
+    * Additionally, it considers constraints specific to real-world scenarios (the graph is not fully connected):
+    * distances are shortest-path distances through the graph, so the next vertex does not need to be adjacent.
+    * A disconnected graph is refused before any distance is computed.
+    * When a route file is given, the full route, with every leg expanded into the vertices of its shortest path,
+    * is streamed to it as CSV, one vertex id per line. The file is opened before the search, so that a bad path
+    * does not throw away the run.
     * The length of the resulting tour is calculated and printed as the TSP real-world nearest neighbor
     * approximation result.
     *
     * @param starting_vertex The ID of the starting vertex for the TSP tour.
+    * @param routeFilePath The file the route is written to, or an empty path not to write it.
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the run, the
+    * best tour found by then is printed, or the reason there is none.
     *
     * @throws std::runtime_error if no feasible solution is found within the constraints.
     *
-    * @complexity The time complexity of this function primarily depends on the number of vertices
-    * in the graph and the implementation of finding the nearest neighbor, resulting in O(|V| + |E|),
-    * where |V| is the number of vertices and |E| is the number of edges in the graph.
+    * @complexity O(|V| (|V| + |E|) log |V|), dominated by the shortest-path distances.
+    */
+    void TSPRealWorldNearestNeighbor(int startingVertexId, const filesystem::path &routeFilePath,
+                                     SolveControl *control = nullptr);
+
+    /**
+    * @brief Races several TSP algorithms on the loaded graph and prints the best tour, and which one found it.
+    *
+    * @details See solvePortfolio. Every entrant is listed with its cost and the time it took, or why it found
+    * no tour.
+    *
+    * @param timeBudget The time budget of the race in seconds.
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the race, the
+    * best tour found by then is printed.
+    *
+    * @complexity The complexity of the slowest entrant, bounded by the time budget.
+    */
+    void TSPPortfolio(double timeBudget, SolveControl *control = nullptr);
+
+    /**
+    * @brief Gets the names of the algorithms accepted by solve.
+    *
+    * @return The names, in the order of the menus.
+    *
+    * @complexity O(1).
+    */
+    static const vector<string> &algorithmNames();
+
+    /**
+    * @brief Gets the names of the priority queues accepted by setHeap.
+    *
+    * @return The names, in the order of HeapKind: "default", "binary", "4-ary", "pairing" and "radix".
+    *
+    * @complexity O(1).
+    */
+    static const vector<string> &heapNames();
+
+    /**
+    * @brief Tells if an algorithm starts from the starting vertex given to solve; the others ignore it.
+    *
+    * @param algorithm One of algorithmNames.
+    *
+    * @return True for backtracking, the ant colony and the real-world nearest neighbor.
+    *
+    * @complexity O(1).
+    */
+    static bool usesStartingVertex(const string &algorithm);
+
+    /**
+    * @brief Gets the names of the algorithms solvePortfolio races on the loaded graph.
+    *
+    * @return Triangular approximation, nearest neighbor, greedy edge, savings and simulated annealing (which
+    * improves the nearest neighbor tour with 2-opt moves), and backtracking first when the graph has at most
+    * EXACT_MAX_VERTICES vertices.
+    */
+    vector<string> portfolioEntrants() const;
+
+    /**
+    * @brief Sets whether solve measures its runs with the CPU performance counters (see HardwareCounters).
+    *
+    * @details Off by default: opening the counters takes a few system calls per run, and the counts are only
+    * meaningful on a machine that exposes them.
+    *
+    * @param enabled True to measure the runs.
+    *
+    * @complexity O(1).
+    */
+    void setHardwareCounters(bool enabled);
+
+    /**
+    * @brief Solves the Traveling Salesman Problem (TSP) with the named algorithm, without printing anything.
+    *
+    * @details Runs the same algorithm as the matching TSP method (and refuses the same hopeless graphs), but
+    * returns the result instead of printing it, for the batch mode. The real-world nearest neighbor route is
+    * not written to a file. With a control, the run stops at its deadline or when it is cancelled; the exact and
+    * improving algorithms then report the best tour found so far, the constructive ones an error.
+    *
+    * @param algorithm One of algorithmNames.
+    * @param startingVertexId The ID of the starting vertex, used by backtracking, the ant colony and the
+    * real-world nearest neighbor.
+    * @param timeBudget The time budget in seconds of the simulated annealing, genetic algorithm and ant colony.
+    * @param threads The number of replicas, islands or ant tasks of those three algorithms, which run on the
+    * thread pool (see setThreads). 0 uses the size of the pool.
+    * @param control Optional deadline, cancellation and progress (see SolveControl).
+    *
+    * @return The result of the run; when no tour was found, solved is false and error says why. The
+    * instrumentation is reset at the start, so the profile only covers this run. The hardware counts, when
+    * enabled, cover the same span as seconds. The memory peaks are reset at the start, so they cover this run
+    * too, where the kernel allows it.
+    *
+    * @throws std::runtime_error if the algorithm name is unknown.
+    *
+    * @complexity The complexity of the chosen algorithm.
+    */
+    TSPRun solve(const string &algorithm, int startingVertexId, double timeBudget, unsigned int threads,
+                 SolveControl *control = nullptr);
+
+    /**
+    * @brief Races the portfolioEntrants on the loaded graph, one thread each, and keeps the cheapest tour.
+    *
+    * @details The entrants share the graph, which none of them changes, and a SolveControl: every tour one of
+    * them finds is published to it, so the progress callback sees the best tour of the race, and all stop at
+    * the same deadline. When the backtracking search runs to the end its tour is optimal, so the others are
+    * cancelled at once; otherwise the race lasts until the last entrant ends, the simulated annealing at the
+    * time budget. The entrants are long-running, so each keeps a thread of its own rather than a task of the
+    * thread pool, which still runs their parallel parts; the simulated annealing gets the threads left by the
+    * other entrants.
+    *
+    * @param startingVertexId The ID of the starting vertex of the backtracking search.
+    * @param timeBudget The time budget of the race in seconds.
+    * @param threads The number of threads of the race. 0 uses the size of the thread pool.
+    * @param control Optional deadline, cancellation and progress (see SolveControl); when it stops the race, the
+    * entrants still running are cancelled.
+    *
+    * @return The run of every entrant and the winner. The instrumentation and the memory peaks are reset at the
+    * start, like in solve.
+    *
+    * @complexity The complexity of the slowest entrant, bounded by the time budget.
     */
-    void TSPRealWorldNearestNeighbor(int startingVertexId);
+    PortfolioRun solvePortfolio(int startingVertexId, double timeBudget, unsigned int threads,
+                                SolveControl *control = nullptr);
 };
 
 
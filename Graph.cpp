@@ -1,6 +1,19 @@
 #include <valarray>
 #include <stack>
+#include <random>
+#include <chrono>
+#include <array>
 #include "Graph.h"
+#include "UnionFind.h"
+#include "PairingHeap.h"
+#include "SpanningTree.h"
+#include "MetricClosure.h"
+#include "ContractionHierarchy.h"
+
+// Throws if the control asks a constructive heuristic to stop, since it has no tour to return until it ends
+static void stopIfAsked(SolveControl *control) {
+    if (control && control->shouldStopNow()) throw runtime_error("Stopped before the tour was complete.");
+}
 
 /************************* Vertex  **************************/
 
@@ -31,7 +44,7 @@ double Vertex::getLatitude() const {
 }
 
 // Getter for adjacent vertices
-unordered_map<int, Edge *> Vertex::getAdj() const {
+const unordered_map<int, Edge *> &Vertex::getAdj() const {
     return this->adj;
 }
 
@@ -74,6 +87,7 @@ Edge * Vertex::addEdge(Vertex *dest, double w) {
 
 // Method to find an edge given the destination vertex id
 Edge * Vertex::findEdge(int destId) {
+    TSP_COUNT(HASH_LOOKUP);
     auto it = this->adj.find(destId);
     if (it != this->adj.end()) {
         return it->second;
@@ -112,10 +126,45 @@ void Edge::setReverse(Edge *reverseEdge) {
 }
 
 
+/********************** GraphAnalysis  ****************************/
+
+// Method to explain why no Hamiltonian cycle can exist over the edges
+string GraphAnalysis::hamiltonianCycleObstacle() const {
+    if (vertices == 0) return "The graph is empty.";
+    if (components > 1) return "The graph is not connected (" + to_string(components) + " components).";
+    if (vertices < 3) return ""; // Two vertices: the cycle goes along the same edge and back
+    if (!lowDegreeVertices.empty())
+        return "Vertex " + to_string(lowDegreeVertices.front()) + " has fewer than two neighbours.";
+    if (!bridges.empty())
+        return "The edge " + to_string(bridges.front().first) + " - " + to_string(bridges.front().second) + " is a bridge.";
+    if (!articulationPoints.empty())
+        return "Vertex " + to_string(articulationPoints.front()) + " is an articulation point.";
+    return "";
+}
+
+// Method to explain why no closed walk can visit every vertex
+string GraphAnalysis::closedWalkObstacle() const {
+    if (vertices == 0) return "The graph is empty.";
+    if (components > 1) return "The graph is not connected (" + to_string(components) + " components).";
+    return "";
+}
+
+// Method to explain why some pair of vertices has no distance
+string GraphAnalysis::distanceObstacle() const {
+    return coordinates ? "" : closedWalkObstacle();
+}
+
 /********************** Graph  ****************************/
 
+// Constructor
+Graph::Graph() = default;
+
+// Destructor
+Graph::~Graph() = default;
+
 // Method to find a vertex in the graph given its ID
 Vertex *Graph::findVertex(int id) const {
+    TSP_COUNT(HASH_LOOKUP);
     auto it = this->vertices.find(id);
     if (it != this->vertices.end()) {
         return it->second;
@@ -182,16 +231,179 @@ unordered_map<int, Vertex *> Graph::getVertexSet() const {
     return this->vertices;
 }
 
+// Method to get the metric closure of the graph, building it on first use
+MetricClosure &Graph::getMetricClosure() {
+    // Only the first call waits for the others; later calls do not lock, as getEdgeWeight comes here on every
+    // missing edge, from many threads at once in the metaheuristics
+    call_once(closureBuilt, [this]() {
+        Instrumentation::PhaseTimer timer(Instrumentation::PREPROCESSING);
+        vector<Vertex *> nodes;
+        for (auto &pair : vertices) nodes.push_back(pair.second);
+        sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+        closure = make_unique<MetricClosure>(nodes, threadPool(), hierarchy.get(), heap);
+    });
+    return *closure;
+}
+
+// Method to set the thread pool of the parallel algorithms
+void Graph::setThreadPool(ThreadPool *threads) {
+    pool = threads;
+}
+
+// Method to set the priority queue of prim and of the metric closure
+void Graph::setHeap(HeapKind kind) {
+    heap = kind;
+}
+
+// Method to get the thread pool of the parallel algorithms
+ThreadPool &Graph::threadPool() const {
+    return pool ? *pool : ThreadPool::serial();
+}
+
+// Method to run an epoch of the replicas of a metaheuristic, in waves if they outnumber the threads
+void Graph::runEpoch(size_t count, chrono::steady_clock::time_point epochEnd,
+                     const function<void(size_t, chrono::steady_clock::time_point)> &body) const {
+    ThreadPool &threads = threadPool();
+    const size_t width = threads.size();
+    const size_t waves = (count + width - 1) / width;
+    const auto epochStart = chrono::steady_clock::now();
+    for (size_t w = 0; w < waves; ++w) {
+        const auto waveEnd = epochStart + (epochEnd - epochStart) * (long) (w + 1) / (long) waves;
+        ThreadPool::TaskGroup group(threads);
+        for (size_t r = w * width; r < min(count, (w + 1) * width); ++r) group.run([&body, r, waveEnd]() { body(r, waveEnd); });
+        group.wait();
+    }
+}
+
+// Method to set the contraction hierarchy index of the graph
+void Graph::setContractionHierarchy(unique_ptr<ContractionHierarchy> index) {
+    hierarchy = std::move(index);
+}
+
+// Method to get the contraction hierarchy index of the graph
+ContractionHierarchy *Graph::getContractionHierarchy() const {
+    return hierarchy.get();
+}
+
+// Method to account the memory of the vertices, the edges, their hash tables and the distance indexes
+void Graph::memoryUsage(Memory::Report &report) const {
+    size_t edges = 0;
+    report.adjacencyTables = 0;
+    for (const auto &pair : vertices) {
+        edges += pair.second->getAdj().size();
+        report.adjacencyTables += Memory::hashTableBytes(pair.second->getAdj());
+    }
+    report.vertexObjects = vertices.size() * Memory::blockBytes(sizeof(Vertex));
+    report.edgeObjects = edges * Memory::blockBytes(sizeof(Edge));
+    report.vertexTable = Memory::hashTableBytes(vertices);
+    report.metricClosure = closure ? closure->memoryBytes() : 0;
+    report.contractionHierarchy = hierarchy ? hierarchy->memoryBytes() : 0;
+}
+
+// Method to analyse the structure of the graph: components, low degree vertices, bridges and articulation points
+GraphAnalysis Graph::analyse() const {
+    GraphAnalysis analysis;
+    vector<Vertex *> nodes;
+    for (auto &pair : vertices) nodes.push_back(pair.second);
+    sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+    int n = (int) nodes.size();
+    analysis.vertices = n;
+
+    unordered_map<int, int> indices;
+    indices.reserve(n);
+    analysis.coordinates = n > 0;
+    for (int i = 0; i < n; i++) {
+        indices[nodes[i]->getId()] = i;
+        if (nodes[i]->getLongitude() == numeric_limits<double>::max() ||
+            nodes[i]->getLatitude() == numeric_limits<double>::max())
+            analysis.coordinates = false;
+    }
+
+    // Undirected adjacency lists, without loops or repeated neighbours
+    vector<vector<int>> neighbours(n);
+    for (int i = 0; i < n; i++) {
+        for (auto &pair : nodes[i]->getAdj()) {
+            auto it = indices.find(pair.first);
+            if (it == indices.end() || it->second == i) continue;
+            neighbours[i].push_back(it->second);
+            neighbours[it->second].push_back(i);
+        }
+    }
+    vector<int> seen(n, -1);
+    for (int i = 0; i < n; i++) {
+        vector<int> &list = neighbours[i];
+        size_t kept = 0;
+        for (int j : list) {
+            if (seen[j] == i) continue;
+            seen[j] = i;
+            list[kept++] = j;
+        }
+        list.resize(kept);
+        if (kept < 2) analysis.lowDegreeVertices.push_back(nodes[i]->getId());
+    }
+
+    // Tarjan's lowlink depth-first search, one tree per component
+    vector<int> order(n, -1);           // discovery time
+    vector<int> low(n);                 // earliest discovery time reachable through the subtree and one back edge
+    vector<int> parentOf(n, -1);
+    vector<size_t> nextNeighbour(n, 0);
+    vector<bool> articulation(n, false);
+    vector<int> dfs;
+    int time = 0;
+    for (int root = 0; root < n; root++) {
+        if (order[root] != -1) continue;
+        analysis.components++;
+        int rootChildren = 0;
+        order[root] = low[root] = time++;
+        dfs.push_back(root);
+
+        while (!dfs.empty()) {
+            int u = dfs.back();
+            if (nextNeighbour[u] < neighbours[u].size()) {
+                int w = neighbours[u][nextNeighbour[u]++];
+                if (order[w] == -1) {
+                    parentOf[w] = u;
+                    order[w] = low[w] = time++;
+                    dfs.push_back(w);
+                    if (u == root) rootChildren++;
+                } else if (w != parentOf[u]) {
+                    low[u] = min(low[u], order[w]); // Back edge
+                }
+                continue;
+            }
+
+            // u is finished: report its tree edge to the parent
+            dfs.pop_back();
+            int p = parentOf[u];
+            if (p == -1) continue;
+            low[p] = min(low[p], low[u]);
+            if (low[u] > order[p]) analysis.bridges.emplace_back(nodes[p]->getId(), nodes[u]->getId());
+            if (p != root && low[u] >= order[p]) articulation[p] = true;
+        }
+        if (rootChildren > 1) articulation[root] = true;
+    }
+    for (int i = 0; i < n; i++)
+        if (articulation[i]) analysis.articulationPoints.push_back(nodes[i]->getId());
+
+    return analysis;
+}
+
 // Method to get the weight of an edge between two vertices
 double Graph::getEdgeWeight(Vertex* source, Vertex* dest) {
+    TSP_COUNT(EDGE_WEIGHT);
     Edge* e = source->findEdge(dest->getId());
     if (!e) {
         // If the edge is not found, calculate the distance using haversine formula
         if (source->getLongitude() == numeric_limits<double>::max() ||
             source->getLatitude() == numeric_limits<double>::max() ||
             dest->getLongitude() == numeric_limits<double>::max() ||
-            dest->getLatitude() == numeric_limits<double>::max())
-            throw runtime_error("Edge not found");
+            dest->getLatitude() == numeric_limits<double>::max()) {
+            // Without coordinates, fall back to the shortest path through the graph
+            MetricClosure &metric = getMetricClosure();
+            double dist = metric.distance(metric.indexOf(source->getId()), metric.indexOf(dest->getId()));
+            if (dist == numeric_limits<double>::max()) throw runtime_error("Edge not found");
+            return dist;
+        }
         return haversine(source->getLatitude(), source->getLongitude(), dest->getLatitude(), dest->getLongitude());
     } else {
         return e->getWeight();
@@ -200,6 +412,7 @@ double Graph::getEdgeWeight(Vertex* source, Vertex* dest) {
 
 // Method to perform TSP using backtracking
 void Graph::TSPBacktracking(Vertex *currentVertex, int destId, int count, double cost, double &res) {
+    TSP_COUNT(NODE_EXPANDED);
 
     // If all vertices are visited, check for return edge to the starting vertex and update the result
     if(count == this->vertices.size()) {
@@ -220,14 +433,103 @@ void Graph::TSPBacktracking(Vertex *currentVertex, int destId, int count, double
     }
 }
 
+// Method to perform TSP using backtracking, keeping the best cycle and stopping when the control says so
+void Graph::TSPBacktracking(double &res, vector<Vertex *> &tour, int startingVertexId, SolveControl *control) {
+    Vertex *start = findVertex(startingVertexId);
+    if (!start) throw runtime_error("There is no vertex with id " + to_string(startingVertexId) + ".");
+    lock_guard<mutex> scratch(scratchMutex);
+    {
+        Instrumentation::PhaseTimer timer(Instrumentation::RESET);
+        for (auto &pair : vertices) pair.second->setVisited(false);
+    }
+
+    res = numeric_limits<double>::max();
+    tour.clear();
+    vector<Vertex *> path = {start};
+    start->setVisited(true);
+    backtrack(start, start, path, 0, res, tour, control);
+    start->setVisited(false);
+
+    if (tour.empty()) {
+        if (control && control->stopped()) throw runtime_error("Stopped before a Hamiltonian cycle was found.");
+        throw runtime_error("There is no Hamiltonian cycle.");
+    }
+}
+
+// Method to extend a path by each unvisited neighbour, recording the cycles better than the best one
+void Graph::backtrack(Vertex *current, Vertex *start, vector<Vertex *> &path, double cost, double &res,
+                      vector<Vertex *> &tour, SolveControl *control) {
+    TSP_COUNT(NODE_EXPANDED);
+    if (control && control->shouldStop()) return;
+
+    if (path.size() == vertices.size()) {
+        Edge *finalEdge = current->findEdge(start->getId());
+        if (finalEdge && cost + finalEdge->getWeight() < res) {
+            res = cost + finalEdge->getWeight();
+            tour = path;
+            if (control) control->improve(res, tour);
+        }
+        return;
+    }
+
+    for (auto &pair : current->getAdj()) {
+        Edge *e = pair.second;
+        Vertex *v = e->getDest();
+        if (v->isVisited() || cost + e->getWeight() >= res) continue; // Distances are not negative
+        v->setVisited(true);
+        path.push_back(v);
+        backtrack(v, start, path, cost + e->getWeight(), res, tour, control);
+        path.pop_back();
+        v->setVisited(false);
+    }
+}
+
 // Method to perform TSP using triangularization
 void Graph::TSPTriangular(double &res) {
-    // Perform Prim's algorithm to get minimum spanning tree
-    this->prim();
+    vector<Vertex *> preorder;
+    TSPTriangular(res, preorder);
+}
+
+// Method to perform TSP using triangularization, keeping the visiting order
+void Graph::TSPTriangular(double &res, vector<Vertex *> &preorder, SolveControl *control) {
+    // The tree is kept in local arrays over the vertices in the order of the vertex set, so the graph is only read
+    vector<Vertex *> nodes;
+    vector<int> parent;
+    nodes.reserve(vertices.size());
+    for (auto &pair : vertices) nodes.push_back(pair.second);
+
+    // Get the minimum spanning tree: from the existing edges alone on sparse graphs, otherwise over every pair
+    {
+        Instrumentation::PhaseTimer timer(Instrumentation::MST);
+        size_t edges = 0;
+        bool coordinates = true;
+        for (Vertex *v : nodes) {
+            edges += v->getAdj().size();
+            if (v->getLongitude() == numeric_limits<double>::max() ||
+                v->getLatitude() == numeric_limits<double>::max()) coordinates = false;
+        }
+        const double n = (double) nodes.size();
+        const bool sparse = (double) edges <= SPARSE_FILL * n * (n - 1);
+        const bool large = edges >= PARALLEL_MST_MIN_EDGES;
+        bool spanning = false;
+        if (sparse) spanning = large ? boruvka(nodes, parent) : kruskal(nodes, parent);
+        else if (large && (double) edges >= n * (n - 1)) spanning = boruvka(nodes, parent); // Complete: the tree prim would build (up to ties), on every thread of the pool
+        if (!spanning) {
+            // The edges of a sparse graph that do not span it can only be completed by coordinates
+            if (sparse && !coordinates) throw runtime_error("The graph is not connected");
+            this->prim(nodes, parent);
+        }
+    }
+
+    stopIfAsked(control);
 
     // Perform preorder traversal to get vertices in a specific order
-    vector<Vertex *> preorder;
-    preorderTraversal(findVertex(0), preorder, (int) vertices.size());
+    preorder.clear();
+    {
+        Instrumentation::PhaseTimer timer(Instrumentation::PREORDER);
+        int root = (int) (find(nodes.begin(), nodes.end(), findVertex(0)) - nodes.begin());
+        preorderTraversal(nodes, parent, root, preorder);
+    }
 
     // Calculate total weight of the Hamiltonian cycle
     for (size_t i = 0; i < preorder.size() - 1; ++i) {
@@ -239,167 +541,1569 @@ void Graph::TSPTriangular(double &res) {
     Vertex *v = preorder[preorder.size() - 1];
     Vertex *u = preorder[0];
     res += getEdgeWeight(v, u);
+    if (control) control->improve(res, preorder);
 }
 
-// Method to perform Prim's algorithm for minimum spanning tree
-void Graph::prim() {
-    if (vertices.empty()) return;
+// Method to perform Prim's algorithm for minimum spanning tree, with the chosen queue
+void Graph::prim(const vector<Vertex *> &nodes, vector<int> &parent) {
+    switch (heap) {
+        case HeapKind::QUATERNARY: primWith<IndexedPriorityQueue<4>>(nodes, parent); break;
+        case HeapKind::PAIRING: primWith<PairingHeap>(nodes, parent); break;
+        default: primWith<IndexedPriorityQueue<2>>(nodes, parent); // Radix heaps need monotone keys
+    }
+}
 
-    // Initialize distances, paths, and visited flags for vertices
-    for (auto pair : vertices) {
-        Vertex *v = pair.second;
-        v->setDist(numeric_limits<double>::max());
-        v->setPath(nullptr);
-        v->setVisited(false);
+// Method to perform Prim's algorithm for minimum spanning tree
+template <class Queue>
+void Graph::primWith(const vector<Vertex *> &nodes, vector<int> &parent) {
+    const int n = (int) nodes.size();
+    parent.assign(n, -1);
+    if (n == 0) return;
+
+    // Initialize distances and visited flags for vertices
+    vector<double> dist;
+    vector<char> visited;
+    {
+        Instrumentation::PhaseTimer timer(Instrumentation::RESET);
+        dist.assign(n, numeric_limits<double>::max());
+        visited.assign(n, 0);
     }
 
-    // Start with a random vertex
-    Vertex* s = findVertex(0);
+    // Start with the vertex with id 0
+    int s = (int) (find(nodes.begin(), nodes.end(), findVertex(0)) - nodes.begin());
 
-    s->setDist(0);
-    MutablePriorityQueue<Vertex> q;
-    q.insert(s);
+    dist[s] = 0;
+    Queue q(n);
+    q.insert(s, 0);
 
     // Main loop of Prim's algorithm
     while (!q.empty()) {
-        auto v = q.extractMin();
-        v->setVisited(true);
+        int v = q.extractMin();
+        visited[v] = 1;
+        TSP_COUNT(NODE_EXPANDED);
 
-        // Traverse through adjacent vertices and update distances
-        for (auto pair : vertices) {
-            Vertex *u = pair.second;
-            if(u->getId() == v->getId()) continue;
+        // Traverse through the other vertices and update distances
+        for (int u = 0; u < n; ++u) {
+            if (u == v) continue;
 
-            double weight = getEdgeWeight(v, u);
+            double weight = getEdgeWeight(nodes[v], nodes[u]);
 
-            if (!u->isVisited()) {
-                double oldDist = u->getDist();
+            if (!visited[u]) {
+                double oldDist = dist[u];
 
                 if (weight < oldDist) {
-                    u->setDist(weight);
-                    u->setPath(v);
+                    dist[u] = weight;
+                    parent[u] = v;
 
-                    if (oldDist == numeric_limits<double>::max()) q.insert(u);
-                    else q.decreaseKey(u);
+                    if (oldDist == numeric_limits<double>::max()) q.insert(u, weight);
+                    else q.decreaseKey(u, weight);
                 }
             }
         }
     }
 }
 
-// Method to perform preorder traversal of the minimum spanning tree
-void Graph::preorderTraversal(Vertex *v, std::vector<Vertex *> &preorder, int n) {
-    preorder.push_back(v);
+// Method to perform Kruskal's algorithm for a minimum spanning tree over the existing edges
+bool Graph::kruskal(const vector<Vertex *> &nodes, vector<int> &parent) {
+    return spanningTree(false, nodes, parent);
+}
+
+// Method to perform a parallel Boruvka's algorithm for a minimum spanning tree over the existing edges
+bool Graph::boruvka(const vector<Vertex *> &nodes, vector<int> &parent) {
+    return spanningTree(true, nodes, parent);
+}
+
+// Method to get the existing edges, each once, between the vertices sorted by id
+vector<SpanningTree::WeightedEdge> Graph::edgeList(vector<Vertex *> &nodes) const {
+    nodes.clear();
+    for (auto &pair : vertices) nodes.push_back(pair.second);
+    sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+    unordered_map<int, int> indices;
+    indices.reserve(nodes.size());
+    for (int i = 0; i < (int) nodes.size(); ++i) indices[nodes[i]->getId()] = i;
+
+    vector<SpanningTree::WeightedEdge> edges;
+    for (int i = 0; i < (int) nodes.size(); ++i) {
+        for (auto &pair : nodes[i]->getAdj()) {
+            auto it = indices.find(pair.first);
+            if (it == indices.end() || it->second == i) continue;
+            int j = it->second;
+            if (j < i && pair.second->getDest()->findEdge(nodes[i]->getId())) continue; // Taken from the other end
+            edges.push_back({pair.second->getWeight(), min(i, j), max(i, j)});
+        }
+    }
+    return edges;
+}
 
-    // Traverse recursively through the tree
-    for (auto pair : vertices) {
-        Vertex *u = pair.second;
-        if(!u->getPath() || u->getPath()->getId() != v->getId()) continue;
+// Method to build a minimum spanning tree over the existing edges and root it at the vertex with id 0
+bool Graph::spanningTree(bool parallel, const vector<Vertex *> &nodes, vector<int> &parent) {
+    vector<Vertex *> sorted;
+    vector<SpanningTree::WeightedEdge> edges = edgeList(sorted);
+    const int n = (int) sorted.size();
+    parent.assign(nodes.size(), -1);
+    if (n == 0) return true;
+    unordered_map<int, int> positions;     // position of every vertex in nodes, by id
+    positions.reserve(nodes.size());
+    for (int i = 0; i < (int) nodes.size(); ++i) positions[nodes[i]->getId()] = i;
+
+    vector<int> treeEdges = parallel ? SpanningTree::boruvka(n, edges, threadPool()) : SpanningTree::kruskal(n, edges, threadPool());
+    vector<vector<int>> tree(n);
+    for (int e : treeEdges) {
+        tree[edges[e].a].push_back(edges[e].b);
+        tree[edges[e].b].push_back(edges[e].a);
+    }
 
-        if(preorder.size() == n) return;
+    // Root the tree at the vertex with id 0 (like prim), with a breadth-first search setting each vertex's parent
+    int root = (int) (lower_bound(sorted.begin(), sorted.end(), 0, [](Vertex *v, int id) { return v->getId() < id; }) - sorted.begin());
+    if (root == n || sorted[root]->getId() != 0) root = 0;
+    vector<char> reached(n, 0);
+    queue<int> q;
+    q.push(root);
+    reached[root] = 1;
+    while (!q.empty()) {
+        int u = q.front();
+        q.pop();
+        for (int w : tree[u]) {
+            if (reached[w]) continue;
+            reached[w] = 1;
+            parent[positions[sorted[w]->getId()]] = positions[sorted[u]->getId()];
+            q.push(w);
+        }
+    }
 
-        preorderTraversal(u, preorder, n);
+    return (int) treeEdges.size() == n - 1;
+}
+
+// Method to get the weight of a minimum spanning tree over the existing edges
+double Graph::spanningTreeWeight() const {
+    vector<Vertex *> nodes;
+    vector<SpanningTree::WeightedEdge> edges = edgeList(nodes);
+    double weight = 0;
+    for (int e : SpanningTree::boruvka((int) nodes.size(), edges, threadPool())) weight += edges[e].weight;
+    return weight;
+}
+
+// Method to perform preorder traversal of the minimum spanning tree
+void Graph::preorderTraversal(const vector<Vertex *> &nodes, const vector<int> &parent, int root, vector<Vertex *> &preorder) {
+    // Children of every vertex, in the order of the vertex set
+    const int n = (int) nodes.size();
+    vector<vector<int>> children(n);
+    for (int u = 0; u < n; ++u) {
+        if (parent[u] >= 0) children[parent[u]].push_back(u);
+    }
+
+    // Traverse the tree with an explicit stack, so deep trees cannot overflow the call stack
+    vector<int> stack = {root};
+    while (!stack.empty() && (int) preorder.size() < n) {
+        int u = stack.back();
+        stack.pop_back();
+        preorder.push_back(nodes[u]);
+        stack.insert(stack.end(), children[u].rbegin(), children[u].rend()); // First child on top
     }
 }
 
 // Method to solve TSP using nearest neighbor heuristic
 void Graph::TSPNearestNeighbor(double &res) {
-    // Initialize visited flag for all vertices
-    for (auto& pair : vertices) {
-        pair.second->setVisited(false);
+    vector<Vertex *> tour;
+    TSPNearestNeighbor(res, tour);
+}
+
+// Method to solve TSP using nearest neighbor heuristic, keeping the visiting order
+void Graph::TSPNearestNeighbor(double &res, vector<Vertex *> &tour, SolveControl *control) {
+    // Initialize visited flag for all vertices, in the order of the vertex set
+    vector<Vertex *> nodes;
+    vector<char> visited;
+    {
+        Instrumentation::PhaseTimer timer(Instrumentation::RESET);
+        nodes.reserve(vertices.size());
+        for (auto& pair : vertices) nodes.push_back(pair.second);
+        visited.assign(nodes.size(), 0);
     }
+    Instrumentation::PhaseTimer timer(Instrumentation::CONSTRUCTION);
 
-    // Start from a random vertex
-    int count = 0;
+    // Start from the vertex with id 0
     Vertex* v = findVertex(0);
+    visited[find(nodes.begin(), nodes.end(), v) - nodes.begin()] = 1;
+    tour.clear();
+    tour.push_back(v);
     double currentWeight;
-    Vertex* nearestNeighbor = nullptr;
 
     // Main loop of the nearest neighbor heuristic
-    while (count < vertices.size()) {
+    while (tour.size() < vertices.size()) {
+        stopIfAsked(control);
         currentWeight = numeric_limits<double>::max();
+        int nearestNeighbor = -1;
 
         // Find the nearest unvisited neighbor
-        for (auto& pair : vertices) {
-            Vertex* u = pair.second;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (visited[i]) continue;
 
-            if (u->isVisited()) continue;
-
-            double weight = getEdgeWeight(v, u);
+            double weight = getEdgeWeight(v, nodes[i]);
 
             if (currentWeight > weight) {
                 currentWeight = weight;
-                nearestNeighbor = u;
+                nearestNeighbor = (int) i;
             }
         }
 
         // Handle cases where no neighbor is found
-        if(!nearestNeighbor) throw runtime_error("No neighbour vertex found!");
-        nearestNeighbor->setVisited(true);
+        if(nearestNeighbor < 0) throw runtime_error("No neighbour vertex found!");
+        visited[nearestNeighbor] = 1;
+        tour.push_back(nodes[nearestNeighbor]);
         res += currentWeight;
-        v = nearestNeighbor;
-
-        count++;
+        v = nodes[nearestNeighbor];
     }
 
     // Add the edge back to the starting vertex to complete the cycle
     Vertex *u = findVertex(0);
     res += getEdgeWeight(v, u);
+    if (control) control->improve(res, tour);
 }
 
-// Method to solve TSP using real-world nearest neighbor heuristic
-void Graph::TSPRealWorldNearestNeighbor(double &res, int startingVertexId) {
-    // Initialize visited flag for all vertices
-    for (auto& pair : vertices) {
-        pair.second->setVisited(false);
+// Method to calculate the cost of a closed tour
+double Graph::tourCost(const vector<Vertex *> &tour) {
+    double cost = 0;
+    for (size_t i = 0; i < tour.size(); ++i) {
+        cost += getEdgeWeight(tour[i], tour[(i + 1) % tour.size()]);
     }
+    return cost;
+}
 
-    // Start from a specified vertex
-    int count = 0;
-    Vertex* v = findVertex(startingVertexId);
-    double currentWeight;
-    Vertex* nearestNeighbor = nullptr;
+// Method to improve a nearest neighbor tour using parallel simulated annealing
+void Graph::TSPSimulatedAnnealing(double &res, vector<Vertex *> &tour, unsigned int replicas, double timeBudget,
+                                  SolveControl *control) {
+    // Start every replica from the nearest neighbor tour
+    double initialCost = 0;
+    TSPNearestNeighbor(initialCost, tour, control);
+    res = initialCost;
+    if (control) timeBudget = min(timeBudget, control->remaining());
+
+    const int n = (int) tour.size();
+    if (n < 5 || timeBudget <= 0) return; // No move can change a tour this small
+
+    if (replicas == 0) replicas = threadPool().size();
+
+    // Replicas work on positions of the initial tour, which stays read-only while they run
+    const vector<Vertex *> nodes = tour;
+    auto dist = [&](int a, int b) { return getEdgeWeight(nodes[a], nodes[b]); };
+
+    struct Replica {
+        vector<int> current;
+        double currentCost;
+        vector<int> best;
+        double bestCost;
+        mt19937 rng;
+        double startTemperature;
+        exception_ptr error;
+    };
+
+    // Each replica gets its own seed and a starting temperature in [0.1, 1] times the average edge
+    const double averageEdge = initialCost / n;
+    const double finalTemperatureRatio = 1e-3;
+    vector<Replica> reps(replicas);
+    for (unsigned int r = 0; r < replicas; ++r) {
+        reps[r].current.resize(n);
+        for (int i = 0; i < n; ++i) reps[r].current[i] = i;
+        reps[r].currentCost = initialCost;
+        reps[r].best = reps[r].current;
+        reps[r].bestCost = initialCost;
+        reps[r].rng.seed(r + 1);
+        reps[r].startTemperature = averageEdge * (replicas == 1 ? 1.0 : 1.0 - 0.9 * r / (replicas - 1));
+    }
 
-    // Main loop of the real-world nearest neighbor heuristic
-    while (count < vertices.size()) {
-        currentWeight = numeric_limits<double>::max();
+    const auto start = chrono::steady_clock::now();
+    const auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeBudget));
+    const auto epochLength = (deadline - start) / 20; // Best tours are exchanged 20 times over the run
+
+    // Anneals a single replica until the end of the current epoch
+    auto anneal = [&](Replica &rep, chrono::steady_clock::time_point epochEnd) {
+        Instrumentation::TraceSpan span("anneal", ThreadPool::workerIndex());
+        try {
+            uniform_real_distribution<double> unit(0.0, 1.0);
+            vector<int> &t = rep.current;
+            double temperature = rep.startTemperature;
+
+            auto accept = [&](double delta) {
+                return delta <= 0 || unit(rep.rng) < exp(-delta / temperature);
+            };
+
+            for (unsigned long iteration = 0; ; ++iteration) {
+                // Checking the clock is comparatively expensive, so only do it every 256 moves
+                if ((iteration & 255) == 0) {
+                    auto now = chrono::steady_clock::now();
+                    if (now >= epochEnd || (control && control->stopped())) break;
+                    double progress = chrono::duration<double>(now - start).count() / timeBudget;
+                    temperature = rep.startTemperature * pow(finalTemperatureRatio, min(1.0, progress));
+                }
 
-        // Find the nearest unvisited neighbor considering real-world distances
-        for (auto& pair : vertices) {
-            Vertex* u = pair.second;
+                bool accepted = false;
+                if (unit(rep.rng) < 0.5) {
+                    // 2-opt: reverse the segment t[i..j]; position 0 is kept fixed
+                    int i = 1 + (int) (rep.rng() % (n - 2));
+                    int j = i + 1 + (int) (rep.rng() % (n - 1 - i));
+                    int a = t[i - 1], b = t[i], c = t[j], d = t[(j + 1) % n];
+                    double delta = dist(a, c) + dist(b, d) - dist(a, b) - dist(c, d);
+
+                    if (accept(delta)) {
+                        reverse(t.begin() + i, t.begin() + j + 1);
+                        rep.currentCost += delta;
+                        accepted = true;
+                    }
+                } else {
+                    // Or-opt: move the segment t[i..i+len-1] between t[p] and t[p+1], possibly reversed
+                    int len = 1 + (int) (rep.rng() % 3);
+                    int i = 1 + (int) (rep.rng() % (n - len));
+                    int p = (int) (rep.rng() % n);
+                    if (p >= i - 1 && p <= i + len - 1) continue;
+                    bool reversed = rep.rng() & 1;
+
+                    int prev = t[i - 1], first = t[i], last = t[i + len - 1], next = t[(i + len) % n];
+                    int a = t[p], b = t[(p + 1) % n];
+                    double removeGain = dist(prev, first) + dist(last, next) - dist(prev, next);
+                    double insertCost = reversed ? dist(a, last) + dist(first, b) : dist(a, first) + dist(last, b);
+                    double delta = insertCost - dist(a, b) - removeGain;
+
+                    if (accept(delta)) {
+                        if (p > i + len - 1) {
+                            rotate(t.begin() + i, t.begin() + i + len, t.begin() + p + 1);
+                            if (reversed) reverse(t.begin() + p + 1 - len, t.begin() + p + 1);
+                        } else {
+                            rotate(t.begin() + p + 1, t.begin() + i, t.begin() + i + len);
+                            if (reversed) reverse(t.begin() + p + 1, t.begin() + p + 1 + len);
+                        }
+                        rep.currentCost += delta;
+                        accepted = true;
+                    }
+                }
 
-            if (u->isVisited()) continue;
+                if (accepted && rep.currentCost < rep.bestCost) {
+                    rep.best = t;
+                    rep.bestCost = rep.currentCost;
+                }
+            }
+        } catch (...) {
+            rep.error = current_exception();
+        }
+    };
 
-            Edge* e = v->findEdge(u->getId());
+    vector<int> best = reps[0].best;
+    double bestCost = initialCost;
 
-            double weight = numeric_limits<double>::max();
+    // Run the replicas epoch by epoch, exchanging the best tour in between
+    Instrumentation::PhaseTimer timer(Instrumentation::IMPROVEMENT);
+    while (chrono::steady_clock::now() < deadline && !(control && control->stopped())) {
+        auto epochEnd = min(deadline, chrono::steady_clock::now() + epochLength);
 
-            if (e) weight = e->getWeight();
+        runEpoch(reps.size(), epochEnd, [&](size_t r, chrono::steady_clock::time_point end) { anneal(reps[r], end); });
 
-            if (currentWeight > weight) {
-                currentWeight = weight;
-                nearestNeighbor = u;
+        const double previousCost = bestCost;
+        for (auto &rep : reps) {
+            if (rep.error) rethrow_exception(rep.error);
+            if (rep.bestCost < bestCost) {
+                best = rep.best;
+                bestCost = rep.bestCost;
             }
         }
+        if (control && bestCost < previousCost) {
+            for (int i = 0; i < n; ++i) tour[i] = nodes[best[i]];
+            control->improve(bestCost, tour);
+        }
 
-        // Handle cases where no neighbor is found or no path is found
-        if (!nearestNeighbor) throw runtime_error("No neighbour vertex found!");
-        nearestNeighbor->setVisited(true);
+        // Replicas that fell behind continue from the best tour found so far
+        for (auto &rep : reps) {
+            if (rep.currentCost > bestCost) {
+                rep.current = best;
+                rep.currentCost = bestCost;
+            }
+        }
+    }
 
-        if (currentWeight >= numeric_limits<double>::max()) throw runtime_error("No path found!");
+    for (int i = 0; i < n; ++i) tour[i] = nodes[best[i]];
+    res = tourCost(tour); // Recompute to discard the rounding errors accumulated by the deltas
+}
 
-        res += currentWeight;
-        v = nearestNeighbor;
+// Reverses the cyclic segment t[from..to], keeping pos (the position of each vertex) up to date
+static void reverseSegment(vector<int> &t, vector<int> &pos, int from, int to) {
+    const int n = (int) t.size();
+    int len = ((to - from + n) % n) + 1;
+
+    // Reversing the complement gives the same cycle, so reverse whichever part is shorter
+    if (2 * len > n) {
+        int newFrom = (to + 1) % n;
+        to = (from - 1 + n) % n;
+        from = newFrom;
+        len = n - len;
+    }
 
-        count++;
+    for (int k = 0; k < len / 2; ++k) {
+        swap(t[from], t[to]);
+        pos[t[from]] = from;
+        pos[t[to]] = to;
+        from = (from + 1) % n;
+        to = (to - 1 + n) % n;
     }
+}
 
-    // Add the edge back to the starting vertex to complete the cycle
-    Edge* e = v->findEdge(0);
-    double weight = numeric_limits<double>::max();
-    if (e) weight = e->getWeight();
+// 2-opt local search that only tries to connect each vertex to its candidate neighbours
+template <typename Distance>
+static void twoOptCandidates(vector<int> &t, vector<int> &pos, const vector<vector<int>> &candidates, Distance dist) {
+    const int n = (int) t.size();
+    for (int i = 0; i < n; ++i) pos[t[i]] = i;
+
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (int i = 0; i < n; ++i) {
+            int a = t[i], b = t[(i + 1) % n];
+            double ab = dist(a, b);
+
+            for (int c : candidates[a]) {
+                double ac = dist(a, c);
+                if (ac >= ab) break; // Candidates are sorted, so no later one can improve the tour
+
+                int j = pos[c];
+                int d = t[(j + 1) % n];
+                if (c == b || d == a) continue;
+
+                if (ac + dist(b, d) - ab - dist(c, d) < -1e-9) {
+                    // Replace edges (a, b) and (c, d) by (a, c) and (b, d)
+                    reverseSegment(t, pos, (i + 1) % n, j);
+                    improved = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Position of the cell (x, y) along the Hilbert curve that fills a side x side grid (side is a power of 2)
+static uint64_t hilbertIndex(uint32_t side, uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = side / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0;
+        uint32_t ry = (y & s) > 0;
+        d += (uint64_t) s * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant so that the curve inside it has the standard orientation
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Method to build a tour following a Hilbert space-filling curve
+void Graph::TSPSpaceFillingCurve(double &res, vector<Vertex *> &tour, SolveControl *control) {
+    Instrumentation::PhaseTimer timer(Instrumentation::CONSTRUCTION);
+    tour.clear();
+    if (vertices.empty()) return;
+
+    // Bounding box of the equirectangular projection around the mean latitude
+    double meanLatitude = 0;
+    for (auto &pair : vertices) {
+        Vertex *v = pair.second;
+        if (v->getLongitude() == numeric_limits<double>::max() || v->getLatitude() == numeric_limits<double>::max())
+            throw runtime_error("Vertex without coordinates");
+        meanLatitude += v->getLatitude();
+    }
+    meanLatitude /= (double) vertices.size();
+    const double scaleX = cos(convert_to_radians(meanLatitude));
+
+    double minX = numeric_limits<double>::max(), minY = numeric_limits<double>::max();
+    double maxX = numeric_limits<double>::lowest(), maxY = numeric_limits<double>::lowest();
+    for (auto &pair : vertices) {
+        double x = pair.second->getLongitude() * scaleX, y = pair.second->getLatitude();
+        minX = min(minX, x);
+        maxX = max(maxX, x);
+        minY = min(minY, y);
+        maxY = max(maxY, y);
+    }
+
+    // Scale both axes by the same factor, so that the curve does not distort the map
+    const uint32_t side = 1u << 16;
+    const double extent = max(maxX - minX, maxY - minY);
+    const double scale = extent > 0 ? (side - 1) / extent : 0;
+
+    vector<pair<uint64_t, Vertex *>> order;
+    order.reserve(vertices.size());
+    for (auto &pair : vertices) {
+        Vertex *v = pair.second;
+        auto x = (uint32_t) ((v->getLongitude() * scaleX - minX) * scale);
+        auto y = (uint32_t) ((v->getLatitude() - minY) * scale);
+        order.emplace_back(hilbertIndex(side, x, y), v);
+    }
+    sort(order.begin(), order.end(), [](const pair<uint64_t, Vertex *> &a, const pair<uint64_t, Vertex *> &b) {
+        return a.first != b.first ? a.first < b.first : a.second->getId() < b.second->getId();
+    });
+
+    // Start the tour at the vertex with id 0, as the other heuristics do
+    size_t offset = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (order[i].second->getId() == 0) offset = i;
+    }
+    for (size_t i = 0; i < order.size(); ++i) tour.push_back(order[(offset + i) % order.size()].second);
+
+    res = tourCost(tour);
+    if (control) control->improve(res, tour);
+}
 
+// Method to build a tour using the greedy edge heuristic
+void Graph::TSPGreedyEdge(double &res, vector<Vertex *> &tour, SolveControl *control) {
+    Instrumentation::PhaseTimer timer(Instrumentation::CONSTRUCTION);
+    tour.clear();
+    vector<Vertex *> nodes;
+    for (auto &pair : vertices) nodes.push_back(pair.second);
+    sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+
+    const int n = (int) nodes.size();
+    if (n < 3) {
+        tour = nodes;
+        res = tourCost(tour);
+        return;
+    }
+
+    // Weight of a pair of vertices, or infinity when the graph gives none
+    auto weight = [&](int a, int b) {
+        Edge *e = nodes[a]->findEdge(nodes[b]->getId());
+        if (e) return e->getWeight();
+        try {
+            return getEdgeWeight(nodes[a], nodes[b]);
+        } catch (const runtime_error &) {
+            return numeric_limits<double>::max();
+        }
+    };
+
+    vector<int> degree(n, 0);
+    vector<array<int, 2>> links(n, {-1, -1});
+    UnionFind fragments(n);
+    auto link = [&](int a, int b) {
+        links[a][degree[a]++] = b;
+        links[b][degree[b]++] = a;
+    };
+
+    // Greedy pass over the candidate edges among a subset of the vertices: each edge is taken, lightest first,
+    // unless it gives a vertex degree 3 or closes a cycle before the end. Returns the number of edges taken
+    int added = 0;
+    auto greedyPass = [&](const vector<int> &subset) {
+        vector<Vertex *> subsetNodes;
+        for (int i : subset) subsetNodes.push_back(nodes[i]);
+        const vector<vector<int>> candidates = candidateNeighbours(subsetNodes, 10);
+
+        // Candidate edges, each pair once, sorted by weight
+        vector<pair<double, pair<int, int>>> edges;
+        for (int i = 0; i < (int) subset.size(); ++i) {
+            for (int j : candidates[i]) {
+                bool listedByJ = find(candidates[j].begin(), candidates[j].end(), i) != candidates[j].end();
+                if (i < j || !listedByJ) edges.push_back({weight(subset[i], subset[j]), {subset[i], subset[j]}});
+            }
+        }
+        sort(edges.begin(), edges.end());
+
+        int taken = 0;
+        for (auto &edge : edges) {
+            int a = edge.second.first, b = edge.second.second;
+            if (edge.first == numeric_limits<double>::max() || added == n - 1) break;
+            if (degree[a] == 2 || degree[b] == 2 || !fragments.unite(a, b)) continue;
+            link(a, b);
+            added++;
+            taken++;
+        }
+        return taken;
+    };
+
+    vector<int> all(n);
+    for (int i = 0; i < n; ++i) all[i] = i;
+    greedyPass(all);
+
+    // The candidate edges usually leave many paths. Repeat the greedy pass over the path ends only, whose
+    // candidates are now the nearest ends of other paths, while that keeps joining paths
+    while (added < n - 1) {
+        stopIfAsked(control);
+        vector<int> ends;
+        for (int i = 0; i < n; ++i) {
+            if (degree[i] < 2) ends.push_back(i);
+        }
+        if (greedyPass(ends) == 0) break;
+    }
+
+    // Join the few paths that may be left, nearest end first
+    unordered_map<int, vector<int>> endpointsOf;
+    for (int i = 0; i < n; ++i) {
+        if (degree[i] == 0) endpointsOf[fragments.find(i)] = {i, i};
+        else if (degree[i] == 1) endpointsOf[fragments.find(i)].push_back(i);
+    }
+
+    int head = endpointsOf[fragments.find(0)][0];
+    int tail = endpointsOf[fragments.find(0)][1];
+    endpointsOf.erase(fragments.find(0));
+
+    while (!endpointsOf.empty()) {
+        stopIfAsked(control);
+        double bestWeight = numeric_limits<double>::max();
+        int bestFragment = -1, bestEnd = 0;
+        for (auto &fragment : endpointsOf) {
+            for (int e = 0; e < 2; ++e) {
+                double w = weight(tail, fragment.second[e]);
+                if (w < bestWeight) {
+                    bestWeight = w;
+                    bestFragment = fragment.first;
+                    bestEnd = e;
+                }
+            }
+        }
+        if (bestFragment < 0) throw runtime_error("No path found!");
+
+        const vector<int> &ends = endpointsOf[bestFragment];
+        link(tail, ends[bestEnd]);
+        tail = ends[1 - bestEnd];
+        endpointsOf.erase(bestFragment);
+    }
+    if (weight(tail, head) == numeric_limits<double>::max()) throw runtime_error("No path found!");
+    link(tail, head);
+
+    // Walk the cycle from the vertex with the lowest id
+    int previous = -1, current = 0;
+    for (int i = 0; i < n; ++i) {
+        tour.push_back(nodes[current]);
+        int next = links[current][0] != previous ? links[current][0] : links[current][1];
+        previous = current;
+        current = next;
+    }
+
+    res = tourCost(tour);
+    if (control) control->improve(res, tour);
+}
+
+// Method to build a tour using the Clarke-Wright savings heuristic
+void Graph::TSPSavings(double &res, vector<Vertex *> &tour, SolveControl *control) {
+    Instrumentation::PhaseTimer timer(Instrumentation::CONSTRUCTION);
+    tour.clear();
+    vector<Vertex *> nodes;
+    for (auto &pair : vertices) nodes.push_back(pair.second);
+    sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+
+    const int n = (int) nodes.size();
+    if (n < 3) {
+        tour = nodes;
+        res = tourCost(tour);
+        return;
+    }
+
+    // Weight of a pair of vertices, or infinity when the graph gives none
+    auto weight = [&](int a, int b) {
+        Edge *e = nodes[a]->findEdge(nodes[b]->getId());
+        if (e) return e->getWeight();
+        try {
+            return getEdgeWeight(nodes[a], nodes[b]);
+        } catch (const runtime_error &) {
+            return numeric_limits<double>::max();
+        }
+    };
+
+    const int hub = 0;
+    vector<double> hubWeight(n);
+    for (int i = 0; i < n; ++i) hubWeight[i] = weight(hub, i);
+
+    // Saving of joining the routes ending at a and b, or minus infinity when some weight is missing
+    auto saving = [&](int a, int b) {
+        double w = weight(a, b);
+        if (w == numeric_limits<double>::max() || hubWeight[a] == numeric_limits<double>::max() ||
+            hubWeight[b] == numeric_limits<double>::max())
+            return -numeric_limits<double>::max();
+        return hubWeight[a] + hubWeight[b] - w;
+    };
+
+    // Every vertex but the hub starts as a route of its own; otherEnd[i] is the opposite end of the route
+    // ending at i, and only holds for route ends
+    vector<int> degree(n, 0);
+    vector<array<int, 2>> links(n, {-1, -1});
+    vector<int> otherEnd(n);
+    for (int i = 0; i < n; ++i) otherEnd[i] = i;
+    int routes = n - 1;
+
+    auto link = [&](int a, int b) {
+        links[a][degree[a]++] = b;
+        links[b][degree[b]++] = a;
+    };
+    auto merge = [&](int a, int b) {
+        int endA = otherEnd[a], endB = otherEnd[b];
+        link(a, b);
+        otherEnd[endA] = endB;
+        otherEnd[endB] = endA;
+        routes--;
+    };
+
+    // Savings pass over the candidate pairs among a subset of the vertices, largest saving first.
+    // Returns the number of merges made
+    auto savingsPass = [&](const vector<int> &subset) {
+        vector<Vertex *> subsetNodes;
+        for (int i : subset) subsetNodes.push_back(nodes[i]);
+        const vector<vector<int>> candidates = candidateNeighbours(subsetNodes, 10);
+
+        priority_queue<pair<double, pair<int, int>>> heap;
+        for (int i = 0; i < (int) subset.size(); ++i) {
+            for (int j : candidates[i]) {
+                bool listedByJ = find(candidates[j].begin(), candidates[j].end(), i) != candidates[j].end();
+                if (i < j || !listedByJ) {
+                    double s = saving(subset[i], subset[j]);
+                    if (s != -numeric_limits<double>::max()) heap.push({s, {subset[i], subset[j]}});
+                }
+            }
+        }
+
+        int merged = 0;
+        while (!heap.empty() && routes > 1) {
+            int a = heap.top().second.first, b = heap.top().second.second;
+            heap.pop();
+            if (degree[a] == 2 || degree[b] == 2 || otherEnd[a] == b) continue; // Not both ends, or same route
+            merge(a, b);
+            merged++;
+        }
+        return merged;
+    };
+
+    vector<int> others;
+    for (int i = 0; i < n; ++i) {
+        if (i != hub) others.push_back(i);
+    }
+    savingsPass(others);
+
+    // Repeat the pass over the route ends only while that keeps merging routes
+    while (routes > 1) {
+        stopIfAsked(control);
+        vector<int> ends;
+        for (int i = 0; i < n; ++i) {
+            if (i != hub && degree[i] < 2) ends.push_back(i);
+        }
+        if (savingsPass(ends) == 0) break;
+    }
+
+    // Chain the few routes that may be left, largest saving first
+    vector<int> firstEnds;
+    for (int i = 0; i < n; ++i) {
+        if (i != hub && degree[i] < 2 && i <= otherEnd[i]) firstEnds.push_back(i);
+    }
+    int head = firstEnds.back();
+    int tail = otherEnd[head];
+    firstEnds.pop_back();
+
+    while (!firstEnds.empty()) {
+        stopIfAsked(control);
+        double bestSaving = -numeric_limits<double>::max();
+        int bestRoute = -1, bestEnd = -1;
+        for (int r = 0; r < (int) firstEnds.size(); ++r) {
+            for (int end : {firstEnds[r], otherEnd[firstEnds[r]]}) {
+                double s = saving(tail, end);
+                if (s > bestSaving) {
+                    bestSaving = s;
+                    bestRoute = r;
+                    bestEnd = end;
+                }
+            }
+        }
+        if (bestRoute < 0) throw runtime_error("No path found!");
+
+        int newTail = otherEnd[bestEnd];
+        merge(tail, bestEnd);
+        tail = newTail;
+        firstEnds[bestRoute] = firstEnds.back();
+        firstEnds.pop_back();
+    }
+
+    // Close the tour through the hub
+    if (hubWeight[head] == numeric_limits<double>::max() || hubWeight[tail] == numeric_limits<double>::max())
+        throw runtime_error("No path found!");
+    link(hub, head);
+    link(tail, hub);
+
+    // Walk the cycle from the hub, the vertex with the lowest id
+    int previous = -1, current = hub;
+    for (int i = 0; i < n; ++i) {
+        tour.push_back(nodes[current]);
+        int next = links[current][0] != previous ? links[current][0] : links[current][1];
+        previous = current;
+        current = next;
+    }
+
+    res = tourCost(tour);
+    if (control) control->improve(res, tour);
+}
+
+// Method to build a tour using the cheapest insertion heuristic
+void Graph::TSPCheapestInsertion(double &res, vector<Vertex *> &tour, SolveControl *control) {
+    insertionHeuristic(res, tour, false, control);
+}
+
+// Method to build a tour using the farthest insertion heuristic
+void Graph::TSPFarthestInsertion(double &res, vector<Vertex *> &tour, SolveControl *control) {
+    insertionHeuristic(res, tour, true, control);
+}
+
+// Indices of the vertices on the convex hull of their projected coordinates, in order, or empty if some
+// vertex has no coordinates or all of them are collinear
+static vector<int> convexHull(const vector<Vertex *> &nodes) {
+    const int n = (int) nodes.size();
+    double meanLatitude = 0;
+    for (Vertex *v : nodes) {
+        if (v->getLongitude() == numeric_limits<double>::max() || v->getLatitude() == numeric_limits<double>::max())
+            return {};
+        meanLatitude += v->getLatitude();
+    }
+    const double scaleX = cos(convert_to_radians(meanLatitude / max(n, 1)));
+
+    vector<pair<pair<double, double>, int>> points;
+    for (int i = 0; i < n; ++i) points.push_back({{nodes[i]->getLongitude() * scaleX, nodes[i]->getLatitude()}, i});
+    sort(points.begin(), points.end());
+
+    auto cross = [&](int o, int a, int b) {
+        const auto &po = points[o].first, &pa = points[a].first, &pb = points[b].first;
+        return (pa.first - po.first) * (pb.second - po.second) - (pa.second - po.second) * (pb.first - po.first);
+    };
+
+    // Andrew's monotone chain: lower hull then upper hull, dropping collinear points
+    vector<int> hull(2 * n);
+    int k = 0;
+    for (int i = 0; i < n; ++i) {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], i) <= 0) k--;
+        hull[k++] = i;
+    }
+    for (int i = n - 2, lower = k + 1; i >= 0; --i) {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], i) <= 0) k--;
+        hull[k++] = i;
+    }
+    hull.resize(max(k - 1, 0));
+    if (hull.size() < 3) return {};
+
+    for (int &h : hull) h = points[h].second;
+    return hull;
+}
+
+// Method to build a tour by insertion, inserting either the cheapest or the farthest vertex first
+void Graph::insertionHeuristic(double &res, vector<Vertex *> &tour, bool farthest, SolveControl *control) {
+    Instrumentation::PhaseTimer timer(Instrumentation::CONSTRUCTION);
+    tour.clear();
+    vector<Vertex *> nodes;
+    for (auto &pair : vertices) nodes.push_back(pair.second);
+    sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+
+    const int n = (int) nodes.size();
+    if (n < 3) {
+        tour = nodes;
+        res = tourCost(tour);
+        return;
+    }
+
+    auto dist = [&](int a, int b) { return getEdgeWeight(nodes[a], nodes[b]); };
+
+    // The tour is a circular linked list: next[a] follows a, and the edge (a, next[a]) is identified by a
+    vector<int> next(n, -1);
+    vector<char> inTour(n, 0);
+
+    vector<int> start = convexHull(nodes);
+    if (start.empty()) {
+        // Seed cycle: the first vertex and its nearest (cheapest) or farthest (farthest) vertex
+        int other = 1;
+        for (int v = 2; v < n; ++v) {
+            double d = dist(0, v), best = dist(0, other);
+            if (farthest ? d > best : d < best) other = v;
+        }
+        start = {0, other};
+    }
+    for (size_t i = 0; i < start.size(); ++i) {
+        next[start[i]] = start[(i + 1) % start.size()];
+        inTour[start[i]] = 1;
+    }
+    int tourSize = (int) start.size();
+
+    // Per vertex out of the tour: its best insertion edge and cost, and its distance to the tour
+    vector<int> bestEdge(n, -1);
+    vector<double> bestCost(n, numeric_limits<double>::max());
+    vector<double> tourDistance(n, numeric_limits<double>::max());
+
+    // The priority of a vertex is its insertion cost (cheapest) or minus its distance to the tour (farthest).
+    // Outdated entries are left in the queue and skipped when they come out
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> queue;
+    auto priority = [&](int v) { return farthest ? -tourDistance[v] : bestCost[v]; };
+
+    auto insertionCost = [&](int a, int v) {
+        return dist(a, v) + dist(v, next[a]) - dist(a, next[a]);
+    };
+
+    // Full scan of the tour for the best insertion edge of v
+    auto rescan = [&](int v) {
+        bestCost[v] = numeric_limits<double>::max();
+        int a = start[0];
+        do {
+            double cost = insertionCost(a, v);
+            if (cost < bestCost[v]) {
+                bestCost[v] = cost;
+                bestEdge[v] = a;
+            }
+            a = next[a];
+        } while (a != start[0]);
+    };
+
+    // Farthest insertion only needs the best edge of the vertex it picks, so it scans the tour when it picks it
+    for (int v = 0; v < n; ++v) {
+        if (inTour[v]) continue;
+        for (int t : start) tourDistance[v] = min(tourDistance[v], dist(v, t));
+        if (!farthest) rescan(v);
+        queue.push({priority(v), v});
+    }
+
+    while (tourSize < n) {
+        stopIfAsked(control);
+        auto top = queue.top();
+        queue.pop();
+        int x = top.second;
+        if (inTour[x] || top.first != priority(x)) continue; // Outdated entry
+        if (farthest) rescan(x);
+
+        // Insert x in its best edge (a, b)
+        int a = bestEdge[x], b = next[a];
+        next[a] = x;
+        next[x] = b;
+        inTour[x] = 1;
+        tourSize++;
+
+        // Update the caches of the vertices still out of the tour
+        const double ax = dist(a, x), xb = dist(x, b);
+        for (int v = 0; v < n; ++v) {
+            if (inTour[v]) continue;
+            double oldPriority = priority(v);
+            double dvx = dist(v, x);
+            tourDistance[v] = min(tourDistance[v], dvx);
+
+            if (farthest) {
+                if (priority(v) != oldPriority) queue.push({priority(v), v});
+                continue;
+            }
+            if (bestEdge[v] == a) {
+                rescan(v); // Its best edge no longer exists
+            } else {
+                double viaAX = dist(a, v) + dvx - ax;
+                double viaXB = dvx + dist(v, b) - xb;
+                if (viaAX < bestCost[v]) {
+                    bestCost[v] = viaAX;
+                    bestEdge[v] = a;
+                }
+                if (viaXB < bestCost[v]) {
+                    bestCost[v] = viaXB;
+                    bestEdge[v] = x;
+                }
+            }
+            if (priority(v) != oldPriority) queue.push({priority(v), v});
+        }
+    }
+
+    // Walk the cycle from the vertex with the lowest id
+    int current = 0;
+    for (int i = 0; i < n; ++i) {
+        tour.push_back(nodes[current]);
+        current = next[current];
+    }
+
+    res = tourCost(tour);
+    if (control) control->improve(res, tour);
+}
+
+// Method to compute the candidate neighbours of each vertex
+vector<vector<int>> Graph::candidateNeighbours(const vector<Vertex *> &nodes, int k, bool edgesOnly) {
+    const int n = (int) nodes.size();
+    k = min(k, n - 1);
+
+    vector<vector<int>> candidates(n);
+    vector<pair<double, int>> options;
+
+    bool coordinates = !edgesOnly;
+    for (int i = 0; i < n && coordinates; ++i) {
+        if (nodes[i]->getLongitude() == numeric_limits<double>::max() || nodes[i]->getLatitude() == numeric_limits<double>::max())
+            coordinates = false;
+    }
+
+    if (!coordinates) {
+        // Only the existing edges are known
+        unordered_map<int, int> indexOf;
+        for (int i = 0; i < n; ++i) indexOf[nodes[i]->getId()] = i;
+
+        for (int i = 0; i < n; ++i) {
+            options.clear();
+            for (auto &pair : nodes[i]->getAdj()) {
+                auto it = indexOf.find(pair.first);
+                if (it != indexOf.end() && it->second != i) options.emplace_back(pair.second->getWeight(), it->second);
+            }
+
+            int count = min(k, (int) options.size());
+            partial_sort(options.begin(), options.begin() + count, options.end());
+            for (int c = 0; c < count; ++c) candidates[i].push_back(options[c].second);
+        }
+        return candidates;
+    }
+
+    // With coordinates every pair has a weight. To avoid looking at all pairs, the vertices are bucketed in a
+    // grid over the equirectangular projection, and the rings of cells around each vertex are searched until
+    // the k nearest vertices on the plane are known. Those are then ranked by getEdgeWeight
+    double meanLatitude = 0;
+    for (Vertex *v : nodes) meanLatitude += v->getLatitude();
+    const double scaleX = cos(convert_to_radians(meanLatitude / max(n, 1)));
+
+    vector<double> xs(n), ys(n);
+    double minX = numeric_limits<double>::max(), minY = numeric_limits<double>::max();
+    double maxX = numeric_limits<double>::lowest(), maxY = numeric_limits<double>::lowest();
+    for (int i = 0; i < n; ++i) {
+        xs[i] = nodes[i]->getLongitude() * scaleX;
+        ys[i] = nodes[i]->getLatitude();
+        minX = min(minX, xs[i]);
+        maxX = max(maxX, xs[i]);
+        minY = min(minY, ys[i]);
+        maxY = max(maxY, ys[i]);
+    }
+
+    // About 2 vertices per cell
+    const int side = max(1, (int) sqrt(n / 2.0));
+    double cellSize = max(maxX - minX, maxY - minY) / side;
+    if (cellSize <= 0) cellSize = 1;
+    auto cellOf = [&](double value, double minimum) { return min(side - 1, (int) ((value - minimum) / cellSize)); };
+
+    // Counting sort of the vertices by cell
+    vector<int> cellStart(side * side + 1, 0), cellItems(n), cellX(n), cellY(n);
+    for (int i = 0; i < n; ++i) {
+        cellX[i] = cellOf(xs[i], minX);
+        cellY[i] = cellOf(ys[i], minY);
+        cellStart[cellY[i] * side + cellX[i] + 1]++;
+    }
+    for (int c = 0; c < side * side; ++c) cellStart[c + 1] += cellStart[c];
+    vector<int> cellFill(cellStart.begin(), cellStart.end() - 1);
+    for (int i = 0; i < n; ++i) cellItems[cellFill[cellY[i] * side + cellX[i]]++] = i;
+
+    vector<pair<double, int>> gathered;
+    for (int i = 0; i < n; ++i) {
+        gathered.clear();
+
+        for (int r = 0; r <= side; ++r) {
+            // Visit the cells at Chebyshev distance r from the cell of i
+            for (int cy = cellY[i] - r; cy <= cellY[i] + r; ++cy) {
+                if (cy < 0 || cy >= side) continue;
+                bool edgeRow = cy == cellY[i] - r || cy == cellY[i] + r;
+                for (int cx = cellX[i] - r; cx <= cellX[i] + r; cx += edgeRow ? 1 : 2 * r) {
+                    if (cx >= 0 && cx < side) {
+                        int c = cy * side + cx;
+                        for (int t = cellStart[c]; t < cellStart[c + 1]; ++t) {
+                            int j = cellItems[t];
+                            if (j == i) continue;
+                            double dx = xs[i] - xs[j], dy = ys[i] - ys[j];
+                            gathered.emplace_back(dx * dx + dy * dy, j); // Squared distance on the plane
+                        }
+                    }
+                    if (r == 0) break;
+                }
+            }
+
+            // Every vertex closer than r cells has been seen, so stop once k of them are
+            int covered = 0;
+            for (auto &g : gathered) covered += g.first <= (r * cellSize) * (r * cellSize);
+            if (covered >= k) break;
+        }
+
+        // Only the nearest on the map are worth a getEdgeWeight call; keep some slack for the projection error
+        size_t keep = min(gathered.size(), (size_t) 2 * k);
+        nth_element(gathered.begin(), gathered.begin() + (long) keep, gathered.end());
+        gathered.resize(keep);
+
+        options.clear();
+        for (auto &g : gathered) options.emplace_back(getEdgeWeight(nodes[i], nodes[g.second]), g.second);
+
+        int count = min(k, (int) options.size());
+        partial_sort(options.begin(), options.begin() + count, options.end());
+        for (int c = 0; c < count; ++c) candidates[i].push_back(options[c].second);
+    }
+
+    return candidates;
+}
+
+// Method to solve TSP using an island model genetic algorithm
+void Graph::TSPGeneticAlgorithm(double &res, vector<Vertex *> &tour, unsigned int islands, double timeBudget,
+                                SolveControl *control) {
+    // Seed tours: nearest neighbor and, when the graph allows it, the MST preorder
+    double nearestCost = 0;
+    vector<Vertex *> nearestTour;
+    TSPNearestNeighbor(nearestCost, nearestTour, control);
+    tour = nearestTour;
+    res = nearestCost;
+
+    const int n = (int) nearestTour.size();
+
+    vector<Vertex *> mstTour;
+    try {
+        double mstCost = 0;
+        TSPTriangular(mstCost, mstTour, control);
+        if ((int) mstTour.size() != n) mstTour.clear();
+        else if (mstCost < res) {
+            tour = mstTour;
+            res = mstCost;
+        }
+    } catch (const runtime_error &e) {
+        mstTour.clear(); // The graph does not allow the MST seed, so use the nearest neighbor one alone
+    }
+
+    if (control) timeBudget = min(timeBudget, control->remaining());
+    if (n < 8 || timeBudget <= 0) return;
+
+    if (islands == 0) islands = threadPool().size();
+
+    // Islands work on indices into the nearest neighbor tour, which stays read-only while they run
+    const vector<Vertex *> nodes = nearestTour;
+    auto dist = [&](int a, int b) { return getEdgeWeight(nodes[a], nodes[b]); };
+    auto cost = [&](const vector<int> &t) {
+        double total = 0;
+        for (int i = 0; i < n; ++i) total += dist(t[i], t[(i + 1) % n]);
+        return total;
+    };
+
+    vector<vector<int>> seeds(1, vector<int>(n));
+    for (int i = 0; i < n; ++i) seeds[0][i] = i;
+    if (!mstTour.empty()) {
+        unordered_map<int, int> indexOf;
+        for (int i = 0; i < n; ++i) indexOf[nodes[i]->getId()] = i;
+        seeds.emplace_back(n);
+        for (int i = 0; i < n; ++i) seeds[1][i] = indexOf[mstTour[i]->getId()];
+    }
+
+    const vector<vector<int>> candidates = candidateNeighbours(nodes, 8);
+    const int populationSize = 20;
+
+    struct Island {
+        vector<vector<int>> population;
+        vector<double> costs;
+        mt19937 rng;
+        exception_ptr error;
+    };
+
+    vector<Island> isl(islands);
+    for (unsigned int k = 0; k < islands; ++k) isl[k].rng.seed(k + 1);
+
+    const auto start = chrono::steady_clock::now();
+    const auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeBudget));
+    const auto epochLength = (deadline - start) / 20; // Islands migrate 20 times over the run
+
+    // Mutation: reverse a random segment, then improve the tour with the candidate 2-opt
+    auto mutate = [&](vector<int> &t, vector<int> &pos, mt19937 &rng, bool perturb) {
+        if (perturb) {
+            int a = (int) (rng() % n), b = (int) (rng() % n);
+            for (int i = 0; i < n; ++i) pos[t[i]] = i;
+            reverseSegment(t, pos, min(a, b), max(a, b));
+        }
+        twoOptCandidates(t, pos, candidates, dist);
+    };
+
+    // Evolves a single island until the end of the current epoch
+    auto evolve = [&](Island &island, chrono::steady_clock::time_point epochEnd) {
+        Instrumentation::TraceSpan span("evolve", ThreadPool::workerIndex());
+        try {
+            vector<int> pos(n), child(n);
+            vector<char> used(n);
+
+            // Populate the island from the seeds the first time it runs
+            while ((int) island.population.size() < populationSize) {
+                vector<int> t = seeds[island.population.size() % seeds.size()];
+                mutate(t, pos, island.rng, island.population.size() >= seeds.size());
+                island.costs.push_back(cost(t));
+                island.population.push_back(move(t));
+            }
+
+            auto tournament = [&]() -> const vector<int> & {
+                int a = (int) (island.rng() % populationSize), b = (int) (island.rng() % populationSize);
+                return island.costs[a] <= island.costs[b] ? island.population[a] : island.population[b];
+            };
+
+            while (chrono::steady_clock::now() < epochEnd && !(control && control->stopped())) {
+                const vector<int> &p1 = tournament();
+                const vector<int> &p2 = tournament();
+
+                // Order crossover: keep p1[a..b] in place and fill the rest in the order of p2
+                int a = (int) (island.rng() % n), b = (int) (island.rng() % n);
+                if (a > b) swap(a, b);
+                fill(used.begin(), used.end(), 0);
+                for (int i = a; i <= b; ++i) {
+                    child[i] = p1[i];
+                    used[p1[i]] = 1;
+                }
+                int next = (b + 1) % n;
+                for (int i = 0; i < n; ++i) {
+                    int v = p2[(b + 1 + i) % n];
+                    if (used[v]) continue;
+                    child[next] = v;
+                    next = (next + 1) % n;
+                }
+
+                mutate(child, pos, island.rng, island.rng() % 5 == 0);
+                double childCost = cost(child);
+
+                // Steady-state replacement of the worst member, skipping duplicates
+                int worst = (int) (max_element(island.costs.begin(), island.costs.end()) - island.costs.begin());
+                if (childCost >= island.costs[worst]) continue;
+                if (find(island.costs.begin(), island.costs.end(), childCost) != island.costs.end()) continue;
+                island.population[worst] = child;
+                island.costs[worst] = childCost;
+            }
+        } catch (...) {
+            island.error = current_exception();
+        }
+    };
+
+    // Run the islands epoch by epoch, migrating the best tours in between
+    Instrumentation::PhaseTimer timer(Instrumentation::IMPROVEMENT);
+    while (chrono::steady_clock::now() < deadline && !(control && control->stopped())) {
+        auto epochEnd = min(deadline, chrono::steady_clock::now() + epochLength);
+
+        runEpoch(isl.size(), epochEnd, [&](size_t k, chrono::steady_clock::time_point end) { evolve(isl[k], end); });
+
+        for (auto &island : isl) {
+            if (island.error) rethrow_exception(island.error);
+        }
+
+        // Publish the best tour of all islands, if it improves on the best one so far
+        if (control) {
+            const vector<int> *best = nullptr;
+            double bestCost = control->bestCost();
+            for (auto &island : isl) {
+                for (size_t m = 0; m < island.population.size(); ++m) {
+                    if (island.costs[m] < bestCost) {
+                        best = &island.population[m];
+                        bestCost = island.costs[m];
+                    }
+                }
+            }
+            if (best) {
+                vector<Vertex *> bestTour(n);
+                for (int i = 0; i < n; ++i) bestTour[i] = nodes[(*best)[i]];
+                control->improve(bestCost, bestTour);
+            }
+        }
+
+        if (islands < 2) continue;
+
+        // Ring migration: the best tour of each island replaces the worst tour of the next one
+        vector<int> bestOf(islands);
+        for (unsigned int k = 0; k < islands; ++k) {
+            bestOf[k] = (int) (min_element(isl[k].costs.begin(), isl[k].costs.end()) - isl[k].costs.begin());
+        }
+        vector<vector<int>> migrants(islands);
+        for (unsigned int k = 0; k < islands; ++k) migrants[k] = isl[k].population[bestOf[k]];
+        for (unsigned int k = 0; k < islands; ++k) {
+            Island &target = isl[(k + 1) % islands];
+            double migrantCost = isl[k].costs[bestOf[k]];
+            int worst = (int) (max_element(target.costs.begin(), target.costs.end()) - target.costs.begin());
+            if (migrantCost < target.costs[worst]) {
+                target.population[worst] = migrants[k];
+                target.costs[worst] = migrantCost;
+            }
+        }
+    }
+
+    // Take the best tour over all islands, rotated to start at the starting vertex
+    for (auto &island : isl) {
+        if (island.population.empty()) continue;
+        int best = (int) (min_element(island.costs.begin(), island.costs.end()) - island.costs.begin());
+        if (island.costs[best] >= res) continue;
+
+        const vector<int> &t = island.population[best];
+        int offset = (int) (find(t.begin(), t.end(), 0) - t.begin());
+        for (int i = 0; i < n; ++i) tour[i] = nodes[t[(offset + i) % n]];
+        res = island.costs[best];
+    }
+    res = tourCost(tour);
+}
+
+// Method to solve TSP using ant colony optimization over the existing edges
+void Graph::TSPAntColony(double &res, vector<Vertex *> &tour, int startingVertexId, unsigned int threads, double timeBudget,
+                         SolveControl *control) {
+    if (findVertex(startingVertexId) == nullptr) throw runtime_error("Vertex not found!");
+
+    vector<Vertex *> nodes;
+    for (auto &pair : vertices) nodes.push_back(pair.second);
+    sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+
+    const int n = (int) nodes.size();
+    unordered_map<int, int> indexOf;
+    for (int i = 0; i < n; ++i) indexOf[nodes[i]->getId()] = i;
+
+    // Pheromone and heuristic information only exist for the candidate edges, stored in n * k slots
+    const int k = 10;
+    const vector<vector<int>> candidates = candidateNeighbours(nodes, k, true);
+    vector<int> slotStart(n + 1, 0);
+    for (int i = 0; i < n; ++i) slotStart[i + 1] = slotStart[i] + (int) candidates[i].size();
+    vector<int> slotDest(slotStart[n]);
+    vector<double> slotWeight(slotStart[n]);
+    double weightSum = 0;
+    for (int i = 0; i < n; ++i) {
+        for (int c = 0; c < (int) candidates[i].size(); ++c) {
+            int s = slotStart[i] + c;
+            slotDest[s] = candidates[i][c];
+            slotWeight[s] = nodes[i]->findEdge(nodes[slotDest[s]]->getId())->getWeight();
+            weightSum += slotWeight[s];
+        }
+    }
+    if (slotDest.empty()) throw runtime_error("No path found!");
+
+    const double alpha = 1, beta = 2, rho = 0.1;
+    const double averageWeight = max(weightSum / (double) slotDest.size(), 1e-9);
+    const auto eta = [&](double weight) { return pow(1.0 / max(weight, 1e-9), beta); };
+
+    // Before any tour is known, estimate its length as n average candidate edges
+    double tauMax = 1.0 / (rho * n * averageWeight);
+    double tauMin = tauMax / (2.0 * n);
+    const double tau0 = tauMax;
+    vector<double> pheromone(slotDest.size(), tau0);
+    vector<double> choice(slotDest.size());
+
+    if (threads == 0) threads = threadPool().size();
+    const int ants = max(8, (int) threads);
+    const size_t antsPerTask = (ants + threads - 1) / threads;
+
+    struct Ant {
+        vector<int> tour;
+        double cost = numeric_limits<double>::max();
+    };
+    vector<Ant> colony(ants);
+
+    // Vertices that have each vertex as a candidate, to keep the count of unvisited candidates up to date
+    vector<vector<int>> candidateOf(n);
+    for (int i = 0; i < n; ++i) {
+        for (int c : candidates[i]) candidateOf[c].push_back(i);
+    }
+
+    // Scratch memory of the thread building a tour
+    struct Workspace {
+        vector<char> visited;
+        vector<int> freeCandidates;
+        vector<pair<double, pair<int, double>>> options; // (sort key, (vertex, weight)) of every open frame
+        mt19937 rng;
+    };
+
+    struct Frame {
+        size_t begin, end, cursor; // Range of this vertex's options in the workspace
+        double cost;               // Cost of the path up to this vertex
+    };
+
+    // Builds the tour of one ant. The ant walks like a depth-first search: vertices are tried in a random
+    // order biased by pheromone^alpha * eta^beta and, on sparse graphs, by Warnsdorff's rule (vertices with
+    // few unvisited candidates left go first, as they would soon become dead ends). When the ant gets stuck it
+    // backtracks, up to a budget of steps; an ant that runs out of steps keeps an infinite cost
+    auto walk = [&](Ant &ant, Workspace &w) {
+        uniform_real_distribution<double> unit(0.0, 1.0);
+        fill(w.visited.begin(), w.visited.end(), 0);
+        for (int i = 0; i < n; ++i) w.freeCandidates[i] = (int) candidates[i].size();
+        w.options.clear();
+        ant.tour.clear();
+        ant.cost = numeric_limits<double>::max();
+
+        vector<Frame> frames;
+
+        // Visits v and pushes its options, ordered by a weighted random permutation
+        auto push = [&](int v, double cost) {
+            w.visited[v] = 1;
+            ant.tour.push_back(v);
+            for (int u : candidateOf[v]) w.freeCandidates[u]--;
+
+            size_t begin = w.options.size();
+            for (int s = slotStart[v]; s < slotStart[v + 1]; ++s) {
+                int u = slotDest[s];
+                if (w.visited[u]) continue;
+                double bias = choice[s] / pow(1 + w.freeCandidates[u], 2);
+                w.options.push_back({log(max(unit(w.rng), 1e-300)) / bias, {u, slotWeight[s]}});
+            }
+            if (w.options.size() == begin) {
+                // Every candidate was visited, so fall back to the other edges, lightest first
+                for (auto &pair : nodes[v]->getAdj()) {
+                    auto it = indexOf.find(pair.first);
+                    if (it == indexOf.end() || w.visited[it->second]) continue;
+                    w.options.push_back({-pair.second->getWeight(), {it->second, pair.second->getWeight()}});
+                }
+            }
+            sort(w.options.begin() + (long) begin, w.options.end(), greater<>());
+            frames.push_back({begin, w.options.size(), begin, cost});
+        };
+
+        auto pop = [&]() {
+            int v = ant.tour.back();
+            w.visited[v] = 0;
+            ant.tour.pop_back();
+            for (int u : candidateOf[v]) w.freeCandidates[u]++;
+            w.options.resize(frames.back().begin);
+            frames.pop_back();
+        };
+
+        const int first = (int) (w.rng() % n);
+        push(first, 0);
+
+        for (long steps = 0; !frames.empty() && steps < 20L * n && !(control && control->shouldStop()); ++steps) {
+            Frame &frame = frames.back();
+            int current = ant.tour.back();
+
+            if ((int) ant.tour.size() == n) {
+                Edge *closing = nodes[current]->findEdge(nodes[first]->getId());
+                if (closing) {
+                    ant.cost = frame.cost + closing->getWeight();
+                    return;
+                }
+                pop();
+                continue;
+            }
+
+            if (frame.cursor == frame.end) {
+                pop(); // Dead end: backtrack
+                continue;
+            }
+
+            auto option = w.options[frame.cursor++].second;
+            push(option.first, frame.cost + option.second);
+        }
+        ant.tour.clear();
+    };
+
+    // Adds pheromone to both directions of an edge, if they are candidate edges
+    auto deposit = [&](int a, int b, double amount) {
+        for (int s = slotStart[a]; s < slotStart[a + 1]; ++s) {
+            if (slotDest[s] == b) pheromone[s] += amount;
+        }
+        for (int s = slotStart[b]; s < slotStart[b + 1]; ++s) {
+            if (slotDest[s] == a) pheromone[s] += amount;
+        }
+    };
+
+    vector<int> best;
+    double bestCost = numeric_limits<double>::max();
+
+    if (control) timeBudget = min(timeBudget, control->remaining());
+    const auto start = chrono::steady_clock::now();
+    const auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeBudget));
+
+    Instrumentation::PhaseTimer timer(Instrumentation::IMPROVEMENT);
+    for (unsigned int iteration = 0; iteration == 0 || (chrono::steady_clock::now() < deadline && !(control && control->stopped())); ++iteration) {
+        for (size_t s = 0; s < slotDest.size(); ++s) choice[s] = pow(pheromone[s], alpha) * eta(slotWeight[s]);
+
+        // Ants build their tours in parallel, a range of ants per task, each keeping the best ant of its range;
+        // every ant has its own seed, so the tours do not depend on the thread that builds them
+        auto better = [&](int a, int b) {
+            return b >= 0 && colony[b].cost != numeric_limits<double>::max() && (a < 0 || colony[b].cost < colony[a].cost);
+        };
+        int iterationBest = threadPool().parallelReduce(0, ants, antsPerTask, -1, [&](size_t begin, size_t end) {
+            Instrumentation::TraceSpan span("ants", ThreadPool::workerIndex());
+            Workspace w{vector<char>(n), vector<int>(n), {}, mt19937()};
+            int rangeBest = -1;
+            for (int a = (int) begin; a < (int) end; ++a) {
+                w.rng.seed(iteration * ants + a + 1);
+                walk(colony[a], w);
+                if (better(rangeBest, a)) rangeBest = a;
+            }
+            return rangeBest;
+        }, [&](int a, int b) { return better(a, b) ? b : a; });
+        if (iterationBest < 0) continue;
+        if (colony[iterationBest].cost < bestCost) {
+            best = colony[iterationBest].tour;
+            bestCost = colony[iterationBest].cost;
+            tauMax = 1.0 / (rho * bestCost);
+            tauMin = tauMax / (2.0 * n);
+            if (control) {
+                vector<Vertex *> bestTour(n);
+                for (int i = 0; i < n; ++i) bestTour[i] = nodes[best[i]];
+                control->improve(bestCost, bestTour);
+            }
+        }
+
+        // Batched pheromone update for the whole iteration
+        for (double &tau : pheromone) tau *= (1 - rho);
+        const vector<int> &t = colony[iterationBest].tour;
+        for (int i = 0; i < n; ++i) deposit(t[i], t[(i + 1) % n], 1.0 / colony[iterationBest].cost);
+        for (double &tau : pheromone) tau = min(tauMax, max(tauMin, tau));
+    }
+
+    if (best.empty()) throw runtime_error(control && control->stopped() ? "Stopped before a tour was found." : "No path found!");
+
+    // Rotate the best tour so it starts at the starting vertex
+    int offset = (int) (find(best.begin(), best.end(), indexOf[startingVertexId]) - best.begin());
+    tour.resize(n);
+    for (int i = 0; i < n; ++i) tour[i] = nodes[best[(offset + i) % n]];
+    res = bestCost;
+}
+
+// Method to solve TSP using real-world nearest neighbor heuristic
+void Graph::TSPRealWorldNearestNeighbor(double &res, int startingVertexId) {
+    vector<Vertex *> tour;
+    TSPRealWorldNearestNeighbor(res, tour, startingVertexId);
+}
+
+// Method to perform TSP using real-world nearest neighbor heuristic, returning the tour
+void Graph::TSPRealWorldNearestNeighbor(double &res, vector<Vertex *> &tour, int startingVertexId,
+                                        SolveControl *control) {
+    tour.clear();
+    vector<Vertex *> nodes;
+    for (auto &pair : vertices) nodes.push_back(pair.second);
+    sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+
+    MetricClosure &metric = getMetricClosure();
+    const int n = metric.size();
+
+    // Start from a specified vertex
+    int start = metric.indexOf(startingVertexId);
+    if (start < 0) throw runtime_error("No neighbour vertex found!");
+
+    vector<char> visited(n, 0);
+    visited[start] = 1;
+    int v = start;
+    tour.push_back(nodes[start]);
+
+    // Main loop of the real-world nearest neighbor heuristic
+    Instrumentation::PhaseTimer timer(Instrumentation::CONSTRUCTION);
+    for (int count = 1; count < n; ++count) {
+        stopIfAsked(control);
+        shared_ptr<const vector<double>> distances = metric.row(v);
+
+        // Find the nearest unvisited vertex considering shortest-path distances
+        double currentWeight = numeric_limits<double>::max();
+        int nearestNeighbor = -1;
+        for (int u = 0; u < n; ++u) {
+            if (visited[u]) continue;
+            if ((*distances)[u] < currentWeight) {
+                currentWeight = (*distances)[u];
+                nearestNeighbor = u;
+            }
+        }
+
+        // Handle cases where no vertex can be reached
+        if (nearestNeighbor < 0) throw runtime_error("No path found!");
+        visited[nearestNeighbor] = 1;
+
+        res += currentWeight;
+        v = nearestNeighbor;
+        tour.push_back(nodes[v]);
+    }
+
+    // Go back to the starting vertex to complete the cycle
+    double weight = metric.pointDistance(v, start);
+    if (weight == numeric_limits<double>::max()) throw runtime_error("No path found!");
     res += weight;
+    if (control) control->improve(res, tour);
+}
+
+// Method to expand a tour into the vertices of the shortest paths between its consecutive vertices
+void Graph::expandTour(const vector<Vertex *> &tour, const function<void(Vertex *)> &visit) {
+    if (tour.empty()) return;
 
-    if (res >= numeric_limits<double>::max()) throw runtime_error("No path found!");
+    vector<Vertex *> nodes;
+    for (auto &pair : vertices) nodes.push_back(pair.second);
+    sort(nodes.begin(), nodes.end(), [](Vertex *a, Vertex *b) { return a->getId() < b->getId(); });
+
+    MetricClosure &metric = getMetricClosure();
+    visit(tour.front());
+    for (size_t i = 0; i < tour.size(); ++i) {
+        int from = metric.indexOf(tour[i]->getId());
+        int to = metric.indexOf(tour[(i + 1) % tour.size()]->getId());
+        if (!metric.path(from, to, [&](int v) { visit(nodes[v]); })) throw runtime_error("No path found!");
+    }
 }
@@ -2,6 +2,12 @@
 #define FEUP_DA_PROJECT_2_GRAPH_H
 
 #include "MutablePriorityQueue.h"
+#include "IndexedPriorityQueue.h"
+#include "SpanningTree.h"
+#include "Instrumentation.h"
+#include "Memory.h"
+#include "SolveControl.h"
+#include "ThreadPool.h"
 
 #include <iostream>
 #include <vector>
@@ -11,10 +17,16 @@
 #include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <string>
 
 using namespace std;
 
 class Edge;
+class MetricClosure;
+class ContractionHierarchy;
 
 /************************* Vertex  **************************/
 
@@ -35,7 +47,7 @@ private:
 
     int queueIndex = 0; 		// required by MutablePriorityQueue
 
-    friend class MutablePriorityQueue<Vertex>;
+    template <class, unsigned> friend class MutablePriorityQueue;
 
 public:
 
@@ -89,7 +101,7 @@ public:
      *
      * @return Vector of pointers to adjacent edges.
      */
-    [[nodiscard]] unordered_map<int, Edge *> getAdj() const;
+    [[nodiscard]] const unordered_map<int, Edge *> &getAdj() const;
 
     /**
      * @brief Check if the vertex has been visited.
@@ -218,6 +230,46 @@ public:
     void setReverse(Edge *reverseEdge);
 };
 
+/********************** GraphAnalysis  ****************************/
+
+/**
+ * @brief Structural facts about a graph that decide, before running anything, whether a tour can exist.
+ *
+ * @details Computed by Graph::analyse. A Hamiltonian cycle over the edges of the graph needs the graph to be
+ * connected and 2-vertex-connected: every vertex needs two neighbours, and a cycle through all vertices can
+ * neither cross a bridge (it would have to cross it twice) nor pass an articulation point twice. A closed walk
+ * that may repeat vertices, as built from shortest-path distances, only needs the graph to be connected.
+ */
+struct GraphAnalysis {
+    int vertices = 0;
+    int components = 0;
+    bool coordinates = false;               // every vertex has coordinates
+    vector<int> lowDegreeVertices;          // ids of the vertices with fewer than two neighbours
+    vector<int> articulationPoints;         // ids of the vertices whose removal disconnects the graph
+    vector<pair<int, int>> bridges;         // ids of the ends of the edges whose removal disconnects the graph
+
+    /**
+     * @brief Explains why no Hamiltonian cycle can be built over the edges of the graph.
+     *
+     * @return The reason, or an empty string if the analysis does not rule such a cycle out.
+     */
+    string hamiltonianCycleObstacle() const;
+
+    /**
+     * @brief Explains why no closed walk can visit every vertex of the graph.
+     *
+     * @return The reason (the graph is not connected), or an empty string if such a walk exists.
+     */
+    string closedWalkObstacle() const;
+
+    /**
+     * @brief Explains why some pair of vertices has no distance at all, neither by coordinates nor by a path.
+     *
+     * @return The reason, or an empty string if getEdgeWeight can answer for every pair of vertices.
+     */
+    string distanceObstacle() const;
+};
+
 /********************** Graph  ****************************/
 
 /**
@@ -227,9 +279,109 @@ public:
 class Graph {
 private:
     unordered_map<int, Vertex *> vertices;    // vertex set
+    unique_ptr<ContractionHierarchy> hierarchy; // optional index, see setContractionHierarchy
+    unique_ptr<MetricClosure> closure;      // built on first use, see getMetricClosure
+    once_flag closureBuilt;
+    mutex scratchMutex;     // held by TSPBacktracking, which uses the visited flags of the vertices
+    ThreadPool *pool = nullptr; // runs the parallel algorithms, see setThreadPool
+    HeapKind heap = HeapKind::DEFAULT;  // queue of prim and of the metric closure, see setHeap
+
+    /**
+     * @brief Builds a tour by insertion, shared by the cheapest and farthest insertion heuristics.
+     *
+     * @details See TSPCheapestInsertion and TSPFarthestInsertion.
+     *
+     * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
+     * @param tour Reference to the vector to store the vertices in visiting order.
+     * @param farthest True to insert the farthest vertex first, false to insert the cheapest one first.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); std::runtime_error is thrown
+     * if it stops the run before the tour is complete.
+     */
+    void insertionHeuristic(double &res, vector<Vertex *> &tour, bool farthest, SolveControl *control);
+
+    /**
+     * @brief Extends a path by every unvisited neighbour in turn, for TSPBacktracking with a tour.
+     *
+     * @param current The last vertex of the path.
+     * @param start The first vertex of the path, which closes the cycle.
+     * @param path The vertices of the path, current last.
+     * @param cost The cost of the path.
+     * @param res The cost of the best cycle found so far.
+     * @param tour The best cycle found so far.
+     * @param control Optional deadline, cancellation and progress; the search unwinds when it stops.
+     */
+    void backtrack(Vertex *current, Vertex *start, vector<Vertex *> &path, double cost, double &res,
+                   vector<Vertex *> &tour, SolveControl *control);
+
+    /**
+     * @brief Lists the existing edges, each once, for the spanning tree algorithms.
+     *
+     * @param nodes Reference to the vector to store the vertices sorted by id; edges refer to their positions.
+     *
+     * @return The edges, with every pair of opposite edges taken once.
+     *
+     * @complexity O(|V| log |V| + |E|).
+     */
+    vector<SpanningTree::WeightedEdge> edgeList(vector<Vertex *> &nodes) const;
+
+    /**
+     * @brief Builds a minimum spanning tree over the existing edges, shared by kruskal and boruvka.
+     *
+     * @param parallel True to use SpanningTree::boruvka, false to use SpanningTree::kruskal.
+     * @param nodes The vertices of the graph, in any order.
+     * @param parent Filled with the position in nodes of the parent of every vertex, -1 if it has none.
+     *
+     * @return True if the tree spans every vertex, false if the graph is not connected.
+     */
+    bool spanningTree(bool parallel, const vector<Vertex *> &nodes, vector<int> &parent);
+
+    /**
+     * @brief Gets the pool that runs the parallel algorithms.
+     *
+     * @return The pool set with setThreadPool, or ThreadPool::serial if none was.
+     */
+    ThreadPool &threadPool() const;
+
+    /**
+     * @brief Runs an epoch of the replicas of a metaheuristic (the replicas of TSPSimulatedAnnealing, the islands
+     * of TSPGeneticAlgorithm) on the thread pool, side by side.
+     *
+     * @details Each replica is a task that runs until the end of the epoch. When there are more replicas than
+     * threads in the pool, they run in waves that split the epoch between them, so every replica gets its share.
+     *
+     * @param count The number of replicas.
+     * @param epochEnd The time the epoch ends.
+     * @param body Called with the index of a replica and the time it must stop by, from the threads of the pool.
+     *
+     * @throws The first exception thrown by body.
+     */
+    void runEpoch(size_t count, chrono::steady_clock::time_point epochEnd,
+                  const function<void(size_t, chrono::steady_clock::time_point)> &body) const;
 
 public:
 
+    /**
+     * @brief Largest fraction of the vertex pairs joined by an edge for which a graph counts as sparse.
+     *
+     * @details Sparse graphs get their minimum spanning tree from their edges alone (see kruskal).
+     */
+    static constexpr double SPARSE_FILL = 0.5;
+
+    /**
+     * @brief Smallest number of edges for which the minimum spanning tree is built in parallel (see boruvka).
+     */
+    static constexpr size_t PARALLEL_MST_MIN_EDGES = 1 << 16;
+
+    /**
+     * @brief Constructs an empty graph.
+     */
+    Graph();
+
+    /**
+     * @brief Destroys the graph, together with its metric closure if one was built.
+     */
+    ~Graph();
+
     /**
      * @brief Finds a vertex in the graph based on its id.
      *
@@ -340,6 +492,89 @@ public:
      */
     unordered_map<int, Vertex *> getVertexSet() const;
 
+    /**
+     * @brief Returns the metric closure (shortest-path distances) of the graph.
+     *
+     * @details The closure is built once, on the first call, over all vertices sorted by id, so the graph must be
+     * fully loaded by then and must not change afterwards. Concurrent first calls wait for it to be built; later
+     * calls take no lock. See MetricClosure.
+     *
+     * @return A reference to the metric closure of the graph.
+     *
+     * @complexity O(1) after the first call; see the MetricClosure constructor for the first one.
+     */
+    MetricClosure &getMetricClosure();
+
+    /**
+     * @brief Sets the thread pool that runs the parallel algorithms (spanning trees, metric closure and
+     * metaheuristics), instead of each starting threads of its own.
+     *
+     * @details The pool is not owned, and must outlive the graph or be replaced first. Set it before the metric
+     * closure is built, as the closure keeps the pool it was built with. Without a pool, the algorithms run on
+     * the calling thread (see ThreadPool::serial).
+     *
+     * @param threads The pool, or nullptr for none.
+     */
+    void setThreadPool(ThreadPool *threads);
+
+    /**
+     * @brief Sets the priority queue of Prim's algorithm and of the Dijkstra searches of the metric closure.
+     *
+     * @details See HeapKind. Like the pool, set it before the metric closure is built, as the closure keeps the
+     * queue it was built with. The queue changes the speed of the searches, and possibly the order of ties.
+     *
+     * @param kind The queue.
+     */
+    void setHeap(HeapKind kind);
+
+    /**
+     * @brief Sets the contraction hierarchy index of the graph.
+     *
+     * @details The index must have been built over all vertices sorted by id. The metric closure uses it, when
+     * it is built afterwards, to answer distance queries not covered by its row cache.
+     *
+     * @param index The contraction hierarchy of the graph.
+     *
+     * @complexity O(1)
+     */
+    void setContractionHierarchy(unique_ptr<ContractionHierarchy> index);
+
+    /**
+     * @brief Returns the contraction hierarchy index of the graph, if one was set.
+     *
+     * @return A pointer to the contraction hierarchy, or nullptr if there is none.
+     *
+     * @complexity O(1)
+     */
+    ContractionHierarchy *getContractionHierarchy() const;
+
+    /**
+     * @brief Accounts the memory of the graph: its vertices, edges and hash tables, and the metric closure and
+     * contraction hierarchy if they were built.
+     *
+     * @details Fills in the structure fields of the report that belong to the graph (see Memory); the others are
+     * left untouched. Must not run while an algorithm is changing the graph.
+     *
+     * @param report The report to fill in.
+     *
+     * @complexity O(|V| + r), r being the number of rows cached by the metric closure.
+     */
+    void memoryUsage(Memory::Report &report) const;
+
+    /**
+     * @brief Analyses the structure of the graph to tell ahead of time which tours cannot exist.
+     *
+     * @details Edges are taken as undirected. The vertices with fewer than two distinct neighbours are listed,
+     * and a single depth-first search per connected component (Tarjan's lowlink method, iterative so that deep
+     * road networks cannot overflow the stack) counts the components and finds the bridges and articulation
+     * points. See GraphAnalysis.
+     *
+     * @return The analysis of the graph.
+     *
+     * @complexity O(|V| + |E|).
+     */
+    GraphAnalysis analyse() const;
+
     /**
      * @brief Retrieves the weight of the edge between two vertices in the graph.
      *
@@ -349,21 +584,26 @@ public:
      * latitude and longitude coordinates of the vertices. If either of the vertices has invalid
      * coordinates (latitude or longitude set to numeric_limits<double>::max()), indicating that
      * it's not a valid vertex, the function throws a runtime error. If the edge exists, it returns
-     * the weight of the edge.
+     * the weight of the edge. Since vertices without coordinates fall back to shortest-path distances, the
+     * cost of a tour of the heuristics on an incomplete graph is the length of the closed walk that follows
+     * those paths (see expandTour), not of a Hamiltonian cycle of the graph.
      *
      * @param source A pointer to the source vertex.
      * @param dest A pointer to the destination vertex.
      *
      * @return The weight of the edge between the source and destination vertices, or the calculated
-     * distance based on their coordinates if the edge does not exist.
+     * distance based on their coordinates if the edge does not exist. If either vertex has no coordinates,
+     * the shortest-path distance between them is used instead (see getMetricClosure).
      *
-     * @throws std::runtime_error If the edge is not found and either of the vertices has invalid
-     * coordinates.
+     * @throws std::runtime_error If the edge is not found, either of the vertices has invalid
+     * coordinates, and there is no path between them.
      *
      * @complexity The time complexity of this function depends on the time complexity of finding
      * the edge between the vertices, which is O(1) in the average case for most graph
      * representations. If the edge does not exist, the complexity of calculating the distance
-     * between the vertices using the Haversine formula is O(1).
+     * between the vertices using the Haversine formula is O(1). Without coordinates, it is O(1) once the
+     * metric closure row of source is computed, and O((|V| + |E|) log |V|) for the first lookup from source
+     * above MetricClosure::DENSE_LIMIT vertices (see MetricClosure::distance).
     */
     double getEdgeWeight(Vertex* source, Vertex* dest);
 
@@ -387,6 +627,26 @@ public:
     */
     void TSPBacktracking(Vertex *currentVertex, int destId, int count, double cost, double &res);
 
+    /**
+     * @brief Solves the Traveling Salesman Problem (TSP) exactly by backtracking, keeping the tour.
+     *
+     * @details Explores the same paths as the recursive TSPBacktracking, from the starting vertex, but keeps
+     * the path so that the best cycle can be returned and published, and prunes the paths that already cost
+     * as much as the best cycle found. When the control stops the search, the best cycle found so far is
+     * returned; it is only known to be optimal when the search ran to the end. The path is marked in the
+     * visited flags of the vertices, so concurrent calls of this and of TSPTriangular with a tour take turns.
+     *
+     * @param res Reference to the variable to store the cost of the best cycle.
+     * @param tour Reference to the vector to store the vertices of the best cycle in visiting order.
+     * @param startingVertexId The ID of the vertex the cycle starts from.
+     * @param control Optional deadline, cancellation and progress (see SolveControl).
+     *
+     * @throws std::runtime_error If the starting vertex does not exist, or no cycle was found (in time).
+     *
+     * @complexity O(|V|!) in the worst case, bounded by the deadline of the control.
+    */
+    void TSPBacktracking(double &res, vector<Vertex *> &tour, int startingVertexId, SolveControl *control = nullptr);
+
     /**
      * @brief Solves the Traveling Salesman Problem (TSP) using the Triangular TSP heuristic.
      *
@@ -394,53 +654,139 @@ public:
      * a minimum spanning tree (MST) using Prim's algorithm with a binary heap-based priority queue,
      * and then performing a preorder traversal on the MST to generate a Hamiltonian cycle.
      * It calculates the total cost of the cycle by summing the weights of the edges in the preorder
-     * traversal path.
+     * traversal path. On sparse graphs (at most SPARSE_FILL of the vertex pairs joined by an edge) the
+     * MST is built by kruskal from the existing edges instead, which is also the MST of the shortest-path
+     * distances; Prim's algorithm is then only used if those edges do not connect the graph and the
+     * missing distances can be measured with coordinates. Sparse and complete graphs with at least
+     * PARALLEL_MST_MIN_EDGES edges use boruvka, which splits the work between the threads of the pool.
      *
      * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
      *
+     * @throws std::runtime_error If the graph is sparse, not connected and has no coordinates.
+     *
      * @complexity The time complexity of this function primarily depends on the time complexity of
      * constructing the minimum spanning tree using Prim's algorithm, which is O((|V| + |E|) log |V|)
      * with adjacency list representation and a binary heap-based priority queue. The complexity
      * of the preorder traversal is O(|V|), and calculating edge weights is O(1) on average.
-     * Overall, the complexity is dominated by Prim's algorithm.
+     * Overall, the complexity is dominated by Prim's algorithm, or by kruskal, O(|E| log |E|), on
+     * sparse graphs.
     */
     void TSPTriangular(double &res);
 
+    /**
+     * @brief Solves the Traveling Salesman Problem (TSP) using the Triangular TSP heuristic, keeping the tour.
+     *
+     * @details Same heuristic as TSPTriangular(double &res), but the preorder traversal of the MST is also
+     * stored so that it can be used as a starting tour by other heuristics. The spanning tree is kept in local
+     * arrays, so the graph is only read and concurrent calls of this and of the other heuristics run side by side.
+     *
+     * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
+     * @param tour Reference to the vector to store the vertices in visiting order.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); std::runtime_error is thrown
+     * if it stops the run before the tour is complete.
+     *
+     * @complexity Same as TSPTriangular(double &res).
+    */
+    void TSPTriangular(double &res, vector<Vertex *> &tour, SolveControl *control = nullptr);
+
     /**
      * @brief Constructs a minimum spanning tree (MST) using Prim's algorithm.
      *
      * @details This function implements Prim's algorithm to find the minimum spanning tree (MST)
-     * of the graph starting from an arbitrary vertex. It initializes each vertex's distance to
-     * infinity and sets its path and visited status accordingly. Then, it selects a starting vertex,
-     * sets its distance to 0, and initializes a mutable priority queue to manage vertices based
-     * on their distances. The algorithm iterates by extracting the vertex with the minimum distance
-     * from the priority queue, marking it as visited, and updating the distances of its adjacent
-     * vertices if shorter paths are found. The process continues until all vertices are visited.
+     * of the graph starting from the vertex with id 0. It initializes the distance of each vertex to
+     * infinity, with no parent and not visited, in arrays of its own, so the graph is only read. Then,
+     * it sets the distance of the starting vertex to 0, and initializes a mutable priority queue (a
+     * binary heap, or the one chosen with setHeap) to manage vertices based on their distances. The algorithm iterates by extracting the vertex with
+     * the minimum distance from the priority queue, marking it as visited, and updating the distances
+     * of the other vertices if shorter edges are found. The process continues until all vertices are visited.
+     *
+     * @param nodes The vertices of the graph, in any order.
+     * @param parent Filled with the position in nodes of the parent of every vertex, -1 for the root.
      *
      * @complexity The time complexity of Prim's algorithm depends on the implementation of the
      * priority queue. Using a binary heap-based priority queue, the complexity is O((|V| + |E|) log |V|),
      * where |V| is the number of vertices and |E| is the number of edges in the graph.
     */
-    void prim();
+    void prim(const vector<Vertex *> &nodes, vector<int> &parent);
+
+    /**
+     * @brief Prim's algorithm with a given queue, for prim.
+     *
+     * @tparam Queue IndexedPriorityQueue or PairingHeap.
+     *
+     * @param nodes The vertices of the graph, in any order.
+     * @param parent Filled with the position in nodes of the parent of every vertex, -1 for the root.
+     */
+    template <class Queue>
+    void primWith(const vector<Vertex *> &nodes, vector<int> &parent);
+
+    /**
+     * @brief Constructs a minimum spanning tree (MST) over the existing edges using Kruskal's algorithm.
+     *
+     * @details The edges are sorted by weight with several threads and added lightest first whenever they join
+     * two trees (see SpanningTree::kruskal). Unlike prim, missing edges are never measured, so this works on
+     * graphs without coordinates. The tree is rooted at the vertex with id 0, like prim, and kept in the parent
+     * array, so the graph is only read. If the edges do not connect the graph, every component gets its own tree,
+     * and only the one holding the root is reachable from it.
+     *
+     * @param nodes The vertices of the graph, in any order.
+     * @param parent Filled with the position in nodes of the parent of every vertex, -1 if it has none.
+     *
+     * @return True if the tree spans every vertex, false if the graph is not connected.
+     *
+     * @complexity O(|E| log |E|), dominated by the sort, which is split between the threads of the pool.
+    */
+    bool kruskal(const vector<Vertex *> &nodes, vector<int> &parent);
+
+    /**
+     * @brief Constructs a minimum spanning tree (MST) over the existing edges using a parallel Boruvka's algorithm.
+     *
+     * @details Same result as kruskal, as ties between equal weights are broken the same way, but every round
+     * of Boruvka's algorithm is split between several threads, which merge components through a lock-free
+     * union-find (see SpanningTree::boruvka). TSPTriangular uses it for graphs of at least PARALLEL_MST_MIN_EDGES
+     * edges that are sparse or complete. The threads are those of the pool (see setThreadPool).
+     *
+     * @param nodes The vertices of the graph, in any order.
+     * @param parent Filled with the position in nodes of the parent of every vertex, -1 if it has none.
+     *
+     * @return True if the tree spans every vertex, false if the graph is not connected.
+     *
+     * @complexity O((|V| + |E|) log |V| / threads).
+    */
+    bool boruvka(const vector<Vertex *> &nodes, vector<int> &parent);
+
+    /**
+     * @brief Computes the weight of a minimum spanning tree over the existing edges.
+     *
+     * @details Removing any edge from a tour leaves a path that spans every vertex, so on a connected graph this
+     * weight is a lower bound on the cost of any tour, or of any closed walk through all vertices, which tells
+     * how far a heuristic result can be from the optimum. The tree is built with SpanningTree::boruvka and the
+     * graph is only read. If the graph is not connected, it is the weight of the forest.
+     *
+     * @return The weight of the tree.
+     *
+     * @complexity O((|V| + |E|) log |V| / threads).
+    */
+    double spanningTreeWeight() const;
 
     /**
      * @brief Performs a preorder traversal starting from a given vertex.
      *
-     * @details This function recursively performs a preorder traversal starting from the specified
-     * vertex in the graph. It adds each visited vertex to the preorder vector and continues the
-     * traversal by recursively visiting adjacent vertices that are connected to the current vertex
-     * via their paths. The traversal continues until all vertices are visited or until the preorder
-     * vector contains 'n' vertices, where 'n' is the total number of vertices in the graph.
+     * @details This function performs a preorder traversal starting from the specified vertex in the
+     * tree. It adds each visited vertex to the preorder vector and continues the traversal by visiting
+     * the children of the current vertex, the vertices whose parent it is. The children of every
+     * vertex are gathered once, and the traversal uses an explicit stack, so deep trees are fine.
+     * The traversal continues until all vertices reachable from the root are visited.
      *
-     * @param v A pointer to the starting vertex for the preorder traversal.
+     * @param nodes The vertices of the tree.
+     * @param parent The position in nodes of the parent of every vertex, -1 if it has none.
+     * @param root The position in nodes of the starting vertex for the preorder traversal.
      * @param preorder Reference to the vector to store the vertices in preorder traversal order.
-     * @param n The total number of vertices in the graph.
      *
      * @complexity The time complexity of this function depends on the number of vertices in the
-     * graph and the structure of the graph. In the worst case, where the graph is a complete graph,
-     * the complexity is O(|V| + |E|), where |V| is the number of vertices and |E| is the number of edges in the graph.
+     * graph: O(|V|), where |V| is the number of vertices in the graph.
     */
-    void preorderTraversal(Vertex *v, std::vector<Vertex *> &preorder, int n);
+    void preorderTraversal(const vector<Vertex *> &nodes, const vector<int> &parent, int root, vector<Vertex *> &preorder);
 
     /**
      * @brief Solves the Traveling Salesman Problem (TSP) using the Nearest Neighbor heuristic.
@@ -460,25 +806,312 @@ public:
     */
     void TSPNearestNeighbor(double &res);
 
+    /**
+     * @brief Solves the Traveling Salesman Problem (TSP) using the Nearest Neighbor heuristic, keeping the tour.
+     *
+     * @details Same heuristic as TSPNearestNeighbor(double &res), but the visiting order is also stored
+     * so that it can be used as the starting point of the improvement heuristics. The tour starts at the
+     * vertex with id 0 and does not repeat it at the end. The visited vertices are kept in a local array rather
+     * than in the vertices, so it can run alongside the other algorithms (see Data::solvePortfolio).
+     *
+     * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
+     * @param tour Reference to the vector to store the vertices in visiting order.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); std::runtime_error is thrown
+     * if it stops the run before the tour is complete.
+     *
+     * @throws std::runtime_error If no neighboring vertex is found during the traversal.
+     *
+     * @complexity O(|V|^2), where |V| is the number of vertices.
+    */
+    void TSPNearestNeighbor(double &res, vector<Vertex *> &tour, SolveControl *control = nullptr);
+
+    /**
+     * @brief Improves a Nearest Neighbor tour using parallel Simulated Annealing.
+     *
+     * @details Several independent replicas are run concurrently on the thread pool, each with its own
+     * random seed and starting temperature. Every replica applies random 2-opt (segment reversal) and
+     * Or-opt (moving a segment of up to 3 vertices) moves, accepting worse tours with probability
+     * exp(-delta / T), while T decreases geometrically with the elapsed wall-clock time.
+     * The search is split into epochs; at the end of each epoch the best tour found so far is handed
+     * to every replica that is currently worse than it. The search stops when the time budget is spent.
+     *
+     * @param res Reference to the variable to store the total cost of the best Hamiltonian cycle found.
+     * @param tour Reference to the vector to store the vertices of the best tour found.
+     * @param replicas The number of replicas to run. 0 runs one per thread of the pool.
+     * @param timeBudget The wall-clock time budget in seconds.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); the time budget is cut
+     * to its deadline, and the best tour found so far is returned when it stops the search.
+     *
+     * @throws std::runtime_error If the initial Nearest Neighbor tour cannot be built.
+     *
+     * @complexity O(|V|^2) for the initial tour, then bounded by the time budget. Each move is evaluated
+     * in O(1) and applied in O(|V|).
+    */
+    void TSPSimulatedAnnealing(double &res, vector<Vertex *> &tour, unsigned int replicas, double timeBudget,
+                               SolveControl *control = nullptr);
+
+    /**
+     * @brief Solves the Traveling Salesman Problem (TSP) using an island model genetic algorithm.
+     *
+     * @details Each island evolves its own population in a task of the thread pool. Populations are seeded with the
+     * Nearest Neighbor and MST preorder tours, plus randomly perturbed copies of them. Children are produced
+     * with the order crossover (OX), which always yields a valid tour, and are then mutated by a random
+     * segment reversal followed by a 2-opt local search restricted to each vertex's candidate neighbours.
+     * A child replaces the worst member of its island when it is better. The run is split into epochs and,
+     * between epochs, every island sends a copy of its best tour to the next island (ring migration).
+     *
+     * @param res Reference to the variable to store the total cost of the best Hamiltonian cycle found.
+     * @param tour Reference to the vector to store the vertices of the best tour found.
+     * @param islands The number of islands to run. 0 runs one per thread of the pool.
+     * @param timeBudget The wall-clock time budget in seconds.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); the time budget is cut
+     * to its deadline, and the best tour found so far is returned when it stops the search.
+     *
+     * @throws std::runtime_error If the initial Nearest Neighbor tour cannot be built.
+     *
+     * @complexity O(|V|^2) to build the seeds and the candidate lists, then bounded by the time budget.
+    */
+    void TSPGeneticAlgorithm(double &res, vector<Vertex *> &tour, unsigned int islands, double timeBudget,
+                             SolveControl *control = nullptr);
+
+    /**
+     * @brief Solves the Traveling Salesman Problem (TSP) using Ant Colony Optimization over the existing edges.
+     *
+     * @details Ants only walk along edges of the graph, so this works on real-world graphs that are not
+     * fully connected. Pheromone and heuristic information are only kept for each vertex's candidate edges
+     * (its k lightest edges), so memory is O(|V| * k); other edges are only used, lightest first, when every
+     * candidate was visited. In each iteration the ants build their tours in parallel on the thread pool, trying the next
+     * vertices in a random order biased by pheromone^alpha * (1 / weight)^beta and by Warnsdorff's rule (vertices
+     * with few unvisited candidates first). An ant that gets stuck backtracks, and it is discarded when it runs
+     * out of its budget of 20 * |V| steps. The pheromone
+     * update is then done once for the whole iteration (MAX-MIN Ant System): evaporation, a deposit along the
+     * iteration best tour, and clamping to [tauMin, tauMax]. The search stops when the time budget is spent.
+     *
+     * @param res Reference to the variable to store the total cost of the best Hamiltonian cycle found.
+     * @param tour Reference to the vector to store the vertices of the best tour found, starting at the
+     * starting vertex.
+     * @param startingVertexId The ID of the vertex the tour should start from.
+     * @param threads The number of tasks that build the tours, which also sets the number of ants (at least 8).
+     * 0 uses the size of the thread pool.
+     * @param timeBudget The wall-clock time budget in seconds.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); the time budget is cut
+     * to its deadline, and the best tour found so far is returned when it stops the search.
+     *
+     * @throws std::runtime_error If no ant finds a Hamiltonian cycle within the time budget.
+     *
+     * @complexity Each iteration is O(m * |V| * k) for m ants when the candidate edges suffice, plus
+     * O(degree) for each fallback to a non-candidate edge. The number of iterations is bounded by the time budget.
+    */
+    void TSPAntColony(double &res, vector<Vertex *> &tour, int startingVertexId, unsigned int threads, double timeBudget,
+                      SolveControl *control = nullptr);
+
+    /**
+     * @brief Builds a Traveling Salesman Problem (TSP) tour by following a Hilbert space-filling curve.
+     *
+     * @details The coordinates of the vertices are projected onto a plane (equirectangular projection around
+     * the mean latitude), scaled onto a 2^16 x 2^16 grid, and the vertices are sorted by the position of their
+     * cell along the Hilbert curve. Points that are close on the curve are close on the map, so this order is
+     * a reasonable tour that is built without evaluating a single distance, which makes it suitable for huge
+     * inputs and as a starting tour for improvement heuristics. The tour is rotated to start at the vertex
+     * with id 0 when it exists.
+     *
+     * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
+     * @param tour Reference to the vector to store the vertices in visiting order.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); std::runtime_error is thrown
+     * if it stops the run before the tour is complete.
+     *
+     * @throws std::runtime_error If some vertex has no coordinates, or if an edge weight of the tour cannot
+     * be obtained.
+     *
+     * @complexity O(|V| log |V|) to build the tour, plus O(|V|) getEdgeWeight calls to compute its cost.
+    */
+    void TSPSpaceFillingCurve(double &res, vector<Vertex *> &tour, SolveControl *control = nullptr);
+
+    /**
+     * @brief Builds a Traveling Salesman Problem (TSP) tour using the greedy edge heuristic.
+     *
+     * @details The candidate edges of every vertex (see candidateNeighbours) are sorted by weight and each one
+     * is added to the tour unless it would give a vertex degree 3 or close a cycle before all vertices are in
+     * it, which is checked with a union-find structure over the path fragments built so far. Candidate edges
+     * usually leave many separate paths, so the same greedy pass is repeated over the path ends only (whose
+     * candidates are then the nearest ends of other paths) while it keeps joining paths. Any paths still left
+     * are chained together, always joining the current end to the nearest free end of another path, and the
+     * last end is connected back to the first. The tour is returned starting at the vertex with the lowest id.
+     *
+     * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
+     * @param tour Reference to the vector to store the vertices in visiting order.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); std::runtime_error is thrown
+     * if it stops the run before the tour is complete.
+     *
+     * @throws std::runtime_error If two path ends that must be joined have no edge between them and no
+     * coordinates.
+     *
+     * @complexity O(|V| k log(|V| k)), k being the number of candidates per vertex, as each pass over the path
+     * ends works on far fewer vertices than the previous one, plus O(f^2) to chain the f paths that may be left.
+    */
+    void TSPGreedyEdge(double &res, vector<Vertex *> &tour, SolveControl *control = nullptr);
+
+    /**
+     * @brief Builds a Traveling Salesman Problem (TSP) tour using the Clarke-Wright savings heuristic.
+     *
+     * @details The vertex with the lowest id is the hub and every other vertex starts as its own route from
+     * and back to it. Joining the routes ending at i and j saves d(hub, i) + d(hub, j) - d(i, j), so the
+     * savings of the candidate pairs (see candidateNeighbours) are kept in a max-heap and, largest first, the
+     * two routes are merged whenever i and j are still route ends of different routes. The opposite end of
+     * every route end is kept up to date, which makes that check and the merge O(1). As in TSPGreedyEdge, the
+     * pass is repeated over the route ends only while it keeps merging routes, any routes still left are
+     * chained by largest saving, and the two ends of the final route are connected to the hub.
+     *
+     * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
+     * @param tour Reference to the vector to store the vertices in visiting order.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); std::runtime_error is thrown
+     * if it stops the run before the tour is complete.
+     *
+     * @throws std::runtime_error If two route ends that must be joined, or a final route end and the hub,
+     * have no edge between them and no coordinates.
+     *
+     * @complexity O(|V| k log(|V| k)), k being the number of candidates per vertex, plus O(r^2) to chain the
+     * r routes that may be left.
+    */
+    void TSPSavings(double &res, vector<Vertex *> &tour, SolveControl *control = nullptr);
+
+    /**
+     * @brief Builds a Traveling Salesman Problem (TSP) tour using the cheapest insertion heuristic.
+     *
+     * @details The tour starts as the convex hull of the vertices when they have coordinates, or as a cycle
+     * between the vertex with the lowest id and its nearest vertex otherwise. Then, the vertex that can be
+     * inserted in the tour with the smallest increase in cost is inserted at that position, until all vertices
+     * are in the tour. Instead of rescanning every vertex and tour edge after each insertion, each vertex out of
+     * the tour caches its best insertion edge, kept in a priority queue. After an insertion only the two new
+     * edges are compared against each cache, and only the vertices whose best edge was the removed one are
+     * rescanned. Every vertex out of the tour is still compared after every insertion, so the run computes
+     * Θ(|V|^2) edge weights: seconds from a few thousand vertices (see Data::INSERTION_MAX_VERTICES). The tour is
+     * returned starting at the vertex with the lowest id.
+     *
+     * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
+     * @param tour Reference to the vector to store the vertices in visiting order.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); std::runtime_error is thrown
+     * if it stops the run before the tour is complete.
+     *
+     * @throws std::runtime_error If some edge weight cannot be obtained (see getEdgeWeight).
+     *
+     * @complexity O(|V|^2 log |V|), where the naive implementation would be O(|V|^3).
+    */
+    void TSPCheapestInsertion(double &res, vector<Vertex *> &tour, SolveControl *control = nullptr);
+
+    /**
+     * @brief Builds a Traveling Salesman Problem (TSP) tour using the farthest insertion heuristic.
+     *
+     * @details The tour starts as the convex hull of the vertices when they have coordinates, or as a cycle
+     * between the vertex with the lowest id and its farthest vertex otherwise. Then, the vertex farthest from
+     * the tour (the one whose nearest tour vertex is the farthest away) is inserted where it increases the cost
+     * the least, until all vertices are in the tour. The distance of each vertex to the tour is cached and
+     * updated after each insertion, and the tour is only scanned for the best insertion edge of the vertex picked.
+     * That is still Θ(|V|^2) edge weights, as in TSPCheapestInsertion. The tour is returned starting at the vertex
+     * with the lowest id.
+     *
+     * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
+     * @param tour Reference to the vector to store the vertices in visiting order.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); std::runtime_error is thrown
+     * if it stops the run before the tour is complete.
+     *
+     * @throws std::runtime_error If some edge weight cannot be obtained (see getEdgeWeight).
+     *
+     * @complexity O(|V|^2 log |V|), where the naive implementation would be O(|V|^3).
+    */
+    void TSPFarthestInsertion(double &res, vector<Vertex *> &tour, SolveControl *control = nullptr);
+
+    /**
+     * @brief Computes the candidate neighbours of each vertex of a vertex list.
+     *
+     * @details When all vertices have coordinates, the candidates of a vertex are its k nearest vertices
+     * according to getEdgeWeight among those closest on the map, which are found through a grid of cells
+     * holding about 2 vertices each instead of looking at every pair. Otherwise, or when only existing edges
+     * are allowed, they are the destinations of its k lightest edges. Candidates are given as indices into the
+     * vertex list and are sorted by increasing weight. Heuristics only look at candidate edges, which keeps
+     * their work per vertex constant.
+     *
+     * @param nodes The vertices to consider.
+     * @param k The maximum number of candidates per vertex.
+     * @param edgesOnly True to only consider the edges of the graph, even if there are coordinates.
+     *
+     * @return For each vertex index, the indices of its candidate neighbours.
+     *
+     * @complexity O(|V| k log k) expected with coordinates, O(|E| log k) otherwise.
+    */
+    vector<vector<int>> candidateNeighbours(const vector<Vertex *> &nodes, int k, bool edgesOnly = false);
+
+    /**
+     * @brief Calculates the cost of a closed tour.
+     *
+     * @param tour The vertices of the tour in visiting order, without repeating the first one at the end.
+     *
+     * @return The sum of the weights of the tour edges, including the one back to the first vertex.
+     *
+     * @throws std::runtime_error If some edge weight cannot be obtained (see getEdgeWeight).
+     *
+     * @complexity O(|V|).
+    */
+    double tourCost(const vector<Vertex *> &tour);
+
     /**
      * @brief Solves the Traveling Salesman Problem (TSP) using the Real-World Nearest Neighbor heuristic.
      *
      * @details This function applies the Real-World Nearest Neighbor heuristic to find an approximate
      * solution to the TSP. Starting from a specified vertex, it iteratively selects the nearest unvisited
-     * neighbor based on real-world distances (edge weights) until all vertices are visited, forming a
-     * Hamiltonian cycle. It calculates the total cost of the cycle by summing the weights of the edges
-     * traversed.
+     * vertex based on real-world distances until all vertices are visited, and then returns to the start.
+     * Distances are shortest-path distances through the road network (see getMetricClosure), so the nearest
+     * unvisited vertex does not need to be directly adjacent; a leg between two consecutive vertices may
+     * pass through vertices already visited. The total cost is the sum of the lengths of the legs.
      *
-     * @param res Reference to the variable to store the total cost of the Hamiltonian cycle.
+     * @param res Reference to the variable to store the total cost of the closed walk.
      * @param startingVertexId The ID of the vertex from which the traversal should start.
      *
-     * @throws std::runtime_error If no neighboring vertex or path is found during the traversal.
+     * @throws std::runtime_error If the starting vertex does not exist, or if some vertex cannot be reached
+     * (the graph is not connected).
      *
-     * @complexity The time complexity of this function primarily depends on the number of vertices
-     * in the graph and the implementation of finding the nearest neighbor, resulting in O(|V| + |E|),
-     * where |V| is the number of vertices and |E| is the number of edges in the graph.
+     * @complexity O(|V|^2) plus the metric closure: O(|V| (|V| + |E|) log |V| / threads) in total, as one
+     * row of the closure is needed per vertex.
      */
     void TSPRealWorldNearestNeighbor(double &res, int startingVertexId);
+
+    /**
+     * @brief Solves the Traveling Salesman Problem (TSP) using the Real-World Nearest Neighbor heuristic,
+     * returning the tour.
+     *
+     * @details Same as TSPRealWorldNearestNeighbor(double &, int). Consecutive vertices of the tour (and the
+     * last and the first) are joined by shortest paths, which expandTour can list.
+     *
+     * @param res Reference to the variable to store the total cost of the closed walk.
+     * @param tour Reference to the vector to store the vertices in visiting order, starting vertex first.
+     * @param startingVertexId The ID of the vertex from which the traversal should start.
+     * @param control Optional deadline, cancellation and progress (see SolveControl); std::runtime_error is thrown
+     * if it stops the run before the tour is complete.
+     *
+     * @throws std::runtime_error If the starting vertex does not exist, or if some vertex cannot be reached.
+     *
+     * @complexity See TSPRealWorldNearestNeighbor(double &, int).
+     */
+    void TSPRealWorldNearestNeighbor(double &res, vector<Vertex *> &tour, int startingVertexId,
+                                     SolveControl *control = nullptr);
+
+    /**
+     * @brief Expands a tour into the sequence of graph vertices it goes through.
+     *
+     * @details Every leg of the tour, including the one back to the first vertex, is replaced by a shortest
+     * path (see MetricClosure::path), so legs between vertices that are not adjacent become the actual roads.
+     * Vertices are handed to visit as they are found instead of being gathered, so tours going through
+     * millions of vertices can be streamed to a file.
+     *
+     * @param tour The vertices of the tour in visiting order.
+     * @param visit Called with every vertex of the expanded closed walk, from the first vertex of the tour
+     * back to it.
+     *
+     * @throws std::runtime_error If some leg has no path.
+     *
+     * @complexity One point-to-point query per leg, plus O(p), p being the number of vertices visited.
+     */
+    void expandTour(const vector<Vertex *> &tour, const function<void(Vertex *)> &visit);
 };
 
 // AUX functions
@@ -526,6 +1159,7 @@ inline double convert_to_radians(const double coord)
 */
 inline double haversine(const double lat1, const double lon1, const double lat2, const double lon2)
 {
+    TSP_COUNT(HAVERSINE);
     const double earths_radius = 6371000;
 
     // Get the difference between our two points then convert the difference into radians
@@ -0,0 +1,139 @@
+#include "HardwareCounters.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Open a user-space counter of a thread (0 for the calling one) and the threads it starts, or return -1
+static int openCounter(uint32_t type, uint64_t config, int thread) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int) syscall(SYS_perf_event_open, &attr, thread, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+#endif
+
+// Open a counter per event for the calling thread and for each thread given
+HardwareCounters::HardwareCounters(const vector<int> &threads) {
+#ifdef __linux__
+    const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const pair<uint32_t, uint64_t> events[EVENTS] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, l1dReadMiss},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+    };
+    vector<int> counted(1, 0);
+    counted.insert(counted.end(), threads.begin(), threads.end());
+    for (int e = 0; e < EVENTS; e++) {
+        for (int thread : counted) {
+            int descriptor = openCounter(events[e].first, events[e].second, thread);
+            if (descriptor >= 0) {
+                descriptors[e].push_back(descriptor);
+                continue;
+            }
+            // Counting some threads only would understate the event, so leave it out
+            if (error.empty()) error = string(eventName((Event) e)) + ": " + strerror(errno);
+            for (int opened : descriptors[e]) close(opened);
+            descriptors[e].clear();
+            break;
+        }
+    }
+#else
+    error = "hardware counters need Linux";
+#endif
+}
+
+// Close the counters
+HardwareCounters::~HardwareCounters() {
+#ifdef __linux__
+    for (const auto &eventDescriptors : descriptors) {
+        for (int descriptor : eventDescriptors) close(descriptor);
+    }
+#endif
+}
+
+// Reset and enable the counters
+void HardwareCounters::start() {
+#ifdef __linux__
+    for (const auto &eventDescriptors : descriptors) {
+        for (int descriptor : eventDescriptors) {
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+// Disable the counters and add up the threads of each event, scaling the time-shared ones to the whole interval
+HardwareCounters::Reading HardwareCounters::stop() {
+    Reading reading;
+    reading.enabled = true;
+    reading.error = error;
+#ifdef __linux__
+    for (int e = 0; e < EVENTS; e++) {
+        for (int descriptor : descriptors[e]) ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+        for (int descriptor : descriptors[e]) {
+            uint64_t values[3]; // value, time enabled, time running
+            // A thread never scheduled on a counter (or never running) has nothing to add
+            if (read(descriptor, values, sizeof(values)) != (ssize_t) sizeof(values) || values[2] == 0) continue;
+            reading.available[e] = true;
+            reading.counts[e] += values[2] < values[1] ? (uint64_t) ((double) values[0] * values[1] / values[2]) : values[0];
+        }
+    }
+#endif
+    return reading;
+}
+
+// Get the name of an event
+const char *HardwareCounters::eventName(Event event) {
+    static const char *const names[EVENTS] = {
+            "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+    };
+    return names[event];
+}
+
+// Print the available counts and the instructions per cycle
+void HardwareCounters::print(ostream &out, const Reading &reading) {
+    if (!reading.enabled) return;
+    ios state(nullptr);
+    state.copyfmt(out);
+    bool any = false;
+    for (int e = 0; e < EVENTS; e++) {
+        if (!reading.available[e]) continue;
+        out << "  " << left << setw(16) << eventName((Event) e) << right << reading.counts[e] << endl;
+        any = true;
+    }
+    if (reading.available[CYCLES] && reading.available[INSTRUCTIONS] && reading.counts[CYCLES] > 0) {
+        out << "  " << left << setw(16) << "ipc" << right << fixed << setprecision(2)
+            << (double) reading.counts[INSTRUCTIONS] / reading.counts[CYCLES] << endl;
+    }
+    if (!any) out << "  Hardware counters unavailable (" << reading.error << ")" << endl;
+    out.copyfmt(state);
+}
+
+// Write a reading as a member of a JSON object
+void HardwareCounters::writeJson(ostream &out, const Reading &reading) {
+    out << "\"hardware\": {";
+    for (int e = 0; e < EVENTS; e++) {
+        out << (e ? ", " : "") << '"' << eventName((Event) e) << "\": ";
+        if (reading.available[e]) out << reading.counts[e];
+        else out << "null";
+    }
+    out << "}";
+}
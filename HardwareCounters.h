@@ -0,0 +1,116 @@
+#ifndef FEUP_DA_PROJECT_2_HARDWARECOUNTERS_H
+#define FEUP_DA_PROJECT_2_HARDWARECOUNTERS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/************************* HardwareCounters  **************************/
+
+/**
+ * @brief CPU performance counters of the process, read through the Linux perf_event_open system call.
+ *
+ * @details Counts cycles, instructions, L1 data cache read misses, last-level cache misses and branch misses in user
+ * space from start to stop, including the threads the process starts in between (they are added when they exit,
+ * so join them before stopping) and the threads given to the constructor, which were started before, like the
+ * workers of a ThreadPool. Each event has a counter per thread counted on its own; when the CPU has fewer counters
+ * than events, the kernel time-shares them and the counts are scaled to the whole interval.
+ *
+ * Events the CPU, the kernel or its settings (perf_event_paranoid above 2, a virtual machine without a PMU) do not
+ * allow are reported as unavailable rather than failing. On other systems every event is unavailable.
+ */
+class HardwareCounters {
+public:
+    /**
+     * @brief The counted events.
+     */
+    enum Event {
+        CYCLES,
+        INSTRUCTIONS,
+        L1D_MISSES,         // L1 data cache read misses
+        LLC_MISSES,         // last-level cache misses
+        BRANCH_MISSES,
+        EVENTS
+    };
+
+    /**
+     * @brief The counts of one interval.
+     */
+    struct Reading {
+        bool enabled = false;               // false if the interval was not measured at all
+        bool available[EVENTS] = {};        // false for the events that could not be counted
+        uint64_t counts[EVENTS] = {};
+        string error;                       // why the first unavailable event could not be opened
+    };
+
+    /**
+     * @brief Opens the counters of every event, disabled.
+     *
+     * @details An event is unavailable if its counter cannot be opened for the calling thread or any of the
+     * threads given.
+     *
+     * @param threads The kernel thread ids of threads already running to count as well (see ThreadPool::threadIds).
+     *
+     * @complexity O(threads).
+     */
+    explicit HardwareCounters(const vector<int> &threads = {});
+
+    /**
+     * @brief Closes the counters.
+     */
+    ~HardwareCounters();
+
+    HardwareCounters(const HardwareCounters &) = delete;
+    HardwareCounters &operator=(const HardwareCounters &) = delete;
+
+    /**
+     * @brief Resets and enables the counters.
+     *
+     * @complexity O(1).
+     */
+    void start();
+
+    /**
+     * @brief Disables the counters and reads them.
+     *
+     * @return The counts since start.
+     *
+     * @complexity O(1).
+     */
+    Reading stop();
+
+    /**
+     * @brief Gets the name of an event.
+     *
+     * @param event The event.
+     *
+     * @return The name, in lower case with underscores.
+     */
+    static const char *eventName(Event event);
+
+    /**
+     * @brief Prints the available counts, one per line, followed by the instructions per cycle.
+     *
+     * @param out The stream to print to.
+     * @param reading The counts to print.
+     */
+    static void print(ostream &out, const Reading &reading);
+
+    /**
+     * @brief Writes a reading as the member "hardware" of a JSON object, null for unavailable events.
+     *
+     * @param out The stream to write to.
+     * @param reading The counts to write.
+     */
+    static void writeJson(ostream &out, const Reading &reading);
+
+private:
+    vector<int> descriptors[EVENTS];    // the counters of the calling thread and of the threads given, per event
+    string error;
+};
+
+
+#endif //FEUP_DA_PROJECT_2_HARDWARECOUNTERS_H
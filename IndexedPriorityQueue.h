@@ -0,0 +1,192 @@
+#ifndef FEUP_DA_PROJECT_2_INDEXED_PRIORITY_QUEUE
+#define FEUP_DA_PROJECT_2_INDEXED_PRIORITY_QUEUE
+
+#include <vector>
+#include "Instrumentation.h"
+
+/**
+ * @brief A mutable priority queue of the integers 0 .. n - 1, each with a double key: a d-ary heap.
+ *
+ * @details Unlike MutablePriorityQueue, the elements are not touched: the heap stores element indices and keeps
+ * the position of every element in an array of its own, next to the keys, so any data indexed by element (compact
+ * adjacency arrays, for example) can be queued without adding a queueIndex field to it. PairingHeap and RadixHeap
+ * offer the same interface, so the three can be swapped to find the best one for a workload.
+ *
+ * @tparam Arity The number of children of every node of the heap (see MutablePriorityQueue).
+ *
+ * @complexity Insertion: O(log n / log Arity); Extraction of Minimum: O(Arity log n / log Arity);
+ * Decrease Key: O(log n / log Arity);
+ */
+
+/**
+ * @brief The priority queues the searches over vertex indices can use: Dijkstra's algorithm in MetricClosure and
+ * Prim's algorithm in Graph (see Graph::setHeap).
+ *
+ * @details DEFAULT keeps the queue each search was tuned with: a 4-ary heap for Dijkstra and a binary heap for
+ * Prim. RADIX only suits monotone searches, so Prim uses the binary heap instead.
+ */
+enum class HeapKind { DEFAULT, BINARY, QUATERNARY, PAIRING, RADIX };
+
+template <unsigned Arity = 4>
+class IndexedPriorityQueue {
+        static_assert(Arity >= 2, "A heap node needs at least two children");
+
+        struct Entry {
+            double key;
+            int x;
+        };
+
+        std::vector<Entry> H;           // keys and elements, in heap order (0-based); keys are kept next to the
+                                        // elements so that comparisons do not jump to another array
+        std::vector<int> position;      // position of every element in H, -1 if it is not in the queue
+        void heapifyUp(int i);
+        void heapifyDown(int i);
+        inline void set(int i, const Entry &entry);
+        public:
+        explicit IndexedPriorityQueue(int n);
+        void insert(int x, double key);
+        int extractMin();
+        void decreaseKey(int x, double key);
+        bool empty() const;
+        bool contains(int x) const;
+        double key(int x) const;
+};
+
+/**
+ * @brief Constructs a new, empty IndexedPriorityQueue object.
+ *
+ * @param n The number of elements that can be queued, 0 .. n - 1.
+ */
+template <unsigned Arity>
+IndexedPriorityQueue<Arity>::IndexedPriorityQueue(int n) : position(n, -1) {}
+
+/**
+ * @brief Checks if the priority queue is empty.
+ *
+ * @return True if the priority queue is empty, otherwise false.
+ */
+template <unsigned Arity>
+bool IndexedPriorityQueue<Arity>::empty() const {
+    return H.empty();
+}
+
+/**
+ * @brief Checks if an element is in the priority queue.
+ *
+ * @param x The element.
+ *
+ * @return True if x is in the queue, otherwise false.
+ */
+template <unsigned Arity>
+bool IndexedPriorityQueue<Arity>::contains(int x) const {
+    return position[x] != -1;
+}
+
+/**
+ * @brief Gets the key of an element.
+ *
+ * @param x The element, which must be in the queue.
+ *
+ * @return The key of x.
+ */
+template <unsigned Arity>
+double IndexedPriorityQueue<Arity>::key(int x) const {
+    return H[position[x]].key;
+}
+
+/**
+ * @brief Extracts the element with the minimum key from the priority queue.
+ *
+ * @return The element extracted from the priority queue.
+ */
+template <unsigned Arity>
+int IndexedPriorityQueue<Arity>::extractMin() {
+    TSP_COUNT(HEAP_OPERATION);
+    int x = H[0].x;
+    H[0] = H.back();
+    H.pop_back();
+    if (!H.empty()) heapifyDown(0);
+    position[x] = -1;
+    return x;
+}
+
+/**
+ * @brief Inserts a new element into the priority queue.
+ *
+ * @param x The element, which must not be in the queue.
+ * @param key The key of x.
+ */
+template <unsigned Arity>
+void IndexedPriorityQueue<Arity>::insert(int x, double key) {
+    TSP_COUNT(HEAP_OPERATION);
+    H.push_back({key, x});
+    heapifyUp((int) H.size() - 1);
+}
+
+/**
+ * @brief Decreases the key of an element in the priority queue.
+ *
+ * @param x The element, which must be in the queue.
+ * @param key The new key of x, not larger than its current key.
+ */
+template <unsigned Arity>
+void IndexedPriorityQueue<Arity>::decreaseKey(int x, double key) {
+    TSP_COUNT(HEAP_OPERATION);
+    H[position[x]].key = key;
+    heapifyUp(position[x]);
+}
+
+/**
+ * @brief Performs the heapify-up operation to maintain the heap property.
+ *
+ * @param i The position of the element to heapify-up.
+ */
+template <unsigned Arity>
+void IndexedPriorityQueue<Arity>::heapifyUp(int i) {
+    Entry x = H[i];
+    while (i > 0 && x.key < H[(i - 1) / Arity].key) {
+        set(i, H[(i - 1) / Arity]);
+        i = (i - 1) / Arity;
+    }
+    set(i, x);
+}
+
+/**
+ * @brief Performs the heapify-down operation to maintain the heap property.
+ *
+ * @param i The position of the element to heapify-down.
+ */
+template <unsigned Arity>
+void IndexedPriorityQueue<Arity>::heapifyDown(int i) {
+    Entry x = H[i];
+    const int size = (int) H.size();
+    while (true) {
+        int k = (int) Arity * i + 1;
+        if (k >= size)
+            break;
+        int last = k + (int) Arity < size ? k + (int) Arity : size;
+        for (int c = k + 1; c < last; ++c) {
+            if (H[c].key < H[k].key)
+                k = c; // smallest child of i
+        }
+        if ( ! (H[k].key < x.key) )
+            break;
+        set(i, H[k]);
+        i = k;
+    }
+    set(i, x);
+}
+
+/**
+ * @brief Sets the entry at a specified position in the priority queue.
+ *
+ * @param i The position where the entry should be set.
+ * @param entry The element and its key to be set at the specified position.
+ */
+template <unsigned Arity>
+void IndexedPriorityQueue<Arity>::set(int i, const Entry &entry) {
+    H[i] = entry;
+    position[entry.x] = i;
+}
+
+#endif /* FEUP_DA_PROJECT_2_INDEXED_PRIORITY_QUEUE */
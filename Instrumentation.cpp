@@ -0,0 +1,149 @@
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <set>
+
+// Clear the phase times and the counts
+void Instrumentation::reset() {
+    for (auto &nanoseconds : phaseNanoseconds) nanoseconds.store(0, memory_order_relaxed);
+    for (auto &count : exitedCounts) count.store(0, memory_order_relaxed);
+    for (auto &count : local.counts) count = 0;
+}
+
+// Move the counts of the calling thread to the shared totals
+void Instrumentation::flushThread() {
+    for (int c = 0; c < COUNTERS; c++) {
+        if (!local.counts[c]) continue;
+        exitedCounts[c].fetch_add(local.counts[c], memory_order_relaxed);
+        local.counts[c] = 0;
+    }
+}
+
+// Get the phase times and the counts gathered since the last reset
+Instrumentation::Snapshot Instrumentation::snapshot() {
+    Snapshot snapshot;
+    for (int p = 0; p < PHASES; p++) snapshot.seconds[p] = phaseNanoseconds[p].load(memory_order_relaxed) / 1e9;
+    for (int c = 0; c < COUNTERS; c++) snapshot.counts[c] = exitedCounts[c].load(memory_order_relaxed) + local.counts[c];
+    return snapshot;
+}
+
+// Get the name of a phase
+const char *Instrumentation::phaseName(Phase phase) {
+    static const char *const names[PHASES] = {
+            "load", "preprocessing", "reset", "mst", "preorder", "construction", "improvement"
+    };
+    return names[phase];
+}
+
+// Get the name of a counter
+const char *Instrumentation::counterName(Counter counter) {
+    static const char *const names[COUNTERS] = {
+            "edge_weight", "haversine", "hash_lookup", "heap_operation", "node_expanded"
+    };
+    return names[counter];
+}
+
+// Print the phases that took any time and the counters
+void Instrumentation::print(ostream &out, const Snapshot &snapshot) {
+    ios state(nullptr);
+    state.copyfmt(out);
+    for (int p = 0; p < PHASES; p++) {
+        if (snapshot.seconds[p] == 0) continue;
+        out << "  " << left << setw(16) << phaseName((Phase) p) << right << fixed << setprecision(4)
+            << snapshot.seconds[p] << "s" << endl;
+    }
+    if (COUNTERS_ENABLED) {
+        for (int c = 0; c < COUNTERS; c++)
+            out << "  " << left << setw(16) << counterName((Counter) c) << right << snapshot.counts[c] << endl;
+    }
+    out.copyfmt(state);
+}
+
+// Quote a string for a JSON document
+string Instrumentation::jsonString(const string &s) {
+    static const char digits[] = "0123456789abcdef";
+    string escaped = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if ((unsigned char) c < 0x20) {
+                    escaped += "\\u00";
+                    escaped += digits[(unsigned char) c >> 4];
+                    escaped += digits[(unsigned char) c & 15];
+                }
+                else escaped += c;
+        }
+    }
+    return escaped + '"';
+}
+
+// Write a snapshot as members of a JSON object
+void Instrumentation::writeJson(ostream &out, const Snapshot &snapshot) {
+    out << "\"phases\": {";
+    for (int p = 0; p < PHASES; p++)
+        out << (p ? ", " : "") << '"' << phaseName((Phase) p) << "\": " << snapshot.seconds[p];
+    out << "}";
+    if (COUNTERS_ENABLED) {
+        out << ", \"counters\": {";
+        for (int c = 0; c < COUNTERS; c++)
+            out << (c ? ", " : "") << '"' << counterName((Counter) c) << "\": " << snapshot.counts[c];
+        out << "}";
+    }
+}
+
+// Start recording trace events
+void Instrumentation::startTrace() {
+    lock_guard<mutex> lock(traceMutex);
+    traceEvents.clear();
+    traceOrigin = chrono::steady_clock::now();
+    tracing.store(true, memory_order_relaxed);
+}
+
+// Stop recording trace events
+void Instrumentation::stopTrace() {
+    tracing.store(false, memory_order_relaxed);
+}
+
+// Record a span on the track of the calling thread
+void Instrumentation::record(const char *name, chrono::steady_clock::time_point start, chrono::steady_clock::time_point end) {
+    lock_guard<mutex> lock(traceMutex);
+    double from = chrono::duration<double, micro>(start - traceOrigin).count();
+    traceEvents.push_back({name, track, from, chrono::duration<double, micro>(end - start).count()});
+}
+
+// Write the recorded events in the trace event format, with a named track per thread
+void Instrumentation::writeTrace(ostream &out) {
+    lock_guard<mutex> lock(traceMutex);
+    vector<TraceEvent> events = traceEvents;
+    // Outer spans first when two start together, so that viewers nest them correctly
+    stable_sort(events.begin(), events.end(), [](const TraceEvent &a, const TraceEvent &b) {
+        return a.start != b.start ? a.start < b.start : a.duration > b.duration;
+    });
+    set<int> tracks = {0};
+    for (const TraceEvent &event : events) tracks.insert(event.track);
+
+    ios state(nullptr);
+    state.copyfmt(out);
+    out << fixed << setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+    out << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"TSP\"}}";
+    for (int t : tracks) {
+        out << "," << endl << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t
+            << ", \"args\": {\"name\": \"" << (t ? "worker " + to_string(t) : string("main")) << "\"}}";
+        out << "," << endl << "  {\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t
+            << ", \"args\": {\"sort_index\": " << t << "}}";
+    }
+    for (const TraceEvent &event : events) {
+        out << "," << endl << "  {\"name\": " << jsonString(event.name);
+        out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.track << ", \"ts\": " << event.start
+            << ", \"dur\": " << event.duration << "}";
+    }
+    out << endl << "]}" << endl;
+    out.copyfmt(state);
+}
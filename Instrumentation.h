@@ -0,0 +1,284 @@
+#ifndef FEUP_DA_PROJECT_2_INSTRUMENTATION_H
+#define FEUP_DA_PROJECT_2_INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/************************* Instrumentation  **************************/
+
+/**
+ * @brief Phase timers and hot-operation counters of the TSP algorithms.
+ *
+ * @details Phase timers measure steady-clock (wall) time, so the time of a parallel phase is not multiplied by its
+ * threads as clock() would. Phases may nest (the simulated annealing constructs its starting tour, for example), and
+ * every phase adds up its own time, including that of the phases inside it. Timers cost two clock reads per phase and
+ * are always on.
+ *
+ * Counters are incremented with TSP_COUNT in the hottest loops, so they only exist when the program is built with
+ * TSP_INSTRUMENTATION defined (the CMake option of the same name); otherwise TSP_COUNT expands to nothing. Each thread
+ * counts into its own thread-local array, which is added to the shared totals when the thread exits, so counting
+ * never makes threads contend for a cache line.
+ *
+ * Tracing, when started, also records every phase and every traced span of a worker thread as an event with its
+ * start, duration and thread, which writeTrace exports in the trace event format of chrome://tracing and Perfetto.
+ * Worker threads are numbered by their task (a replica, an island, a slice of ants), not by the operating system, so
+ * the threads of successive epochs share a track and the gaps between their spans show the time they sat idle.
+ *
+ * Typical use: reset before a run, snapshot after it and print or export the snapshot.
+ */
+class Instrumentation {
+public:
+    /**
+     * @brief The timed phases.
+     */
+    enum Phase {
+        LOAD,               // reading the files
+        PREPROCESSING,      // analysis, contraction hierarchy, metric closure
+        RESET,              // clearing the per-vertex state before an algorithm
+        MST,                // minimum spanning tree
+        PREORDER,           // preorder traversal of the spanning tree
+        CONSTRUCTION,       // building a tour
+        IMPROVEMENT,        // improving a tour (metaheuristics, local search)
+        PHASES
+    };
+
+    /**
+     * @brief The counted operations.
+     */
+    enum Counter {
+        EDGE_WEIGHT,        // Graph::getEdgeWeight calls
+        HAVERSINE,          // haversine evaluations
+        HASH_LOOKUP,        // vertex and edge hash table lookups
+        HEAP_OPERATION,     // priority queue insertions, extractions and key decreases
+        NODE_EXPANDED,      // vertices settled by searches, and backtracking steps
+        COUNTERS
+    };
+
+    /**
+     * @brief True if the counters are compiled in.
+     */
+#ifdef TSP_INSTRUMENTATION
+    static constexpr bool COUNTERS_ENABLED = true;
+#else
+    static constexpr bool COUNTERS_ENABLED = false;
+#endif
+
+    /**
+     * @brief The phase times and counts gathered since the last reset.
+     */
+    struct Snapshot {
+        double seconds[PHASES] = {};
+        uint64_t counts[COUNTERS] = {};
+    };
+
+    /**
+     * @brief Times a phase from its construction to its destruction.
+     */
+    class PhaseTimer {
+        Phase phase;
+        chrono::steady_clock::time_point start;
+    public:
+        explicit PhaseTimer(Phase phase) : phase(phase), start(chrono::steady_clock::now()) {}
+        ~PhaseTimer() {
+            auto end = chrono::steady_clock::now();
+            auto elapsed = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+            phaseNanoseconds[phase].fetch_add((uint64_t) elapsed, memory_order_relaxed);
+            if (tracing.load(memory_order_relaxed)) record(phaseName(phase), start, end);
+        }
+        PhaseTimer(const PhaseTimer &) = delete;
+        PhaseTimer &operator=(const PhaseTimer &) = delete;
+    };
+
+    /**
+     * @brief Records a trace event from its construction to its destruction, if tracing is on.
+     *
+     * @details Given a worker number, the span (and everything traced inside it) goes to the track of that worker,
+     * numbered from 1; the main thread is track 0. Without one, it goes to the track of the enclosing span.
+     */
+    class TraceSpan {
+        const char *name;
+        int previousTrack;
+        chrono::steady_clock::time_point start;
+    public:
+        explicit TraceSpan(const char *name, int worker = -1) : name(name), previousTrack(track), start(chrono::steady_clock::now()) {
+            if (worker >= 0) track = worker + 1;
+        }
+        ~TraceSpan() {
+            if (tracing.load(memory_order_relaxed)) record(name, start, chrono::steady_clock::now());
+            track = previousTrack;
+        }
+        TraceSpan(const TraceSpan &) = delete;
+        TraceSpan &operator=(const TraceSpan &) = delete;
+    };
+
+    /**
+     * @brief Adds to a counter of the calling thread. Use TSP_COUNT instead, which is compiled out when disabled.
+     *
+     * @param counter The counter.
+     * @param amount The amount to add.
+     *
+     * @complexity O(1).
+     */
+    static void count(Counter counter, uint64_t amount = 1) {
+        local.counts[counter] += amount;
+    }
+
+    /**
+     * @brief Clears the phase times and the counts of the calling thread and of the threads that exited.
+     *
+     * @details Threads still running keep their counts, so reset between runs, not during them.
+     *
+     * @complexity O(1).
+     */
+    static void reset();
+
+    /**
+     * @brief Adds the counts of the calling thread to the shared totals and clears them, as if the thread exited.
+     *
+     * @details For threads that outlive a run, like the workers of a ThreadPool, so that snapshot sees their counts.
+     *
+     * @complexity O(1).
+     */
+    static void flushThread();
+
+    /**
+     * @brief Gets the phase times and the counts of the calling thread and of the threads that exited.
+     *
+     * @return The snapshot.
+     *
+     * @complexity O(1).
+     */
+    static Snapshot snapshot();
+
+    /**
+     * @brief Gets the name of a phase.
+     *
+     * @param phase The phase.
+     *
+     * @return The name, in lower case.
+     */
+    static const char *phaseName(Phase phase);
+
+    /**
+     * @brief Gets the name of a counter.
+     *
+     * @param counter The counter.
+     *
+     * @return The name, in lower case with underscores.
+     */
+    static const char *counterName(Counter counter);
+
+    /**
+     * @brief Prints the phases that took any time and, if compiled in, every counter, one per line.
+     *
+     * @param out The stream to print to.
+     * @param snapshot The snapshot to print.
+     */
+    static void print(ostream &out, const Snapshot &snapshot);
+
+    /**
+     * @brief Writes a snapshot as the members "phases" (seconds per phase) and, if compiled in, "counters" of a
+     * JSON object, without the enclosing braces.
+     *
+     * @param out The stream to write to.
+     * @param snapshot The snapshot to write.
+     */
+    static void writeJson(ostream &out, const Snapshot &snapshot);
+
+    /**
+     * @brief Quotes a string for a JSON document, escaping quotes, backslashes and control characters.
+     *
+     * @details Shared by every writer of JSON results (the batch mode, tsp_bench and writeTrace).
+     *
+     * @param s The string.
+     *
+     * @return The JSON string literal, quotes included.
+     */
+    static string jsonString(const string &s);
+
+    /**
+     * @brief Starts recording trace events, discarding those recorded before. Times are measured from here.
+     */
+    static void startTrace();
+
+    /**
+     * @brief Stops recording trace events, keeping those recorded so far for writeTrace.
+     */
+    static void stopTrace();
+
+    /**
+     * @brief Writes the recorded trace events as a trace event JSON document, which chrome://tracing and Perfetto
+     * open offline.
+     *
+     * @param out The stream to write to.
+     *
+     * @complexity O(E log E), where E is the number of events.
+     */
+    static void writeTrace(ostream &out);
+
+private:
+    /**
+     * @brief The counters of one thread, added to the shared totals when the thread exits or calls flushThread.
+     */
+    struct ThreadCounts {
+        uint64_t counts[COUNTERS] = {};
+
+        // Defined here, as every program that includes the header runs it at thread exit, even without
+        // Instrumentation.cpp (e.g. tsp_generate)
+        ~ThreadCounts() {
+            for (int c = 0; c < COUNTERS; c++) exitedCounts[c].fetch_add(counts[c], memory_order_relaxed);
+        }
+    };
+
+    static thread_local ThreadCounts local;
+    static atomic<uint64_t> exitedCounts[COUNTERS];
+    static atomic<uint64_t> phaseNanoseconds[PHASES];
+
+    /**
+     * @brief A recorded span: its name, its track and its times in microseconds since the trace started.
+     */
+    struct TraceEvent {
+        string name;
+        int track;
+        double start, duration;
+    };
+
+    static atomic<bool> tracing;
+    static thread_local int track;
+    static mutex traceMutex;
+    static chrono::steady_clock::time_point traceOrigin;
+    static vector<TraceEvent> traceEvents;
+
+    /**
+     * @brief Records a span on the track of the calling thread.
+     *
+     * @param name The name of the span.
+     * @param start The time it started.
+     * @param end The time it ended.
+     */
+    static void record(const char *name, chrono::steady_clock::time_point start, chrono::steady_clock::time_point end);
+};
+
+inline thread_local Instrumentation::ThreadCounts Instrumentation::local;
+inline atomic<uint64_t> Instrumentation::exitedCounts[COUNTERS] = {};
+inline atomic<uint64_t> Instrumentation::phaseNanoseconds[PHASES] = {};
+inline atomic<bool> Instrumentation::tracing{false};
+inline thread_local int Instrumentation::track = 0;
+inline mutex Instrumentation::traceMutex;
+inline chrono::steady_clock::time_point Instrumentation::traceOrigin;
+inline vector<Instrumentation::TraceEvent> Instrumentation::traceEvents;
+
+#ifdef TSP_INSTRUMENTATION
+#define TSP_COUNT(counter) Instrumentation::count(Instrumentation::counter)
+#else
+#define TSP_COUNT(counter) ((void) 0)
+#endif
+
+#endif //FEUP_DA_PROJECT_2_INSTRUMENTATION_H
@@ -0,0 +1,136 @@
+#include "Memory.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+
+#if defined(TSP_INSTRUMENTATION) && defined(__GLIBC__)
+#include <malloc.h>
+
+static atomic<size_t> heapInUse{0};
+static atomic<size_t> heapPeak{0};
+
+// Allocate a block and add its usable size to the heap in use, raising the peak if needed
+static void *trackedAllocate(size_t size, bool nothrow) {
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        if (nothrow) return nullptr;
+        throw bad_alloc();
+    }
+    size_t bytes = malloc_usable_size(p);
+    size_t now = heapInUse.fetch_add(bytes, memory_order_relaxed) + bytes;
+    size_t peak = heapPeak.load(memory_order_relaxed);
+    while (now > peak && !heapPeak.compare_exchange_weak(peak, now, memory_order_relaxed)) {}
+    return p;
+}
+
+// Free a block, subtracting its usable size from the heap in use
+static void trackedFree(void *p) {
+    if (!p) return;
+    heapInUse.fetch_sub(malloc_usable_size(p), memory_order_relaxed);
+    free(p);
+}
+
+void *operator new(size_t size) { return trackedAllocate(size, false); }
+void *operator new[](size_t size) { return trackedAllocate(size, false); }
+void *operator new(size_t size, const nothrow_t &) noexcept { return trackedAllocate(size, true); }
+void *operator new[](size_t size, const nothrow_t &) noexcept { return trackedAllocate(size, true); }
+void operator delete(void *p) noexcept { trackedFree(p); }
+void operator delete[](void *p) noexcept { trackedFree(p); }
+void operator delete(void *p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void *p, size_t) noexcept { trackedFree(p); }
+void operator delete(void *p, const nothrow_t &) noexcept { trackedFree(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { trackedFree(p); }
+#endif
+
+// Read a field of /proc/self/status, in kB, or -1 if it is not available
+static long procStatusKB(const string &field) {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, field.size() + 1, field + ":") == 0) return stol(line.substr(field.size() + 1));
+    }
+    return -1;
+}
+
+// Sum the bytes of the structures
+size_t Memory::Report::structureBytes() const {
+    return vertexObjects + edgeObjects + vertexTable + adjacencyTables + metricClosure + contractionHierarchy + analysis;
+}
+
+// Fill in the resident sizes and the heap counters
+void Memory::measureProcess(Report &report) {
+    report.residentKB = procStatusKB("VmRSS");
+    report.peakResidentKB = procStatusKB("VmHWM");
+#if defined(TSP_INSTRUMENTATION) && defined(__GLIBC__)
+    report.heapBytes = heapInUse.load(memory_order_relaxed);
+    report.heapPeakBytes = heapPeak.load(memory_order_relaxed);
+#endif
+}
+
+// Reset the peak resident set size and the heap peak to the current sizes
+void Memory::resetPeaks() {
+    ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs.is_open()) clearRefs << "5";
+#if defined(TSP_INSTRUMENTATION) && defined(__GLIBC__)
+    heapPeak.store(heapInUse.load(memory_order_relaxed), memory_order_relaxed);
+#endif
+}
+
+// Format a number of bytes with a binary unit
+string Memory::formatBytes(double bytes) {
+    static const char *const units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    int unit = 0;
+    while (bytes >= 1024 && unit < 4) {
+        bytes /= 1024;
+        unit++;
+    }
+    ostringstream out;
+    out << fixed << setprecision(unit ? 1 : 0) << bytes << ' ' << units[unit];
+    return out.str();
+}
+
+// Print a report, one line per structure or measurement
+void Memory::print(ostream &out, const Report &report) {
+    const pair<const char *, size_t> structures[] = {
+            {"vertices", report.vertexObjects},
+            {"edges", report.edgeObjects},
+            {"vertex table", report.vertexTable},
+            {"adjacency tables", report.adjacencyTables},
+            {"metric closure", report.metricClosure},
+            {"hierarchy", report.contractionHierarchy},
+            {"analysis", report.analysis}
+    };
+    ios state(nullptr);
+    state.copyfmt(out);
+    out << "Memory:" << endl;
+    for (const auto &structure : structures) {
+        if (structure.second == 0) continue;
+        out << "  " << left << setw(18) << structure.first << right << formatBytes((double) structure.second) << endl;
+    }
+    out << "  " << left << setw(18) << "structures" << right << formatBytes((double) report.structureBytes()) << endl;
+    if (report.residentKB >= 0)
+        out << "  " << left << setw(18) << "resident" << right << formatBytes(report.residentKB * 1024.0) << endl;
+    if (report.peakResidentKB >= 0)
+        out << "  " << left << setw(18) << "peak resident" << right << formatBytes(report.peakResidentKB * 1024.0) << endl;
+    if (HEAP_TRACKING) {
+        out << "  " << left << setw(18) << "heap" << right << formatBytes((double) report.heapBytes) << endl;
+        out << "  " << left << setw(18) << "peak heap" << right << formatBytes((double) report.heapPeakBytes) << endl;
+    }
+    out.copyfmt(state);
+}
+
+// Write a report as a member of a JSON object
+void Memory::writeJson(ostream &out, const Report &report) {
+    out << "\"memory\": {\"vertices\": " << report.vertexObjects << ", \"edges\": " << report.edgeObjects
+        << ", \"vertexTable\": " << report.vertexTable << ", \"adjacencyTables\": " << report.adjacencyTables
+        << ", \"metricClosure\": " << report.metricClosure << ", \"contractionHierarchy\": " << report.contractionHierarchy
+        << ", \"analysis\": " << report.analysis << ", \"structures\": " << report.structureBytes()
+        << ", \"residentKB\": " << report.residentKB << ", \"peakResidentKB\": " << report.peakResidentKB;
+    if (HEAP_TRACKING) out << ", \"heapBytes\": " << report.heapBytes << ", \"heapPeakBytes\": " << report.heapPeakBytes;
+    out << "}";
+}
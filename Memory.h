@@ -0,0 +1,144 @@
+#ifndef FEUP_DA_PROJECT_2_MEMORY_H
+#define FEUP_DA_PROJECT_2_MEMORY_H
+
+#include <cstddef>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/************************* Memory  **************************/
+
+/**
+ * @brief Memory accounting: the bytes held by the graph and its indexes, and the memory of the process.
+ *
+ * @details The structures are accounted explicitly from their sizes, as the allocator sees them: every object,
+ * hash table node and vector buffer is a separate heap block, rounded up like glibc's malloc does (blockBytes).
+ * The figures are estimates, close to but not exactly what the allocator holds, and do not include the memory
+ * freed to the allocator but not to the system.
+ *
+ * The resident set size and its peak are read from /proc/self/status on Linux. The peak can be reset (by writing
+ * to /proc/self/clear_refs) so that it covers one run only.
+ *
+ * When the program is built with TSP_INSTRUMENTATION, operator new and delete are also replaced by a tracking
+ * allocator that keeps the heap bytes in use and their peak, which covers the scratch memory of the solvers that
+ * no structure holds once they return. It costs two atomic operations per allocation, so it is compiled out
+ * otherwise.
+ */
+class Memory {
+public:
+    /**
+     * @brief True if the tracking allocator is compiled in.
+     */
+#if defined(TSP_INSTRUMENTATION) && defined(__GLIBC__)
+    static constexpr bool HEAP_TRACKING = true;
+#else
+    static constexpr bool HEAP_TRACKING = false;
+#endif
+
+    /**
+     * @brief A memory report: the structures of a loaded graph and the memory of the process.
+     */
+    struct Report {
+        size_t vertexObjects = 0;           // Vertex objects
+        size_t edgeObjects = 0;             // Edge objects
+        size_t vertexTable = 0;             // buckets and nodes of the graph's vertex hash table
+        size_t adjacencyTables = 0;         // buckets and nodes of the adjacency hash tables of the vertices
+        size_t metricClosure = 0;           // distance matrix, cached rows and adjacency arrays of the metric closure
+        size_t contractionHierarchy = 0;    // contraction hierarchy index
+        size_t analysis = 0;                // low-degree vertices, articulation points and bridges
+        long residentKB = -1;               // resident set size, -1 if unknown
+        long peakResidentKB = -1;           // peak resident set size since the last reset, -1 if unknown
+        size_t heapBytes = 0;               // heap in use, with HEAP_TRACKING
+        size_t heapPeakBytes = 0;           // peak heap in use since the last reset, with HEAP_TRACKING
+
+        /**
+         * @brief Gets the bytes of all the structures.
+         *
+         * @return The sum of the structure fields.
+         */
+        size_t structureBytes() const;
+    };
+
+    /**
+     * @brief Estimates the size of the heap block malloc uses for a request: the request and a header, rounded
+     * up to 16 bytes, and at least 32.
+     *
+     * @param requested The bytes requested.
+     *
+     * @return The bytes of the block, 0 for no request.
+     */
+    static size_t blockBytes(size_t requested) {
+        if (requested == 0) return 0;
+        size_t block = (requested + sizeof(size_t) + 15) & ~(size_t) 15;
+        return block < 32 ? 32 : block;
+    }
+
+    /**
+     * @brief Estimates the heap bytes of a vector: its buffer.
+     *
+     * @param v The vector.
+     *
+     * @return The bytes of the buffer.
+     */
+    template <class T>
+    static size_t vectorBytes(const vector<T> &v) {
+        return blockBytes(v.capacity() * sizeof(T));
+    }
+
+    /**
+     * @brief Estimates the heap bytes of a hash table: its bucket array and a node (the next pointer and the
+     * key-value pair) per element.
+     *
+     * @param map The hash table.
+     *
+     * @return The bytes of the buckets and nodes.
+     */
+    template <class K, class V, class H, class E, class A>
+    static size_t hashTableBytes(const unordered_map<K, V, H, E, A> &map) {
+        size_t buckets = map.bucket_count() > 1 ? blockBytes(map.bucket_count() * sizeof(void *)) : 0;
+        return buckets + map.size() * blockBytes(sizeof(void *) + sizeof(pair<const K, V>));
+    }
+
+    /**
+     * @brief Fills in the process fields of a report: resident set size, its peak and the heap counters.
+     *
+     * @param report The report to fill in.
+     */
+    static void measureProcess(Report &report);
+
+    /**
+     * @brief Resets the peak resident set size, where the kernel allows it, and the heap peak to the current
+     * sizes, so that the next measureProcess reports the peaks since now.
+     */
+    static void resetPeaks();
+
+    /**
+     * @brief Formats a number of bytes with a binary unit, e.g. "12.3 MiB".
+     *
+     * @param bytes The bytes.
+     *
+     * @return The formatted size.
+     */
+    static string formatBytes(double bytes);
+
+    /**
+     * @brief Prints a report, one structure or measurement per line; unknown ones are left out.
+     *
+     * @param out The stream to print to.
+     * @param report The report to print.
+     */
+    static void print(ostream &out, const Report &report);
+
+    /**
+     * @brief Writes a report as the member "memory" of a JSON object, in bytes and kB (for the resident sizes).
+     *
+     * @param out The stream to write to.
+     * @param report The report to write.
+     */
+    static void writeJson(ostream &out, const Report &report);
+};
+
+
+#endif //FEUP_DA_PROJECT_2_MEMORY_H
@@ -0,0 +1,368 @@
+#include "MetricClosure.h"
+#include "IndexedPriorityQueue.h"
+#include "PairingHeap.h"
+#include "RadixHeap.h"
+
+/************************* MetricClosure  **************************/
+
+// Constructor: snapshot the edges of the vertices, and compute every row if the closure is small enough
+MetricClosure::MetricClosure(const vector<Vertex *> &nodes, ThreadPool &pool, const ContractionHierarchy *hierarchy,
+                             HeapKind heap)
+        : n((int) nodes.size()), pool(pool), hierarchy(hierarchy), heap(heap) {
+    for (int i = 0; i < n; ++i) indices[nodes[i]->getId()] = i;
+
+    // Outgoing edges
+    edgeOffsets[0].assign(n + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        for (auto &pair : nodes[i]->getAdj()) {
+            auto it = indices.find(pair.first);
+            if (it == indices.end()) continue;
+            edgeTargets[0].push_back(it->second);
+            edgeWeights[0].push_back(pair.second->getWeight());
+        }
+        edgeOffsets[0][i + 1] = (int) edgeTargets[0].size();
+    }
+
+    // Incoming edges, bucketed by their target
+    edgeOffsets[1].assign(n + 1, 0);
+    for (int target : edgeTargets[0]) edgeOffsets[1][target + 1]++;
+    for (int i = 0; i < n; ++i) edgeOffsets[1][i + 1] += edgeOffsets[1][i];
+    edgeTargets[1].resize(edgeTargets[0].size());
+    edgeWeights[1].resize(edgeWeights[0].size());
+    vector<int> fill(edgeOffsets[1].begin(), edgeOffsets[1].end() - 1);
+    for (int i = 0; i < n; ++i) {
+        for (int e = edgeOffsets[0][i]; e < edgeOffsets[0][i + 1]; ++e) {
+            int slot = fill[edgeTargets[0][e]]++;
+            edgeTargets[1][slot] = i;
+            edgeWeights[1][slot] = edgeWeights[0][e];
+        }
+    }
+
+    // The haversine distance, scaled down by the smallest ratio between an edge weight and the distance between
+    // its ends, is a consistent heuristic: no edge is shorter than the heuristic difference between its ends
+    heuristicScale = 1;
+    for (Vertex *v : nodes) {
+        latitudes.push_back(v->getLatitude());
+        longitudes.push_back(v->getLongitude());
+        if (v->getLatitude() == numeric_limits<double>::max() || v->getLongitude() == numeric_limits<double>::max())
+            heuristicScale = 0;
+    }
+    for (int i = 0; i < n && heuristicScale > 0; ++i) {
+        for (int e = edgeOffsets[0][i]; e < edgeOffsets[0][i + 1]; ++e) {
+            int j = edgeTargets[0][e];
+            double straight = haversine(latitudes[i], longitudes[i], latitudes[j], longitudes[j]);
+            if (edgeWeights[0][e] < straight * heuristicScale) heuristicScale = edgeWeights[0][e] / straight;
+        }
+    }
+
+    dense = n <= DENSE_LIMIT;
+    maxCachedRows = max<size_t>(1, CACHE_BYTES / (sizeof(double) * max(1, n)));
+
+    if (dense) {
+        matrix.resize((size_t) n * n);
+        vector<int> sources(n);
+        for (int i = 0; i < n; ++i) sources[i] = i;
+        parallelRows(sources, [this](int source, vector<double> &&distances) {
+            copy(distances.begin(), distances.end(), matrix.begin() + (ptrdiff_t) source * n);
+        });
+    }
+}
+
+// Getter for the number of vertices
+int MetricClosure::size() const {
+    return n;
+}
+
+// Heap bytes of the matrix, the cached rows and the adjacency arrays
+size_t MetricClosure::memoryBytes() {
+    size_t bytes = Memory::hashTableBytes(indices) + Memory::vectorBytes(matrix)
+            + Memory::vectorBytes(latitudes) + Memory::vectorBytes(longitudes);
+    for (int d = 0; d < 2; d++) {
+        bytes += Memory::vectorBytes(edgeOffsets[d]) + Memory::vectorBytes(edgeTargets[d]) + Memory::vectorBytes(edgeWeights[d]);
+    }
+
+    shared_lock<shared_mutex> lock(cacheMutex);
+    bytes += Memory::hashTableBytes(cache) + cacheOrder.size() * sizeof(int);
+    for (const auto &pair : cache) {
+        // make_shared puts the vector and its control block in one block, and the distances in another
+        bytes += Memory::blockBytes(sizeof(vector<double>) + 2 * sizeof(long) + sizeof(void *)) + Memory::vectorBytes(*pair.second);
+    }
+    return bytes;
+}
+
+// Getter for the index of a vertex
+int MetricClosure::indexOf(int id) const {
+    auto it = indices.find(id);
+    return it == indices.end() ? -1 : it->second;
+}
+
+// Check if the whole matrix was computed at construction
+bool MetricClosure::isDense() const {
+    return dense;
+}
+
+// Check if A* can be used
+bool MetricClosure::hasAdmissibleHeuristic() const {
+    return heuristicScale > 0;
+}
+
+// Shortest-path distance between two vertices
+double MetricClosure::distance(int source, int target) {
+    if (dense) return matrix[(size_t) source * n + target];
+
+    {
+        shared_lock<shared_mutex> lock(cacheMutex);
+        auto it = cache.find(source);
+        if (it != cache.end()) return (*it->second)[target];
+    }
+
+    // Not cached: callers usually scan every target of a source, so the row pays off after a few lookups
+    return (*row(source))[target];
+}
+
+// Shortest-path distance between two vertices, without computing or caching rows
+double MetricClosure::pointDistance(int source, int target) {
+    if (dense) return matrix[(size_t) source * n + target];
+
+    {
+        shared_lock<shared_mutex> lock(cacheMutex);
+        auto it = cache.find(source);
+        if (it != cache.end()) return (*it->second)[target];
+    }
+
+    // Not cached: a point-to-point query is much cheaper than computing the whole row
+    if (hierarchy) {
+        thread_local ContractionHierarchy::Workspace hierarchyWorkspace;
+        return hierarchy->distance(source, target, hierarchyWorkspace);
+    }
+    thread_local Workspace workspace;
+    return hasAdmissibleHeuristic() ? aStar(source, target, workspace) : bidirectionalDijkstra(source, target, workspace);
+}
+
+// Shortest-path distances from a vertex, computing the row if it is not cached
+shared_ptr<const vector<double>> MetricClosure::row(int source) {
+    if (dense) {
+        auto begin = matrix.begin() + (ptrdiff_t) source * n;
+        return make_shared<const vector<double>>(begin, begin + n);
+    }
+
+    {
+        shared_lock<shared_mutex> lock(cacheMutex);
+        auto it = cache.find(source);
+        if (it != cache.end()) return it->second;
+    }
+
+    // Compute outside the lock, so other threads can keep reading the cache
+    vector<double> distances = dijkstra(source);
+
+    lock_guard<shared_mutex> lock(cacheMutex);
+    auto it = cache.find(source);
+    if (it != cache.end()) return it->second; // Another thread computed it meanwhile
+    return cacheRow(source, std::move(distances));
+}
+
+// Compute and cache the missing rows of several vertices in parallel
+void MetricClosure::computeRows(const vector<int> &sources) {
+    if (dense) return;
+
+    vector<int> missing;
+    {
+        shared_lock<shared_mutex> lock(cacheMutex);
+        for (int source : sources) {
+            if (!cache.count(source)) missing.push_back(source);
+        }
+    }
+    parallelRows(missing, [this](int source, vector<double> &&distances) {
+        lock_guard<shared_mutex> lock(cacheMutex);
+        if (!cache.count(source)) cacheRow(source, std::move(distances));
+    });
+}
+
+// A* from source to target, with the (scaled) haversine distance to target as heuristic
+double MetricClosure::aStar(int source, int target, Workspace &workspace) const {
+    if (!hasAdmissibleHeuristic()) throw runtime_error("The haversine distance is not an admissible heuristic");
+    workspace.start(n);
+
+    auto heuristic = [&](int v) {
+        return heuristicScale * haversine(latitudes[v], longitudes[v], latitudes[target], longitudes[target]);
+    };
+
+    MutablePriorityQueue<Label, 4> queue;
+    Label &s = workspace.label(0, source);
+    s.dist = 0;
+    s.key = heuristic(source);
+    queue.insert(&s);
+
+    while (!queue.empty()) {
+        Label *u = queue.extractMin();
+        TSP_COUNT(NODE_EXPANDED);
+        if (u->index == target) return u->dist;
+
+        for (int e = edgeOffsets[0][u->index]; e < edgeOffsets[0][u->index + 1]; ++e) {
+            Label &v = workspace.label(0, edgeTargets[0][e]);
+            double dist = u->dist + edgeWeights[0][e];
+            if (dist >= v.dist) continue;
+
+            bool fresh = v.dist == numeric_limits<double>::max();
+            v.key = dist + (fresh ? heuristic(v.index) : v.key - v.dist);
+            v.dist = dist;
+            if (v.queueIndex) queue.decreaseKey(&v);
+            else queue.insert(&v);
+        }
+    }
+    return numeric_limits<double>::max();
+}
+
+// Bidirectional Dijkstra between source and target
+double MetricClosure::bidirectionalDijkstra(int source, int target, Workspace &workspace) const {
+    return bidirectionalSearch(source, target, workspace, nullptr);
+}
+
+// Shortest path between two vertices, visited in order
+bool MetricClosure::path(int source, int target, const function<void(int)> &visit) {
+    if (hierarchy) {
+        thread_local ContractionHierarchy::Workspace hierarchyWorkspace;
+        return hierarchy->path(source, target, hierarchyWorkspace, visit);
+    }
+
+    thread_local Workspace workspace;
+    int meeting[2] = {source, source};
+    if (bidirectionalSearch(source, target, workspace, meeting) == numeric_limits<double>::max()) return false;
+    if (source == target) return true;
+
+    // The forward predecessors lead back from the meeting edge to source, so that half is gathered first;
+    // the backward predecessors lead on from it to target
+    vector<int> firstHalf;
+    for (int v = meeting[0]; v != source; v = workspace.labels[0][v].parent) firstHalf.push_back(v);
+    for (auto it = firstHalf.rbegin(); it != firstHalf.rend(); ++it) visit(*it);
+    for (int v = meeting[1]; v != -1; v = workspace.labels[1][v].parent) visit(v);
+    return true;
+}
+
+// Bidirectional Dijkstra between source and target, recording the edge where the searches meet
+double MetricClosure::bidirectionalSearch(int source, int target, Workspace &workspace, int *meeting) const {
+    workspace.start(n);
+    if (source == target) return 0;
+
+    MutablePriorityQueue<Label, 4> queues[2];
+    for (int direction = 0; direction < 2; ++direction) {
+        Label &s = workspace.label(direction, direction == 0 ? source : target);
+        s.dist = s.key = 0;
+        queues[direction].insert(&s);
+    }
+
+    double best = numeric_limits<double>::max();
+    double lastSettled[2] = {0, 0};
+
+    // The searches take turns; once the last distances they settled add up to the best path seen, no
+    // shorter path can be found
+    for (int direction = 0; !queues[0].empty() && !queues[1].empty(); direction = 1 - direction) {
+        Label *u = queues[direction].extractMin();
+        TSP_COUNT(NODE_EXPANDED);
+        lastSettled[direction] = u->dist;
+        if (lastSettled[0] + lastSettled[1] >= best) break;
+
+        for (int e = edgeOffsets[direction][u->index]; e < edgeOffsets[direction][u->index + 1]; ++e) {
+            Label &v = workspace.label(direction, edgeTargets[direction][e]);
+            double dist = u->dist + edgeWeights[direction][e];
+
+            // A path through (u, v) where the searches meet
+            const Label &other = workspace.label(1 - direction, v.index);
+            if (other.dist != numeric_limits<double>::max() && dist + other.dist < best) {
+                best = dist + other.dist;
+                if (meeting) {
+                    meeting[0] = direction == 0 ? u->index : v.index;
+                    meeting[1] = direction == 0 ? v.index : u->index;
+                }
+            }
+
+            if (dist >= v.dist) continue;
+            v.dist = v.key = dist;
+            v.parent = u->index;
+            if (v.queueIndex) queues[direction].decreaseKey(&v);
+            else queues[direction].insert(&v);
+        }
+    }
+    return best;
+}
+
+// Dijkstra's algorithm from one source, with the chosen queue
+vector<double> MetricClosure::dijkstra(int source) const {
+    switch (heap) {
+        case HeapKind::BINARY: return dijkstraWith<IndexedPriorityQueue<2>>(source);
+        case HeapKind::PAIRING: return dijkstraWith<PairingHeap>(source);
+        case HeapKind::RADIX: return dijkstraWith<RadixHeap>(source);
+        default: return dijkstraWith<IndexedPriorityQueue<4>>(source);
+    }
+}
+
+// Dijkstra's algorithm from one source over the adjacency arrays
+template <class Queue>
+vector<double> MetricClosure::dijkstraWith(int source) const {
+    vector<double> distances(n, numeric_limits<double>::max());
+    Queue queue(n);
+    distances[source] = 0;
+    queue.insert(source, 0);
+
+    while (!queue.empty()) {
+        int u = queue.extractMin();
+        TSP_COUNT(NODE_EXPANDED);
+        for (int e = edgeOffsets[0][u]; e < edgeOffsets[0][u + 1]; ++e) {
+            int v = edgeTargets[0][e];
+            double dist = distances[u] + edgeWeights[0][e];
+            if (dist >= distances[v]) continue;
+
+            bool queued = distances[v] != numeric_limits<double>::max();
+            distances[v] = dist;
+            if (queued) queue.decreaseKey(v, dist);
+            else queue.insert(v, dist);
+        }
+    }
+
+    return distances;
+}
+
+// Compute rows in parallel on the pool, in chunks small enough to balance rows of uneven cost
+void MetricClosure::parallelRows(const vector<int> &sources, const function<void(int, vector<double> &&)> &store) const {
+    const size_t grain = max<size_t>(1, sources.size() / (8 * pool.size()));
+    pool.parallelFor(0, sources.size(), grain, [&](size_t begin, size_t end) {
+        Instrumentation::TraceSpan span("closure rows", ThreadPool::workerIndex());
+        for (size_t s = begin; s < end; ++s) store(sources[s], dijkstra(sources[s]));
+    });
+}
+
+// Add a row to the cache, dropping the oldest rows while it is full
+shared_ptr<const vector<double>> MetricClosure::cacheRow(int source, vector<double> &&distances) {
+    while (cacheOrder.size() >= maxCachedRows) {
+        cache.erase(cacheOrder.front());
+        cacheOrder.pop_front();
+    }
+    auto cached = make_shared<const vector<double>>(std::move(distances));
+    cache[source] = cached;
+    cacheOrder.push_back(source);
+    return cached;
+}
+
+/************************* Workspace  **************************/
+
+// Start a new query, invalidating every label at once
+void MetricClosure::Workspace::start(int n) {
+    if ((int) labels[0].size() != n || ++query == 0) {
+        for (int direction = 0; direction < 2; ++direction) {
+            labels[direction].assign(n, Label());
+            stamps[direction].assign(n, 0);
+        }
+        query = 1;
+    }
+}
+
+// Label of a vertex in one search, reset if it was last touched by an earlier query
+MetricClosure::Label &MetricClosure::Workspace::label(int direction, int index) {
+    Label &label = labels[direction][index];
+    if (stamps[direction][index] != query) {
+        stamps[direction][index] = query;
+        label = Label();
+        label.index = index;
+    }
+    return label;
+}
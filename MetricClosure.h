@@ -0,0 +1,316 @@
+#ifndef FEUP_DA_PROJECT_2_METRIC_CLOSURE_H
+#define FEUP_DA_PROJECT_2_METRIC_CLOSURE_H
+
+#include "Graph.h"
+#include "ContractionHierarchy.h"
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <deque>
+#include <functional>
+
+/************************* MetricClosure  **************************/
+
+/**
+ * @brief Shortest-path distances between the vertices of a graph (its metric closure).
+ *
+ * @details The closure works on a snapshot of the graph taken at construction: the vertices, sorted by id, are
+ * numbered 0 .. n - 1 and their edges are copied into compact adjacency arrays, so the graph must not change
+ * while the closure is in use. Each row, the distances from one source to every vertex, is computed with
+ * Dijkstra's algorithm (using a 4-ary IndexedPriorityQueue, or the queue given at construction) over those
+ * arrays, which keeps the graph's own vertices untouched and lets several rows be computed in parallel, on a
+ * ThreadPool.
+ * Up to DENSE_LIMIT vertices, every row is computed at construction into a dense matrix. Above it, rows are
+ * computed when first needed and kept in a cache of at most CACHE_BYTES, the oldest rows being dropped first.
+ * distance computes the row of its source, as callers usually scan many targets of one source; isolated
+ * distances are answered by pointDistance with point-to-point queries instead: the contraction hierarchy of the
+ * graph when one is given, A* with the haversine distance as heuristic when there are coordinates,
+ * bidirectional Dijkstra otherwise.
+ * All public methods are safe to call from several threads, as long as each thread uses its own Workspace.
+ */
+class MetricClosure {
+    /**
+     * @brief Per-query Dijkstra state of a vertex, kept apart from Vertex so queries can run concurrently.
+     */
+    struct Label {
+        double dist = numeric_limits<double>::max();
+        double key = numeric_limits<double>::max();     // queue priority: dist, plus the heuristic in A*
+        int index = 0;
+        int parent = -1;    // previous vertex on the path found by the search
+        int queueIndex = 0; // required by MutablePriorityQueue
+
+        bool operator<(const Label &other) const { return key < other.key; }
+    };
+
+public:
+    /**
+     * @brief Reusable state of point-to-point queries.
+     *
+     * @details Labels are reset lazily, by stamping them with the number of the query that last touched
+     * them, so a query only pays for the vertices it explores. A workspace must not be shared by threads.
+     */
+    class Workspace {
+        friend class MetricClosure;
+        vector<Label> labels[2];        // forward and backward search
+        vector<unsigned int> stamps[2];
+        unsigned int query = 0;
+
+        void start(int n);
+        Label &label(int direction, int index);
+    };
+
+    /**
+     * @brief Maximum number of vertices for which the whole matrix is computed at construction.
+     */
+    static constexpr int DENSE_LIMIT = 2000;
+
+    /**
+     * @brief Memory budget of the row cache used above DENSE_LIMIT vertices.
+     */
+    static constexpr size_t CACHE_BYTES = 256u << 20;
+
+    /**
+     * @brief Constructs the metric closure of a set of vertices.
+     *
+     * @details Only edges between vertices of the set are considered.
+     *
+     * @param nodes The vertices, sorted by id.
+     * @param pool The pool that computes rows in parallel, now and in computeRows. It must outlive the closure.
+     * @param hierarchy Optional contraction hierarchy built over the same vertices, used for point-to-point
+     * queries above DENSE_LIMIT vertices. It must outlive the closure.
+     * @param heap The priority queue of the Dijkstra searches that compute rows.
+     *
+     * @complexity O(|V| (|V| + |E|) log |V| / threads) up to DENSE_LIMIT vertices, O(|V| + |E|) above it.
+     */
+    explicit MetricClosure(const vector<Vertex *> &nodes, ThreadPool &pool = ThreadPool::serial(),
+                           const ContractionHierarchy *hierarchy = nullptr, HeapKind heap = HeapKind::DEFAULT);
+
+    /**
+     * @brief Returns the number of vertices of the closure.
+     *
+     * @return The number of vertices.
+     */
+    int size() const;
+
+    /**
+     * @brief Estimates the heap bytes of the closure: the matrix or the cached rows, and the adjacency arrays.
+     *
+     * @return The bytes (see Memory).
+     *
+     * @complexity O(r), r being the number of cached rows.
+     */
+    size_t memoryBytes();
+
+    /**
+     * @brief Returns the index of a vertex in the closure.
+     *
+     * @param id The id of the vertex.
+     *
+     * @return The index of the vertex, or -1 if it is not in the closure.
+     *
+     * @complexity O(1) on average.
+     */
+    int indexOf(int id) const;
+
+    /**
+     * @brief Checks whether the whole matrix was computed at construction.
+     *
+     * @return True if the closure is dense, false if rows are computed on demand.
+     */
+    bool isDense() const;
+
+    /**
+     * @brief Returns the shortest-path distance between two vertices.
+     *
+     * @details Above DENSE_LIMIT vertices, the row of source is computed and cached if it is not yet, so a
+     * scan over the targets of one source costs one Dijkstra search; use pointDistance for isolated lookups.
+     *
+     * @param source The index of the source vertex.
+     * @param target The index of the target vertex.
+     *
+     * @return The distance, or infinity (numeric_limits<double>::max()) if target cannot be reached.
+     *
+     * @complexity O(1) if the closure is dense or the row of source is cached, O((|V| + |E|) log |V|) otherwise.
+     */
+    double distance(int source, int target);
+
+    /**
+     * @brief Returns the shortest-path distance between two vertices, without computing a row.
+     *
+     * @details For isolated lookups: if the row of source is not cached, the distance comes from one
+     * point-to-point query (contraction hierarchy, aStar or bidirectionalDijkstra) and nothing is cached.
+     *
+     * @param source The index of the source vertex.
+     * @param target The index of the target vertex.
+     *
+     * @return The distance, or infinity (numeric_limits<double>::max()) if target cannot be reached.
+     *
+     * @complexity O(1) if the closure is dense or the row of source is cached, otherwise one point-to-point
+     * query, O((|V| + |E|) log |V|) in the worst case.
+     */
+    double pointDistance(int source, int target);
+
+    /**
+     * @brief Checks whether the haversine distance is an admissible A* heuristic for this graph.
+     *
+     * @details That is the case when every vertex has coordinates. Edges shorter than the great-circle distance
+     * between their ends (rounded weights, for example) are allowed: the heuristic is then scaled down at
+     * construction by the smallest ratio between an edge weight and that distance, so it never overestimates.
+     *
+     * @return True if A* can be used.
+     */
+    bool hasAdmissibleHeuristic() const;
+
+    /**
+     * @brief Shortest-path distance between two vertices using A* with the haversine distance as heuristic.
+     *
+     * @details The search is directed towards target, so it usually settles a small fraction of the vertices
+     * a full Dijkstra would. Requires hasAdmissibleHeuristic().
+     *
+     * @param source The index of the source vertex.
+     * @param target The index of the target vertex.
+     * @param workspace The workspace of the calling thread.
+     *
+     * @return The distance, or infinity (numeric_limits<double>::max()) if target cannot be reached.
+     *
+     * @throws std::runtime_error If some vertex has no coordinates (see hasAdmissibleHeuristic).
+     *
+     * @complexity O((|V| + |E|) log |V|) in the worst case.
+     */
+    double aStar(int source, int target, Workspace &workspace) const;
+
+    /**
+     * @brief Shortest-path distance between two vertices using bidirectional Dijkstra.
+     *
+     * @details A forward search from source and a backward search from target take turns, and stop once the
+     * sum of the last distances they settled reaches the best path seen where they meet.
+     *
+     * @param source The index of the source vertex.
+     * @param target The index of the target vertex.
+     * @param workspace The workspace of the calling thread.
+     *
+     * @return The distance, or infinity (numeric_limits<double>::max()) if target cannot be reached.
+     *
+     * @complexity O((|V| + |E|) log |V|) in the worst case.
+     */
+    double bidirectionalDijkstra(int source, int target, Workspace &workspace) const;
+
+    /**
+     * @brief Visits the vertices of a shortest path between two vertices, in order.
+     *
+     * @details With a contraction hierarchy the path comes from unpacking its shortcuts; otherwise from the
+     * predecessors recorded by a bidirectional Dijkstra. Either way, only the vertices of one path are kept.
+     *
+     * @param source The index of the source vertex.
+     * @param target The index of the target vertex.
+     * @param visit Called with the index of every vertex of the path after source, target included.
+     *
+     * @return True if target can be reached, false otherwise (and visit is not called).
+     *
+     * @complexity One point-to-point query plus O(p), p being the number of vertices of the path.
+     */
+    bool path(int source, int target, const function<void(int)> &visit);
+
+    /**
+     * @brief Returns the shortest-path distances from a vertex to every vertex.
+     *
+     * @param source The index of the source vertex.
+     *
+     * @return The row of source, indexed by vertex index. It stays valid even if the cache drops it.
+     *
+     * @complexity O(|V|) if the closure is dense, O(1) if the row is cached, O((|V| + |E|) log |V|) otherwise.
+     */
+    shared_ptr<const vector<double>> row(int source);
+
+    /**
+     * @brief Computes and caches the rows of several vertices in parallel.
+     *
+     * @details Useful before a loop that needs many rows. Does nothing if the closure is dense.
+     *
+     * @param sources The indices of the source vertices.
+     *
+     * @complexity O(s (|V| + |E|) log |V| / threads), s being the number of rows not yet cached.
+     */
+    void computeRows(const vector<int> &sources);
+
+private:
+    int n;
+    ThreadPool &pool;
+    unordered_map<int, int> indices;    // vertex id -> index
+
+    // Adjacency arrays: the edges of vertex i are edgeTargets / edgeWeights [edgeOffsets[i], edgeOffsets[i + 1]).
+    // Index 0 holds the outgoing edges and index 1 the incoming ones, for backward searches
+    vector<int> edgeOffsets[2];
+    vector<int> edgeTargets[2];
+    vector<double> edgeWeights[2];
+
+    vector<double> latitudes;
+    vector<double> longitudes;
+    const ContractionHierarchy *hierarchy;
+    HeapKind heap;                      // queue of dijkstra
+    double heuristicScale;              // haversine multiplier that keeps the A* heuristic admissible, 0 if none
+
+    bool dense;
+    vector<double> matrix;              // row-major n x n, when dense
+
+    shared_mutex cacheMutex;           // shared by lookups, exclusive when rows are added
+    unordered_map<int, shared_ptr<const vector<double>>> cache;
+    deque<int> cacheOrder;              // cached rows, oldest first
+    size_t maxCachedRows;
+
+    /**
+     * @brief Bidirectional Dijkstra that also reports the edge where the two searches meet on the shortest path.
+     *
+     * @param source The index of the source vertex.
+     * @param target The index of the target vertex.
+     * @param workspace The workspace of the calling thread; its labels keep the predecessors of both searches.
+     * @param meeting If not null, receives the ends of the meeting edge, in the direction from source to target.
+     *
+     * @return The distance, or infinity if target cannot be reached.
+     */
+    double bidirectionalSearch(int source, int target, Workspace &workspace, int *meeting) const;
+
+    /**
+     * @brief Computes one row with Dijkstra's algorithm, using the queue chosen at construction.
+     *
+     * @param source The index of the source vertex.
+     *
+     * @return The distances from source to every vertex.
+     *
+     * @complexity O((|V| + |E|) log |V|).
+     */
+    vector<double> dijkstra(int source) const;
+
+    /**
+     * @brief Computes one row with Dijkstra's algorithm and a given queue, for dijkstra.
+     *
+     * @tparam Queue IndexedPriorityQueue, PairingHeap or RadixHeap.
+     *
+     * @param source The index of the source vertex.
+     *
+     * @return The distances from source to every vertex.
+     */
+    template <class Queue>
+    vector<double> dijkstraWith(int source) const;
+
+    /**
+     * @brief Computes rows in parallel on the pool, handing each computed row to a callback.
+     *
+     * @param sources The indices of the source vertices.
+     * @param store Called with the source index and its row; calls may come from several threads at once.
+     */
+    void parallelRows(const vector<int> &sources, const function<void(int, vector<double> &&)> &store) const;
+
+    /**
+     * @brief Adds a row to the cache, dropping the oldest rows if the cache is full. Requires cacheMutex exclusively.
+     *
+     * @param source The index of the source vertex.
+     * @param distances The row.
+     *
+     * @return The cached row.
+     */
+    shared_ptr<const vector<double>> cacheRow(int source, vector<double> &&distances);
+};
+
+#endif //FEUP_DA_PROJECT_2_METRIC_CLOSURE_H
@@ -0,0 +1,160 @@
+#ifndef FEUP_DA_PROJECT_2_PAIRING_HEAP
+#define FEUP_DA_PROJECT_2_PAIRING_HEAP
+
+#include <vector>
+#include "Instrumentation.h"
+
+/**
+ * @brief A mutable priority queue of the integers 0 .. n - 1, each with a double key: a pairing heap.
+ *
+ * @details The heap is a tree where every node is not larger than its children, stored as first child / next
+ * sibling links in arrays indexed by element, next to the keys. Inserting and decreasing a key only link a node
+ * under the root (or the root under it), so both take constant time, and all the restructuring is left to
+ * extractions, which pair up the children of the old root from left to right and then merge the pairs from right
+ * to left. This suits searches that decrease many more keys than they extract. Same interface as
+ * IndexedPriorityQueue.
+ *
+ * @complexity Insertion: O(1); Extraction of Minimum: O(log n) amortized; Decrease Key: o(log n) amortized;
+ */
+
+class PairingHeap {
+        std::vector<int> child;         // first child of every node, -1 if none
+        std::vector<int> next;          // next sibling, -1 if none
+        std::vector<int> prev;          // previous sibling, or the parent of a first child; -1 for the root
+        std::vector<char> queued;
+        std::vector<double> keys;
+        std::vector<int> pairs;         // scratch list of extractMin
+        int root = -1;
+        int meld(int a, int b);
+        public:
+        explicit PairingHeap(int n);
+        void insert(int x, double key);
+        int extractMin();
+        void decreaseKey(int x, double key);
+        bool empty() const;
+        bool contains(int x) const;
+        double key(int x) const;
+};
+
+/**
+ * @brief Constructs a new, empty PairingHeap object.
+ *
+ * @param n The number of elements that can be queued, 0 .. n - 1.
+ */
+inline PairingHeap::PairingHeap(int n) : child(n), next(n), prev(n), queued(n, 0), keys(n) {}
+
+/**
+ * @brief Checks if the priority queue is empty.
+ *
+ * @return True if the priority queue is empty, otherwise false.
+ */
+inline bool PairingHeap::empty() const {
+    return root == -1;
+}
+
+/**
+ * @brief Checks if an element is in the priority queue.
+ *
+ * @param x The element.
+ *
+ * @return True if x is in the queue, otherwise false.
+ */
+inline bool PairingHeap::contains(int x) const {
+    return queued[x];
+}
+
+/**
+ * @brief Gets the key of an element.
+ *
+ * @param x The element, which must be in the queue.
+ *
+ * @return The key of x.
+ */
+inline double PairingHeap::key(int x) const {
+    return keys[x];
+}
+
+/**
+ * @brief Links two trees, the root with the larger key becoming the first child of the other.
+ *
+ * @param a The root of the first tree, with no siblings.
+ * @param b The root of the second tree, with no siblings.
+ *
+ * @return The root of the linked tree.
+ */
+inline int PairingHeap::meld(int a, int b) {
+    if (keys[b] < keys[a]) std::swap(a, b);
+    next[b] = child[a];
+    if (child[a] != -1) prev[child[a]] = b;
+    prev[b] = a;
+    child[a] = b;
+    return a;
+}
+
+/**
+ * @brief Inserts a new element into the priority queue.
+ *
+ * @param x The element, which must not be in the queue.
+ * @param key The key of x.
+ */
+inline void PairingHeap::insert(int x, double key) {
+    TSP_COUNT(HEAP_OPERATION);
+    keys[x] = key;
+    child[x] = next[x] = prev[x] = -1;
+    queued[x] = 1;
+    root = root == -1 ? x : meld(root, x);
+}
+
+/**
+ * @brief Decreases the key of an element in the priority queue.
+ *
+ * @details The subtree of x is cut from its parent, as its key may now be smaller than the parent's, and linked
+ * with the root.
+ *
+ * @param x The element, which must be in the queue.
+ * @param key The new key of x, not larger than its current key.
+ */
+inline void PairingHeap::decreaseKey(int x, double key) {
+    TSP_COUNT(HEAP_OPERATION);
+    keys[x] = key;
+    if (x == root) return;
+
+    int p = prev[x];
+    if (child[p] == x) child[p] = next[x];
+    else next[p] = next[x];
+    if (next[x] != -1) prev[next[x]] = p;
+    next[x] = prev[x] = -1;
+    root = meld(root, x);
+}
+
+/**
+ * @brief Extracts the element with the minimum key from the priority queue.
+ *
+ * @return The element extracted from the priority queue.
+ */
+inline int PairingHeap::extractMin() {
+    TSP_COUNT(HEAP_OPERATION);
+    int x = root;
+    queued[x] = 0;
+
+    // First pass: link the children in pairs, from left to right
+    pairs.clear();
+    for (int c = child[x]; c != -1;) {
+        int a = c, b = next[c];
+        c = b == -1 ? -1 : next[b];
+        next[a] = prev[a] = -1;
+        if (b == -1) {
+            pairs.push_back(a);
+            break;
+        }
+        next[b] = prev[b] = -1;
+        pairs.push_back(meld(a, b));
+    }
+
+    // Second pass: merge the pairs from right to left
+    root = -1;
+    for (auto it = pairs.rbegin(); it != pairs.rend(); ++it) root = root == -1 ? *it : meld(*it, root);
+    return x;
+}
+
+#endif /* FEUP_DA_PROJECT_2_PAIRING_HEAP */
@@ -0,0 +1,194 @@
+#ifndef FEUP_DA_PROJECT_2_RADIX_HEAP
+#define FEUP_DA_PROJECT_2_RADIX_HEAP
+
+#include <vector>
+#include "Instrumentation.h"
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief A monotone priority queue of the integers 0 .. n - 1, each with a non-negative double key: a radix heap.
+ *
+ * @details Keys may never be smaller than the last extracted key, which holds for Dijkstra's algorithm (and for A*
+ * with a consistent heuristic) but not for Prim's. The bits of a non-negative double compare like the double
+ * itself, so keys are handled as 64-bit integers: bucket i holds the elements whose key first differs from the
+ * last extracted key at bit i - 1, and bucket 0 those equal to it. Extractions take bucket 0 when it is not empty;
+ * otherwise the first non-empty bucket is spread over the lower buckets around its minimum, and every element moves
+ * down at most 64 times in all. Comparisons are replaced by a few bit operations, which pays off on the integer-ish
+ * weights of road networks. Same interface as IndexedPriorityQueue.
+ *
+ * @complexity Insertion: O(1); Extraction of Minimum: O(log C) amortized, C being the largest key as an integer
+ * (at most 64 moves per element); Decrease Key: O(1);
+ */
+
+class RadixHeap {
+        static constexpr int BUCKETS = 65;
+
+        std::vector<int> buckets[BUCKETS];
+        std::vector<int> bucketOf;      // bucket of every element, -1 if it is not in the queue
+        std::vector<int> position;      // position of every element in its bucket
+        std::vector<double> keys;
+        uint64_t last = 0;              // bits of the last extracted key
+        int count = 0;
+
+        static uint64_t bits(double key);
+        int bucketFor(double key) const;
+        void place(int x);
+        void unplace(int x);
+        public:
+        explicit RadixHeap(int n);
+        void insert(int x, double key);
+        int extractMin();
+        void decreaseKey(int x, double key);
+        bool empty() const;
+        bool contains(int x) const;
+        double key(int x) const;
+};
+
+/**
+ * @brief Constructs a new, empty RadixHeap object.
+ *
+ * @param n The number of elements that can be queued, 0 .. n - 1.
+ */
+inline RadixHeap::RadixHeap(int n) : bucketOf(n, -1), position(n), keys(n) {}
+
+/**
+ * @brief Checks if the priority queue is empty.
+ *
+ * @return True if the priority queue is empty, otherwise false.
+ */
+inline bool RadixHeap::empty() const {
+    return count == 0;
+}
+
+/**
+ * @brief Checks if an element is in the priority queue.
+ *
+ * @param x The element.
+ *
+ * @return True if x is in the queue, otherwise false.
+ */
+inline bool RadixHeap::contains(int x) const {
+    return bucketOf[x] != -1;
+}
+
+/**
+ * @brief Gets the key of an element.
+ *
+ * @param x The element, which must be in the queue.
+ *
+ * @return The key of x.
+ */
+inline double RadixHeap::key(int x) const {
+    return keys[x];
+}
+
+/**
+ * @brief Reinterprets a non-negative double as an integer with the same order.
+ *
+ * @param key The key.
+ *
+ * @return The bits of the key.
+ */
+inline uint64_t RadixHeap::bits(double key) {
+    uint64_t b;
+    std::memcpy(&b, &key, sizeof b);
+    return b;
+}
+
+/**
+ * @brief Finds the bucket of a key, relative to the last extracted key.
+ *
+ * @param key The key, not smaller than the last extracted key.
+ *
+ * @return The bucket index.
+ */
+inline int RadixHeap::bucketFor(double key) const {
+    uint64_t difference = bits(key) ^ last;
+    return difference == 0 ? 0 : 64 - __builtin_clzll(difference);
+}
+
+/**
+ * @brief Adds an element to the bucket of its key.
+ *
+ * @param x The element.
+ */
+inline void RadixHeap::place(int x) {
+    int b = bucketFor(keys[x]);
+    bucketOf[x] = b;
+    position[x] = (int) buckets[b].size();
+    buckets[b].push_back(x);
+}
+
+/**
+ * @brief Removes an element from its bucket, moving the last element of the bucket into its place.
+ *
+ * @param x The element.
+ */
+inline void RadixHeap::unplace(int x) {
+    std::vector<int> &bucket = buckets[bucketOf[x]];
+    int moved = bucket.back();
+    bucket[position[x]] = moved;
+    position[moved] = position[x];
+    bucket.pop_back();
+    bucketOf[x] = -1;
+}
+
+/**
+ * @brief Inserts a new element into the priority queue.
+ *
+ * @param x The element, which must not be in the queue.
+ * @param key The key of x, not smaller than the last extracted key.
+ */
+inline void RadixHeap::insert(int x, double key) {
+    TSP_COUNT(HEAP_OPERATION);
+    keys[x] = key;
+    place(x);
+    count++;
+}
+
+/**
+ * @brief Decreases the key of an element in the priority queue.
+ *
+ * @param x The element, which must be in the queue.
+ * @param key The new key of x, not larger than its current key nor smaller than the last extracted key.
+ */
+inline void RadixHeap::decreaseKey(int x, double key) {
+    TSP_COUNT(HEAP_OPERATION);
+    unplace(x);
+    keys[x] = key;
+    place(x);
+}
+
+/**
+ * @brief Extracts the element with the minimum key from the priority queue.
+ *
+ * @return The element extracted from the priority queue.
+ */
+inline int RadixHeap::extractMin() {
+    TSP_COUNT(HEAP_OPERATION);
+    if (buckets[0].empty()) {
+        // Spread the first non-empty bucket around its minimum, which then becomes the last extracted key
+        int b = 1;
+        while (buckets[b].empty()) b++;
+        int minimum = buckets[b][0];
+        for (int x : buckets[b]) {
+            if (keys[x] < keys[minimum]) minimum = x;
+        }
+        last = bits(keys[minimum]);
+
+        std::vector<int> spread;
+        spread.swap(buckets[b]);
+        for (int x : spread) place(x);
+        spread.clear();
+        spread.swap(buckets[b]); // Keep the capacity; nothing lands in bucket b again
+    }
+
+    int x = buckets[0].back();
+    buckets[0].pop_back();
+    bucketOf[x] = -1;
+    count--;
+    return x;
+}
+
+#endif /* FEUP_DA_PROJECT_2_RADIX_HEAP */
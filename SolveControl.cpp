@@ -0,0 +1,52 @@
+#include "SolveControl.h"
+
+#include <cmath>
+
+// Constructor: the deadline is the time limit from now, or never
+SolveControl::SolveControl(double timeLimit) : start(chrono::steady_clock::now()) {
+    // Limits too large for the clock are no limit at all
+    if (isfinite(timeLimit) && timeLimit < 1e9) {
+        deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(max(0.0, timeLimit)));
+    } else {
+        deadline = chrono::steady_clock::time_point::max();
+    }
+}
+
+// Set the function called with every better tour
+void SolveControl::setProgress(Progress callback) {
+    progress = std::move(callback);
+}
+
+// Check the flag and the clock, raising the flag once the deadline has passed
+bool SolveControl::shouldStopNow() {
+    if (stop.load(memory_order_relaxed)) return true;
+    if (deadline == chrono::steady_clock::time_point::max() || chrono::steady_clock::now() < deadline) return false;
+    stop.store(true, memory_order_relaxed);
+    return true;
+}
+
+// Seconds left until the deadline
+double SolveControl::remaining() const {
+    if (stopped()) return 0;
+    if (deadline == chrono::steady_clock::time_point::max()) return numeric_limits<double>::infinity();
+    return max(0.0, chrono::duration<double>(deadline - chrono::steady_clock::now()).count());
+}
+
+// Seconds since the control was created
+double SolveControl::elapsed() const {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Publish a tour, calling the progress callback if it is the best so far
+void SolveControl::improve(double cost, const vector<Vertex *> &tour) {
+    lock_guard<mutex> lock(progressMutex);
+    if (cost >= best) return;
+    best = cost;
+    if (progress) progress(cost, tour, elapsed());
+}
+
+// Cost of the best tour published
+double SolveControl::bestCost() const {
+    lock_guard<mutex> lock(progressMutex);
+    return best;
+}
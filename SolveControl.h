@@ -0,0 +1,139 @@
+#ifndef FEUP_DA_PROJECT_2_SOLVECONTROL_H
+#define FEUP_DA_PROJECT_2_SOLVECONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+class Vertex;
+
+/************************* SolveControl  **************************/
+
+/**
+ * @brief Limits and observes a run of a TSP algorithm: a deadline, a cancellation token and a progress callback.
+ *
+ * @details The algorithms check the control in their main loops and stop once the deadline has passed or cancel
+ * was called, from any thread or from a signal handler. Exact and improving algorithms (backtracking and the
+ * metaheuristics) then return the best tour found so far; constructive heuristics have no tour until they finish,
+ * so they throw instead. Every algorithm publishes the tours it finds through improve, which calls the progress
+ * callback for the tours better than every tour published before.
+ *
+ * shouldStop is meant for the hottest loops: it reads an atomic flag, and the clock only every POLL_INTERVAL calls
+ * of each thread. Once a thread sees the deadline, it sets the flag, so the other threads stop at their next call.
+ */
+class SolveControl {
+public:
+    /**
+     * @brief Called with the cost of a better tour, the tour and the seconds since the control was created.
+     */
+    using Progress = function<void(double cost, const vector<Vertex *> &tour, double seconds)>;
+
+    /**
+     * @brief Number of calls of shouldStop, per thread, between two clock reads.
+     */
+    static constexpr unsigned int POLL_INTERVAL = 1024;
+
+    /**
+     * @brief Creates a control whose deadline is a time limit from now.
+     *
+     * @param timeLimit The time limit in seconds; infinity (the default) for none.
+     */
+    explicit SolveControl(double timeLimit = numeric_limits<double>::infinity());
+
+    /**
+     * @brief Sets the function called with every better tour published. Not thread-safe: set it before the run.
+     *
+     * @param callback The function; calls are serialised, so it needs no locking of its own.
+     */
+    void setProgress(Progress callback);
+
+    /**
+     * @brief Asks the algorithm to stop. Safe to call from any thread and from a signal handler.
+     */
+    void cancel() {
+        stop.store(true, memory_order_relaxed);
+    }
+
+    /**
+     * @brief Tells if the run was asked to stop, or was seen to pass its deadline, without reading the clock.
+     *
+     * @return True if the algorithm must stop.
+     */
+    bool stopped() const {
+        return stop.load(memory_order_relaxed);
+    }
+
+    /**
+     * @brief Tells if the algorithm must stop, reading the clock only every POLL_INTERVAL calls.
+     *
+     * @return True if the algorithm must stop.
+     *
+     * @complexity O(1).
+     */
+    bool shouldStop() {
+        if (stop.load(memory_order_relaxed)) return true;
+        if (++polls % POLL_INTERVAL) return false;
+        return shouldStopNow();
+    }
+
+    /**
+     * @brief Tells if the algorithm must stop, reading the clock. For loops whose iterations take a while.
+     *
+     * @return True if the algorithm must stop.
+     *
+     * @complexity O(1).
+     */
+    bool shouldStopNow();
+
+    /**
+     * @brief Gets the time left until the deadline.
+     *
+     * @return The seconds left, 0 if the run must stop, infinity if there is no deadline.
+     */
+    double remaining() const;
+
+    /**
+     * @brief Gets the time since the control was created.
+     *
+     * @return The seconds elapsed.
+     */
+    double elapsed() const;
+
+    /**
+     * @brief Publishes a tour found by the algorithm, calling the progress callback if it is the best so far.
+     *
+     * @details Thread-safe.
+     *
+     * @param cost The cost of the tour.
+     * @param tour The vertices of the tour in visiting order.
+     */
+    void improve(double cost, const vector<Vertex *> &tour);
+
+    /**
+     * @brief Gets the cost of the best tour published.
+     *
+     * @return The cost, or the largest double if no tour was published.
+     */
+    double bestCost() const;
+
+private:
+    chrono::steady_clock::time_point start;
+    chrono::steady_clock::time_point deadline;
+    atomic<bool> stop{false};
+
+    mutable mutex progressMutex;
+    Progress progress;
+    double best = numeric_limits<double>::max();
+
+    static thread_local unsigned int polls;
+};
+
+inline thread_local unsigned int SolveControl::polls = 0;
+
+
+#endif //FEUP_DA_PROJECT_2_SOLVECONTROL_H
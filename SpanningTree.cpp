@@ -0,0 +1,159 @@
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include "SpanningTree.h"
+#include "Instrumentation.h"
+#include "ThreadPool.h"
+#include "UnionFind.h"
+
+/************************* SpanningTree  **************************/
+
+// Splits [0, count) into contiguous slices, one per thread of the pool, and runs body(slice, begin, end) on each
+static void parallelSlices(size_t count, ThreadPool &pool, const function<void(unsigned int, size_t, size_t)> &body) {
+    const size_t minSlice = 1 << 12; // Below this, handing out a task costs more than it saves
+    const unsigned int slices = (unsigned int) min<size_t>(pool.size(), max<size_t>(1, count / minSlice));
+    if (slices == 1) {
+        body(0, 0, count);
+        return;
+    }
+
+    ThreadPool::TaskGroup group(pool);
+    for (unsigned int t = 0; t < slices; ++t) {
+        group.run([&, t]() {
+            Instrumentation::TraceSpan span("slice", ThreadPool::workerIndex());
+            body(t, count * t / slices, count * (t + 1) / slices);
+        });
+    }
+    group.wait();
+}
+
+// Sorts a vector on the pool: chunks are sorted concurrently, then merged pairwise in rounds
+template <typename T, typename Compare>
+static void parallelSort(vector<T> &items, ThreadPool &pool, Compare less) {
+    const size_t minChunk = 1 << 15; // Below this, handing out a task costs more than it saves
+    const size_t chunks = min<size_t>(pool.size(), max<size_t>(1, items.size() / minChunk));
+    if (chunks == 1) {
+        sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    vector<size_t> bounds(chunks + 1);
+    for (size_t c = 0; c <= chunks; ++c) bounds[c] = items.size() * c / chunks;
+
+    ThreadPool::TaskGroup sorts(pool);
+    for (size_t c = 0; c < chunks; ++c) {
+        sorts.run([&, c]() {
+            Instrumentation::TraceSpan span("sort", ThreadPool::workerIndex());
+            sort(items.begin() + (long) bounds[c], items.begin() + (long) bounds[c + 1], less);
+        });
+    }
+    sorts.wait();
+
+    for (size_t width = 1; width < chunks; width *= 2) {
+        ThreadPool::TaskGroup merges(pool);
+        for (size_t c = 0; c + width < chunks; c += 2 * width) {
+            auto first = items.begin() + (long) bounds[c];
+            auto middle = items.begin() + (long) bounds[c + width];
+            auto last = items.begin() + (long) bounds[min(c + 2 * width, chunks)];
+            merges.run([first, middle, last, less]() {
+                Instrumentation::TraceSpan span("merge", ThreadPool::workerIndex());
+                inplace_merge(first, middle, last, less);
+            });
+        }
+        merges.wait();
+    }
+}
+
+// Minimum spanning tree using Kruskal's algorithm
+vector<int> SpanningTree::kruskal(int n, const vector<WeightedEdge> &edges, ThreadPool &pool) {
+    vector<int> order(edges.size());
+    for (size_t e = 0; e < edges.size(); ++e) order[e] = (int) e;
+    parallelSort(order, pool, [&edges](int e, int f) {
+        return edges[e].weight < edges[f].weight || (edges[e].weight == edges[f].weight && e < f);
+    });
+
+    // Take the lightest edges that join two trees, until a single tree is left
+    UnionFind trees(n);
+    vector<int> tree;
+    for (int e : order) {
+        if (!trees.unite(edges[e].a, edges[e].b)) continue;
+        tree.push_back(e);
+        if ((int) tree.size() == n - 1) break;
+    }
+    return tree;
+}
+
+// Minimum spanning tree using a parallel version of Boruvka's algorithm
+vector<int> SpanningTree::boruvka(int n, const vector<WeightedEdge> &edges, ThreadPool &pool) {
+    const unsigned int threads = pool.size();
+    const auto lighter = [&edges](int e, int f) {
+        return edges[e].weight < edges[f].weight || (edges[e].weight == edges[f].weight && e < f);
+    };
+
+    ConcurrentUnionFind components(n);
+    vector<int> component(n);                                // Root of the component of each vertex, this round
+    unique_ptr<atomic<int>[]> cheapest(new atomic<int>[n]); // Lightest edge leaving each component, by its root
+    for (int v = 0; v < n; ++v) {
+        component[v] = v;
+        cheapest[v].store(-1, memory_order_relaxed);
+    }
+    vector<int> active(edges.size());                         // Edges that may still join two components
+    for (size_t e = 0; e < edges.size(); ++e) active[e] = (int) e;
+    vector<vector<int>> kept(threads);
+    vector<vector<int>> roots(threads);
+    vector<vector<int>> chosen(threads);
+    vector<int> tree;
+
+    while (!active.empty()) {
+        // Lightest edge leaving each component, kept per component with an atomic minimum. Edges inside a
+        // component are dropped for good
+        parallelSlices(active.size(), pool, [&](unsigned int t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                int e = active[i];
+                int a = component[edges[e].a], b = component[edges[e].b];
+                if (a == b) continue;
+                kept[t].push_back(e);
+                for (int root : {a, b}) {
+                    int current = cheapest[root].load(memory_order_relaxed);
+                    while ((current == -1 || lighter(e, current)) &&
+                           !cheapest[root].compare_exchange_weak(current, e, memory_order_relaxed)) {}
+                    if (current == -1) roots[t].push_back(root); // This thread made the first choice of the component
+                }
+            }
+        });
+        active.clear();
+        for (auto &edgesOfThread : kept) {
+            active.insert(active.end(), edgesOfThread.begin(), edgesOfThread.end());
+            edgesOfThread.clear();
+        }
+        if (active.empty()) break;
+
+        // Add the edge chosen by every component, merging it with the component at the other end
+        vector<int> growing;
+        for (auto &rootsOfThread : roots) {
+            growing.insert(growing.end(), rootsOfThread.begin(), rootsOfThread.end());
+            rootsOfThread.clear();
+        }
+        parallelSlices(growing.size(), pool, [&](unsigned int t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                int e = cheapest[growing[i]].load(memory_order_relaxed);
+                if (e != -1 && components.unite(edges[e].a, edges[e].b)) chosen[t].push_back(e);
+            }
+        });
+        for (auto &edgesOfThread : chosen) {
+            tree.insert(tree.end(), edgesOfThread.begin(), edgesOfThread.end());
+            edgesOfThread.clear();
+        }
+
+        // Give every vertex the root of its merged component, and clear the choices for the next round
+        parallelSlices(growing.size(), pool, [&](unsigned int, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) cheapest[growing[i]].store(-1, memory_order_relaxed);
+        });
+        parallelSlices(n, pool, [&](unsigned int, size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) component[v] = components.find((int) v);
+        });
+    }
+
+    return tree;
+}
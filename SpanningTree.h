@@ -0,0 +1,68 @@
+#ifndef FEUP_DA_PROJECT_2_SPANNING_TREE_H
+#define FEUP_DA_PROJECT_2_SPANNING_TREE_H
+
+#include <vector>
+
+using namespace std;
+
+class ThreadPool;
+
+/************************* SpanningTree  **************************/
+
+/**
+ * @brief Minimum spanning trees of graphs given as edge lists over the vertices 0 .. n - 1.
+ *
+ * @details Edges are compared by weight and then by their position in the list, so every edge has a distinct
+ * rank and the minimum spanning tree is unique: both algorithms return the same edges for the same list, which
+ * keeps the tours built from them reproducible whichever is used. If the graph is not connected, the result is
+ * a minimum spanning forest, with one tree per connected component.
+ */
+class SpanningTree {
+public:
+    /**
+     * @brief An undirected edge between the vertices a and b.
+     */
+    struct WeightedEdge {
+        double weight;
+        int a, b;
+    };
+
+    /**
+     * @brief Minimum spanning tree using Kruskal's algorithm.
+     *
+     * @details The edges are sorted on the pool (chunks sorted concurrently, then merged pairwise) and
+     * added lightest first whenever they join two trees, which is checked with a union-find structure.
+     *
+     * @param n The number of vertices.
+     * @param edges The edges.
+     * @param pool The thread pool that sorts the edges.
+     *
+     * @return The positions in edges of the edges of the tree.
+     *
+     * @complexity O(|E| log |E|), dominated by the sort.
+     */
+    static vector<int> kruskal(int n, const vector<WeightedEdge> &edges, ThreadPool &pool);
+
+    /**
+     * @brief Minimum spanning tree using a parallel version of Boruvka's algorithm.
+     *
+     * @details Every round, each thread of the pool takes a slice of the edges that still join two components and offers
+     * each one to the components at both of its ends, which keep the lightest edge offered with an atomic minimum;
+     * edges inside a component are dropped for good. The threads then add the edge chosen by each component of
+     * their slice, merging the components with a lock-free union-find (ConcurrentUnionFind); an edge chosen from
+     * both of its ends is only added by whichever thread merges first. Finally every vertex is given the root of
+     * its merged component, so the next round finds components without walking the union-find. Every round at
+     * least halves the number of components that can still grow.
+     *
+     * @param n The number of vertices.
+     * @param edges The edges.
+     * @param pool The thread pool that runs the rounds.
+     *
+     * @return The positions in edges of the edges of the tree.
+     *
+     * @complexity O((|V| + |E|) log |V| / threads), as there are at most log |V| rounds, and usually far fewer.
+     */
+    static vector<int> boruvka(int n, const vector<WeightedEdge> &edges, ThreadPool &pool);
+};
+
+#endif //FEUP_DA_PROJECT_2_SPANNING_TREE_H
@@ -0,0 +1,104 @@
+#include "HeuristicMenuState.h"
+#include "MainMenuState.h"
+#include "States/Utils/GetTimeBudgetState.h"
+#include "States/Utils/GetStartingVertexState.h"
+
+// Constructor for HeuristicMenuState
+HeuristicMenuState::HeuristicMenuState() = default;
+
+// Display function to print the heuristic algorithms options
+void HeuristicMenuState::display() const {
+    cout << "\033[32m";
+    cout << "========== HEURISTICS ==========" << endl;
+    cout << "\033[0m";
+    cout << "   1. Nearest Neighbor          " << endl;
+    cout << "   2. Simulated Annealing       " << endl;
+    cout << "   3. Genetic Algorithm         " << endl;
+    cout << "   4. Ant Colony Optimization   " << endl;
+    cout << "   5. Space-Filling Curve       " << endl;
+    cout << "   6. Greedy Edge               " << endl;
+    cout << "   7. Cheapest Insertion        " << endl;
+    cout << "   8. Farthest Insertion        " << endl;
+    cout << "   9. Savings (Clarke-Wright)   \n" << endl;
+
+    cout << "   q. Main Menu       " << endl;
+    cout << "\033[32m";
+    cout << "--------------------------------" << endl;
+    cout << "\033[0m";
+    cout << "Enter your choice: ";
+}
+
+// Function to handle user input and run the chosen heuristic
+void HeuristicMenuState::handleInput(App* app) {
+    string choice;
+    cin >> choice;
+
+    if (choice.size() == 1) {
+        switch (choice[0]) {
+            case '1':
+                // Execute TSPNearestNeighbor algorithm, measure time, and display results
+                runTimed(app, [app](SolveControl &control) { app->getData()->TSPNearestNeighbor(&control); });
+                app->setState(new MainMenuState());
+                break;
+            case '2':
+                // Ask for the time budget, then execute TSPSimulatedAnnealing and display results
+                app->setState(new GetTimeBudgetState(this, [](App *app, double seconds) {
+                    runTimed(app, [app, seconds](SolveControl &control) { app->getData()->TSPSimulatedAnnealing(seconds, &control); });
+                    app->setState(new MainMenuState());
+                }));
+                break;
+            case '3':
+                // Ask for the time budget, then execute TSPGeneticAlgorithm and display results
+                app->setState(new GetTimeBudgetState(this, [](App *app, double seconds) {
+                    runTimed(app, [app, seconds](SolveControl &control) { app->getData()->TSPGeneticAlgorithm(seconds, &control); });
+                    app->setState(new MainMenuState());
+                }));
+                break;
+            case '4':
+                // Ask for the starting vertex and the time budget, then execute TSPAntColony and display results
+                app->setState(new GetStartingVertexState(this, [this](App *app, int id) {
+                    app->setState(new GetTimeBudgetState(this, [id](App *app, double seconds) {
+                        runTimed(app, [app, id, seconds](SolveControl &control) { app->getData()->TSPAntColony(id, seconds, &control); });
+                        app->setState(new MainMenuState());
+                    }));
+                }));
+                break;
+            case '5':
+                // Execute TSPSpaceFillingCurve algorithm, measure time, and display results
+                runTimed(app, [app](SolveControl &control) { app->getData()->TSPSpaceFillingCurve(&control); });
+                app->setState(new MainMenuState());
+                break;
+            case '6':
+                // Execute TSPGreedyEdge algorithm, measure time, and display results
+                runTimed(app, [app](SolveControl &control) { app->getData()->TSPGreedyEdge(&control); });
+                app->setState(new MainMenuState());
+                break;
+            case '7':
+                // Execute TSPCheapestInsertion algorithm, measure time, and display results
+                runTimed(app, [app](SolveControl &control) { app->getData()->TSPCheapestInsertion(&control); });
+                app->setState(new MainMenuState());
+                break;
+            case '8':
+                // Execute TSPFarthestInsertion algorithm, measure time, and display results
+                runTimed(app, [app](SolveControl &control) { app->getData()->TSPFarthestInsertion(&control); });
+                app->setState(new MainMenuState());
+                break;
+            case '9':
+                // Execute TSPSavings algorithm, measure time, and display results
+                runTimed(app, [app](SolveControl &control) { app->getData()->TSPSavings(&control); });
+                app->setState(new MainMenuState());
+                break;
+            case 'q':
+                app->setState(new MainMenuState()); // Transition back to main menu
+                break;
+            default:
+                // Display error message for invalid choice
+                cout << "\033[31m" << "Invalid choice. Please try again." << "\033[0m" << endl;
+        }
+    } else {
+        // Display error message for invalid input (more than one character)
+        cout << "\033[31m";
+        cout << "Invalid input. Please enter a single character." << endl;
+        cout << "\033[0m";
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef FEUP_DA_PROJECT_2_HEURISTIC_MENU_STATE_H
+#define FEUP_DA_PROJECT_2_HEURISTIC_MENU_STATE_H
+
+
+#include "State.h"
+
+/**
+* @brief Class representing the heuristic algorithms menu state of the program.
+*/
+
+class HeuristicMenuState : public State {
+public:
+
+    /**
+    * @brief Default constructor for HeuristicMenuState.
+    *
+    * @details This constructor initializes an instance of the HeuristicMenuState class. It doesn't require any parameters,
+    * as it represents the menu from which the user chooses which heuristic algorithm to run on the loaded graph.
+    */
+    HeuristicMenuState();
+
+    /**
+    * @brief Displays the heuristic algorithms menu options.
+    *
+    * @details This method prints the available heuristic algorithms to the console. Users input a single character
+    * corresponding to their desired algorithm ('q' to go back to the main menu).
+    */
+    void display() const override;
+
+    /**
+    * @brief Handles user input for the heuristic algorithms menu.
+    *
+    * @details This method prompts the user to input a single character representing their choice. It runs the chosen
+    * algorithm, measuring and displaying the elapsed time, or transitions to the state that collects the algorithm's
+    * parameters. If the input is invalid, the method notifies the user and prompts them to try again. The 'q' option
+    * goes back to the main menu.
+    *
+    * @param app A pointer to the application instance.
+    */
+    void handleInput(App* app) override;
+};
+
+
+#endif //FEUP_DA_PROJECT_2_HEURISTIC_MENU_STATE_H
@@ -1,6 +1,9 @@
 #include "MainMenuState.h"
+#include "HeuristicMenuState.h"
 #include "States/Utils/GetNodesFileMenuState.h"
 #include "States/Utils/GetStartingVertexState.h"
+#include "States/Utils/GetTimeBudgetState.h"
+#include "States/Utils/GetRouteFilePathState.h"
 
 // Constructor for MainMenuState
 MainMenuState::MainMenuState() = default;
@@ -13,8 +16,9 @@ void MainMenuState::display() const {
     cout << "   1. Load Graph               " << endl;
     cout << "   2. Backtracking Algorithm   " << endl;
     cout << "   3. Triangular Approximation " << endl;
-    cout << "   4. Heuristic Algorithm      " << endl;
-    cout << "   5. TSP in Real World Graphs \n" << endl;
+    cout << "   4. Heuristic Algorithms     " << endl;
+    cout << "   5. TSP in Real World Graphs " << endl;
+    cout << "   6. Best Effort (Portfolio)  \n" << endl;
 
     cout << "   q. Exit           " << endl;
     cout << "\033[32m";
@@ -58,7 +62,6 @@ void MainMenuState::handleInput(App* app) {
             }
         }
         else { // If a graph is loaded
-                clock_t start, end;
                 switch (choice[0]) {
                     case '1':
                         // Clear loaded graph data and transition to GetNodesFileMenuState
@@ -67,69 +70,32 @@ void MainMenuState::handleInput(App* app) {
                         break;
                     case '2':
                         // Execute TSPBacktracking algorithm, measure time, and display results
-                        try {
-                            start = clock();
-                            app->getData()->TSPBacktracking();
-                            end = clock();
-                            cout << "Elapsed time: " << fixed <<  setprecision(2) << double(end - start) / CLOCKS_PER_SEC << "s" << endl << endl;
-                        } catch (...) {
-                            cout << "\033[31m";
-                            cout << endl;
-                            cout << "Theres was an error!" << endl;
-                            cout << "Please check your graph." << endl << endl;
-                            cout << "\033[0m";
-                        }
-                        PressEnterToContinue();
+                        runTimed(app, [app](SolveControl &control) { app->getData()->TSPBacktracking(&control); });
                         break;
                     case '3':
                         // Execute TSPTriangular algorithm, measure time, and display results
-                        try {
-                            start = clock();
-                            app->getData()->TSPTriangular();
-                            end = clock();
-                            cout << "Elapsed time: " << fixed <<  setprecision(2) << double(end - start) / CLOCKS_PER_SEC << "s" << endl << endl;
-                        } catch (...) {
-                            cout << "\033[31m";
-                            cout << endl;
-                            cout << "Theres was an error!" << endl;
-                            cout << "Please check your graph." << endl << endl;
-                            cout << "\033[0m";
-                        }
-                        PressEnterToContinue();
+                        runTimed(app, [app](SolveControl &control) { app->getData()->TSPTriangular(&control); });
                         break;
                     case '4':
-                        // Execute TSPNearestNeighbor algorithm, measure time, and display results
-                        try {
-                            start = clock();
-                            app->getData()->TSPNearestNeighbor();
-                            end = clock();
-                            cout << "Elapsed time: " << fixed <<  setprecision(2) << double(end - start) / CLOCKS_PER_SEC << "s" << endl << endl;
-                        } catch (...) {
-                            cout << "\033[31m";
-                            cout << endl;
-                            cout << "Theres was an error!" << endl;
-                            cout << "Please check your graph." << endl << endl;
-                            cout << "\033[0m";
-                        }
-                        PressEnterToContinue();
+                        // Transition to HeuristicMenuState to choose which heuristic to run
+                        app->setState(new HeuristicMenuState());
                         break;
                     case '5':
                         // Transition to GetStartingVertexState with a lambda function to handle user input
-                        app->setState(new GetStartingVertexState(this, [&](App *app, int id) {
-                            // Execute TSPRealWorldNearestNeighbor algorithm, measure time, and display results
-                            try {
-                                start = clock();
-                                app->getData()->TSPRealWorldNearestNeighbor(id);
-                                end = clock();
-                                cout << "Elapsed time: " << fixed <<  setprecision(2) << double(end - start) / CLOCKS_PER_SEC << "s" << endl << endl;
-                            } catch (...) {
-                                cout << "\033[31m";
-                                cout << endl;
-                                cout << "Theres was an error!" << endl;
-                                cout << "Please check your graph." << endl << endl;
-                                cout << "\033[0m";
-                            }
-                            PressEnterToContinue();
+                        // (the callback runs after this call returns, so it must not capture its locals)
+                        app->setState(new GetStartingVertexState(this, [](App *app, int id) {
+                            // Ask where to save the route, if anywhere
+                            app->setState(new GetRouteFilePathState(new MainMenuState, [id](App *app, const filesystem::path &route) {
+                                // Execute TSPRealWorldNearestNeighbor algorithm, measure time, and display results
+                                runTimed(app, [app, id, route](SolveControl &control) { app->getData()->TSPRealWorldNearestNeighbor(id, route, &control); });
+                                app->setState(new MainMenuState);
+                            }));
+                        }));
+                        break;
+                    case '6':
+                        // Ask for the time budget, then race several algorithms and display the best result
+                        app->setState(new GetTimeBudgetState(this, [](App *app, double seconds) {
+                            runTimed(app, [app, seconds](SolveControl &control) { app->getData()->TSPPortfolio(seconds, &control); });
                             app->setState(new MainMenuState);
                         }));
                         break;
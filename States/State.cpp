@@ -1,5 +1,19 @@
 #include "State.h"
 
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iomanip>
+
+// Control of the algorithm running, which SIGINT cancels
+static atomic<SolveControl *> interruptible{nullptr};
+
+// Cancel the algorithm running, if any
+static void cancelOnInterrupt(int) {
+    SolveControl *control = interruptible.load();
+    if (control) control->cancel();
+}
+
 // Function to wait for user to press Enter to continue
 void State::PressEnterToContinue(int numPresses) {
     cout << "Press ENTER to continue... "; // Prompt user to press Enter
@@ -7,3 +21,41 @@ void State::PressEnterToContinue(int numPresses) {
     for (int i = 0; i < numPresses; ++i)
         cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Ignore input up to newline character
 }
+
+// Function to run an algorithm, displaying its wall-clock time, profile and memory
+void State::runTimed(App *app, const function<void(SolveControl &)> &algorithm) {
+    SolveControl control;
+    double lastPrinted = 0;
+    control.setProgress([&lastPrinted](double cost, const vector<Vertex *> &, double seconds) {
+        if (seconds < lastPrinted + 1) return;
+        lastPrinted = seconds;
+        ios state(nullptr);
+        state.copyfmt(cout);
+        cout << "  best so far: " << fixed << setprecision(1) << cost << " after " << setprecision(0) << seconds
+             << "s" << endl;
+        cout.copyfmt(state); // The result is printed with the format of the caller
+    });
+    cout << "Press Ctrl+C to stop early with the best tour found." << endl;
+    interruptible.store(&control);
+    auto previous = signal(SIGINT, cancelOnInterrupt);
+    try {
+        Instrumentation::reset();
+        Memory::resetPeaks();
+        auto start = chrono::steady_clock::now();
+        algorithm(control);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        cout << "Elapsed time: " << fixed <<  setprecision(2) << elapsed.count() << "s" << endl;
+        Instrumentation::print(cout, Instrumentation::snapshot());
+        Memory::print(cout, app->getData()->memoryReport());
+        cout << endl;
+    } catch (...) {
+        cout << "\033[31m";
+        cout << endl;
+        cout << "Theres was an error!" << endl;
+        cout << "Please check your graph." << endl << endl;
+        cout << "\033[0m";
+    }
+    signal(SIGINT, previous == SIG_ERR ? SIG_DFL : previous);
+    interruptible.store(nullptr);
+    PressEnterToContinue();
+}
@@ -48,6 +48,23 @@ public:
     * @param numPresses Number of times the user must press ENTER. Defaults to 2 if not specified.
     */
     static void PressEnterToContinue(int numPresses = 2) ;
+
+    /**
+    * @brief Runs an algorithm, displaying its elapsed time, profile and memory, then waits for ENTER.
+    *
+    * @details The elapsed time is wall-clock time (clock() would add up the time of every thread of the parallel
+    * algorithms), followed by the time of each phase of the run and, when the program is built with
+    * TSP_INSTRUMENTATION, the counts of its hot operations (see Instrumentation), and by the memory report of the
+    * data, with the peak memory of the run (see Memory). Errors thrown by the algorithm are displayed instead.
+    *
+    * The algorithm gets a SolveControl that Ctrl+C cancels while it runs, so a long search can be stopped with
+    * the best tour found so far, and whose progress callback prints the better tours found after the first
+    * second, at most one a second.
+    *
+    * @param app Pointer to the application context, whose data is reported.
+    * @param algorithm The algorithm to run, given the control of the run.
+    */
+    static void runTimed(App *app, const function<void(SolveControl &)> &algorithm);
 };
 
 
@@ -3,6 +3,8 @@
 #include "GetNodesFilePathState.h"
 #include "GetEdgesFilePathState.h"
 
+#include <chrono>
+
 // Constructor for GetNodesFileMenuState
 GetNodesFileMenuState::GetNodesFileMenuState() = default;
 
@@ -38,12 +40,13 @@ void GetNodesFileMenuState::handleInput(App* app) {
                     PressEnterToContinue(1);
                     app->setState(new GetEdgesFilePathState(this, [&](App *app) {
                         cout << "This might take some time... " << endl << endl;
-                        clock_t start, end;
-                        start = clock();
+                        auto start = chrono::steady_clock::now(); // wall-clock: the load runs on the thread pool
                         app->setData();
-                        end = clock();
+                        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
                         cout << "Network loaded successfully! " << endl;
-                        cout << "Elapsed time: " << fixed <<  setprecision(2) << double(end - start) / CLOCKS_PER_SEC << "s" << endl << endl;
+                        cout << "Elapsed time: " << fixed <<  setprecision(2) << elapsed.count() << "s" << endl;
+                        Memory::print(cout, app->getData()->memoryReport());
+                        cout << endl;
                         PressEnterToContinue(1);
                         app->setState(new MainMenuState()); // Transition back to main menu
                     }));
@@ -56,12 +59,13 @@ void GetNodesFileMenuState::handleInput(App* app) {
                 app->setState(new GetEdgesFilePathState(this, [&](App *app) {
                     app->setNodesFilePath(filesystem::path());
                     cout << "This might take some time... " << endl << endl;
-                    clock_t start, end;
-                    start = clock();
+                    auto start = chrono::steady_clock::now(); // wall-clock: the load runs on the thread pool
                     app->setData();
-                    end = clock();
+                    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
                     cout << "Network loaded successfully! " << endl;
-                    cout << "Elapsed time: " << fixed <<  setprecision(2) << double(end - start) / CLOCKS_PER_SEC << "s" << endl << endl;
+                    cout << "Elapsed time: " << fixed <<  setprecision(2) << elapsed.count() << "s" << endl;
+                    Memory::print(cout, app->getData()->memoryReport());
+                    cout << endl;
                     PressEnterToContinue(1);
                     app->setState(new MainMenuState()); // Transition back to main menu
                 }));
@@ -0,0 +1,34 @@
+#include "GetRouteFilePathState.h"
+#include "TryAgainState.h"
+
+// Constructor for GetRouteFilePathState
+GetRouteFilePathState::GetRouteFilePathState(State* backState, function<void(App*, const filesystem::path &)> nextStateCallback)
+        : backState(backState), nextStateCallback(std::move(nextStateCallback)) {}
+
+// Display function to prompt the user to insert the path of the route file
+void GetRouteFilePathState::display() const {
+    cout << "Insert path to save the route to (Ex: \"./route.csv\"), or \"-\" not to save it: ";
+}
+
+// Function to handle user input and verify if the route can be saved there
+void GetRouteFilePathState::handleInput(App* app) {
+    string path;
+    std::cin >> path;
+
+    if (path == "-") {
+        nextStateCallback(app, filesystem::path()); // Nothing to save
+        return;
+    }
+
+    filesystem::path file_path(path);
+    filesystem::path folder = file_path.parent_path().empty() ? filesystem::current_path() : file_path.parent_path();
+    error_code error;
+    if (filesystem::is_directory(folder, error) && !filesystem::is_directory(file_path, error)) {
+        nextStateCallback(app, file_path); // Call the callback function with the app and the path
+    } else {
+        cout << "\033[31m";
+        cout << "Invalid path. Please enter a file in an existing folder." << endl; // Display error messages
+        cout << "\033[0m";
+        app->setState(new TryAgainState(backState, this)); // Transition to TryAgainState
+    }
+}
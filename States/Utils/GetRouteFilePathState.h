@@ -0,0 +1,54 @@
+#ifndef FEUP_DA_PROJECT_2_GET_ROUTE_FILE_PATH_STATE_H
+#define FEUP_DA_PROJECT_2_GET_ROUTE_FILE_PATH_STATE_H
+
+
+#include <utility>
+#include "States/State.h"
+
+/**
+* @brief Class that represents a state for obtaining the path of the file a route is saved to, if any.
+*/
+
+class GetRouteFilePathState : public State {
+private:
+    State* backState;
+    function<void(App*, const filesystem::path &)> nextStateCallback;
+public:
+
+    /**
+    * @brief Constructs an instance of GetRouteFilePathState with specified back state and callback function.
+    *
+    * @details This constructor initializes an instance of the GetRouteFilePathState class with the given back state and
+    * a callback function for transitioning to the next state. The back state represents the state to which the
+    * application should return when the user chooses to go back from the current state. The callback function
+    * specifies the action to be performed with the path given by the user.
+    *
+    * @param backState A pointer to the state to which the application should return when the user chooses to go back.
+    * @param nextStateCallback A function defining the action to be performed with the path of the route file, empty
+    * if the route is not to be saved.
+    */
+    GetRouteFilePathState(State* backState, function<void(App*, const filesystem::path &)> nextStateCallback);
+
+    /**
+    * @brief Displays a prompt for inserting the path of the route file.
+    *
+    * @details This method prints a prompt to the console, asking the user to insert the path the route is saved to,
+    * or "-" not to save it.
+    */
+    void display() const override;
+
+    /**
+    * @brief Handles user input for obtaining the path of the route file.
+    *
+    * @details This method reads a path without spaces from the console. "-" calls the callback function with an empty
+    * path, so nothing is written. Otherwise, the path is accepted if its folder exists and it is not a folder itself;
+    * the file is only written once the route is found. If the input is invalid, the user is prompted with an error
+    * message, and the state transitions to a "Try Again" state, allowing the user to make another attempt.
+    *
+    * @param app A pointer to the application instance.
+    */
+    void handleInput(App* app) override;
+};
+
+
+#endif //FEUP_DA_PROJECT_2_GET_ROUTE_FILE_PATH_STATE_H
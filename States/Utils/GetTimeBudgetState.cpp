@@ -0,0 +1,29 @@
+#include "GetTimeBudgetState.h"
+#include "TryAgainState.h"
+
+// Constructor for GetTimeBudgetState
+GetTimeBudgetState::GetTimeBudgetState(State* backState, function<void(App*, double)> nextStateCallback)
+        : backState(backState), nextStateCallback(std::move(nextStateCallback)) {}
+
+// Display function to prompt the user to insert the time budget
+void GetTimeBudgetState::display() const {
+    cout << "Insert time budget in seconds (Ex: 10): ";
+}
+
+// Function to handle user input and verify if the time budget is valid
+void GetTimeBudgetState::handleInput(App* app) {
+    double seconds;
+    std::cin.ignore();
+    std::cin >> seconds;
+
+    if (std::cin && seconds > 0) {
+        nextStateCallback(app, seconds); // Call the callback function with the app and time budget
+    } else {
+        std::cin.clear();
+        std::cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Discard the invalid input
+        cout << "\033[31m";
+        cout << "Invalid time budget." << endl; // Display error messages
+        cout << "\033[0m";
+        app->setState(new TryAgainState(backState, this)); // Transition to TryAgainState
+    }
+}
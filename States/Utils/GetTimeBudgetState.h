@@ -0,0 +1,53 @@
+#ifndef FEUP_DA_PROJECT_2_GET_TIME_BUDGET_STATE_H
+#define FEUP_DA_PROJECT_2_GET_TIME_BUDGET_STATE_H
+
+
+#include <utility>
+#include "States/State.h"
+
+/**
+* @brief Class that represents a state for obtaining the time budget of an algorithm.
+*/
+
+class GetTimeBudgetState : public State {
+private:
+    State* backState;
+    function<void(App*, double)> nextStateCallback;
+public:
+
+    /**
+    * @brief Constructs an instance of GetTimeBudgetState with specified back state and callback function.
+    *
+    * @details This constructor initializes an instance of the GetTimeBudgetState class with the given back state and
+    * a callback function for transitioning to the next state. The back state represents the state to which the
+    * application should return when the user chooses to go back from the current state. The callback function
+    * specifies the action to be performed with the time budget given by the user.
+    *
+    * @param backState A pointer to the state to which the application should return when the user chooses to go back.
+    * @param nextStateCallback A function defining the action to be performed with the time budget, in seconds.
+    */
+    GetTimeBudgetState(State* backState, function<void(App*, double)> nextStateCallback);
+
+    /**
+    * @brief Displays a prompt for inserting the time budget.
+    *
+    * @details This method prints a prompt to the console, asking the user to insert the number of seconds the
+    * algorithm is allowed to run for.
+    */
+    void display() const override;
+
+    /**
+    * @brief Handles user input for obtaining the time budget.
+    *
+    * @details This method reads the time budget from the console and validates that it is a positive number.
+    * If the input is valid, the callback function is invoked with the time budget. If the input is invalid, the user
+    * is prompted with an error message, and the state transitions to a "Try Again" state, allowing the user to make
+    * another attempt.
+    *
+    * @param app A pointer to the application instance.
+    */
+    void handleInput(App* app) override;
+};
+
+
+#endif //FEUP_DA_PROJECT_2_GET_TIME_BUDGET_STATE_H
@@ -0,0 +1,171 @@
+#include "ThreadPool.h"
+
+#include "Instrumentation.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Run the next task of the group, keeping the first error
+bool ThreadPool::GroupState::runOne() {
+    function<void()> task;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (queue.empty()) return false;
+        task = std::move(queue.front());
+        queue.pop_front();
+    }
+    try {
+        task();
+    } catch (...) {
+        lock_guard<mutex> lock(doneMutex);
+        if (!error) error = current_exception();
+    }
+    Instrumentation::flushThread();
+    if (unfinished.fetch_sub(1) == 1) {
+        lock_guard<mutex> lock(doneMutex);
+        done.notify_all();
+    }
+    return true;
+}
+
+// Constructor: an empty group
+ThreadPool::TaskGroup::TaskGroup(ThreadPool &pool) : pool(pool), state(make_shared<GroupState>()) {}
+
+// Destructor: wait for the tasks, as they may refer to the caller's locals
+ThreadPool::TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {}
+}
+
+// Queue a task and hand the pool a ticket for it
+void ThreadPool::TaskGroup::run(function<void()> task) {
+    state->unfinished++;
+    {
+        lock_guard<mutex> lock(state->queueMutex);
+        state->queue.push_back(std::move(task));
+    }
+    pool.push(state);
+}
+
+// Run the tasks not yet started, then wait for those running elsewhere
+void ThreadPool::TaskGroup::wait() {
+    while (state->runOne()) {}
+    exception_ptr error;
+    {
+        unique_lock<mutex> lock(state->doneMutex);
+        state->done.wait(lock, [&]() { return state->unfinished.load() == 0; });
+        swap(error, state->error);
+    }
+    if (error) rethrow_exception(error);
+}
+
+// Constructor: start the workers and wait until they know their thread ids
+ThreadPool::ThreadPool(unsigned int threads) {
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    for (unsigned int w = 1; w < threads; w++) workers.push_back(make_unique<Worker>());
+    for (int w = 0; w < (int) workers.size(); w++) workers[w]->worker = thread(&ThreadPool::work, this, w);
+
+    unique_lock<mutex> lock(sleepMutex);
+    wake.wait(lock, [&]() { return started == (int) workers.size(); });
+}
+
+// Destructor: wake the workers to stop and join them
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers) w->worker.join();
+}
+
+// Kernel thread ids of the workers
+vector<int> ThreadPool::threadIds() const {
+    vector<int> ids;
+#ifdef __linux__
+    for (const auto &w : workers) ids.push_back(w->threadId);
+#endif
+    return ids;
+}
+
+// The pool without workers
+ThreadPool &ThreadPool::serial() {
+    static ThreadPool pool(1);
+    return pool;
+}
+
+// Put a ticket on the deque of the calling worker or on the injected queue, and wake a worker for it
+void ThreadPool::push(const shared_ptr<GroupState> &group) {
+    if (workers.empty()) return;
+    if (currentPool == this) {
+        Worker &own = *workers[currentWorker];
+        lock_guard<mutex> lock(own.ticketsMutex);
+        own.tickets.push_back(group);
+    } else {
+        lock_guard<mutex> lock(injectedMutex);
+        injected.push_back(group);
+    }
+    pending++;
+    {
+        lock_guard<mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+// Take the newest own ticket, the oldest injected one or steal the oldest of another worker
+shared_ptr<ThreadPool::GroupState> ThreadPool::take(int self) {
+    shared_ptr<GroupState> ticket;
+    {
+        Worker &own = *workers[self];
+        lock_guard<mutex> lock(own.ticketsMutex);
+        if (!own.tickets.empty()) {
+            ticket = std::move(own.tickets.back());
+            own.tickets.pop_back();
+        }
+    }
+    if (!ticket) {
+        lock_guard<mutex> lock(injectedMutex);
+        if (!injected.empty()) {
+            ticket = std::move(injected.front());
+            injected.pop_front();
+        }
+    }
+    for (size_t i = 1; !ticket && i < workers.size(); i++) {
+        Worker &victim = *workers[(self + i) % workers.size()];
+        lock_guard<mutex> lock(victim.ticketsMutex);
+        if (!victim.tickets.empty()) {
+            ticket = std::move(victim.tickets.front());
+            victim.tickets.pop_front();
+        }
+    }
+    if (ticket) pending--;
+    return ticket;
+}
+
+// Run tickets until the pool stops, sleeping while there are none
+void ThreadPool::work(int self) {
+    currentPool = this;
+    currentWorker = self;
+    {
+        lock_guard<mutex> lock(sleepMutex);
+#ifdef __linux__
+        workers[self]->threadId = (int) syscall(SYS_gettid);
+#endif
+        started++;
+    }
+    wake.notify_all();
+
+    while (true) {
+        // A ticket whose group has no task left (the waiting thread ran it) is just dropped
+        if (shared_ptr<GroupState> ticket = take(self)) {
+            ticket->runOne();
+            continue;
+        }
+        unique_lock<mutex> lock(sleepMutex);
+        if (stopping) return;
+        wake.wait(lock, [&]() { return stopping || pending.load() > 0; });
+    }
+}
@@ -0,0 +1,264 @@
+#ifndef FEUP_DA_PROJECT_2_THREADPOOL_H
+#define FEUP_DA_PROJECT_2_THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/************************* ThreadPool  **************************/
+
+/**
+ * @brief A work-stealing thread pool shared by the parallel algorithms, with task groups and parallel loops.
+ *
+ * @details The pool starts its workers once (one less than its size, as the thread waiting for a task group runs
+ * tasks too) and keeps them until it is destroyed, so the parallel loops of the solvers cost a few queue operations
+ * instead of starting and joining threads every time.
+ *
+ * Tasks are run in task groups. A group keeps its own queue of tasks, and hands the pool a ticket per task; each
+ * worker keeps the tickets of the tasks its own tasks add in a deque of its own, taking the newest first, and an
+ * idle worker steals the oldest ticket of another worker (or of the queue of the threads outside the pool). A
+ * ticket runs the next task of its group, if there is one left. Waiting for a group runs the tasks of that group
+ * only, on the waiting thread, until none is left to start; running unrelated tasks there could deadlock on a lock
+ * the waiting thread holds.
+ *
+ * Tasks are meant to be short-lived, data-parallel work: a task keeps its worker until it returns. Activities that
+ * must run side by side for a long time, like the entrants of Data::solvePortfolio, keep threads of their own.
+ *
+ * The workers add their Instrumentation counts to the shared totals after every task, so that a snapshot taken
+ * after a group is waited for includes them.
+ */
+class ThreadPool {
+    struct GroupState;
+public:
+    /**
+     * @brief A set of tasks run by the pool, that can be waited for together.
+     */
+    class TaskGroup {
+    public:
+        /**
+         * @brief Creates an empty group.
+         *
+         * @param pool The pool that runs the tasks.
+         */
+        explicit TaskGroup(ThreadPool &pool);
+
+        /**
+         * @brief Waits for the tasks still running, discarding their errors (call wait to get them).
+         */
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup &) = delete;
+        TaskGroup &operator=(const TaskGroup &) = delete;
+
+        /**
+         * @brief Adds a task to the group. It may start at once, on any thread of the pool.
+         *
+         * @param task The task.
+         */
+        void run(function<void()> task);
+
+        /**
+         * @brief Waits for every task of the group, running those not yet started on the calling thread.
+         *
+         * @throws The first exception thrown by a task, once all of them are done.
+         */
+        void wait();
+
+    private:
+        ThreadPool &pool;
+        shared_ptr<GroupState> state;
+    };
+
+    /**
+     * @brief Creates a pool and starts its workers.
+     *
+     * @param threads The number of threads that run tasks, the waiting thread included. 0 uses the hardware
+     * concurrency.
+     */
+    explicit ThreadPool(unsigned int threads = 0);
+
+    /**
+     * @brief Stops the workers, once they finish the tasks they are running.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Gets the number of threads that run tasks: the workers and the waiting thread.
+     *
+     * @return The size given to the constructor.
+     */
+    unsigned int size() const {
+        return (unsigned int) workers.size() + 1;
+    }
+
+    /**
+     * @brief Gets the kernel thread ids of the workers, for the counters that only see threads started after them
+     * (see HardwareCounters).
+     *
+     * @return The ids, empty on systems other than Linux.
+     */
+    vector<int> threadIds() const;
+
+    /**
+     * @brief Gets the number of the pool worker running the calling thread, e.g. for the track of a TraceSpan.
+     *
+     * @return The number, from 0, or -1 if the calling thread is not a worker of any pool.
+     */
+    static int workerIndex() {
+        return currentWorker;
+    }
+
+    /**
+     * @brief Gets a pool without workers, whose tasks all run on the waiting thread, for code given no pool.
+     *
+     * @return The pool.
+     */
+    static ThreadPool &serial();
+
+    /**
+     * @brief Runs a loop body over [begin, end) in chunks of grain iterations, in parallel.
+     *
+     * @details At most size() tasks are started, and each takes the next chunk still to do until none is left,
+     * so chunks of uneven cost are balanced between the threads.
+     *
+     * @param begin The first iteration.
+     * @param end One past the last iteration.
+     * @param grain The iterations per chunk; at least 1.
+     * @param body Called with the bounds [begin, end) of each chunk, from several threads at once.
+     *
+     * @throws The first exception thrown by body, once every chunk started is done.
+     */
+    template <class Body>
+    void parallelFor(size_t begin, size_t end, size_t grain, const Body &body) {
+        if (end <= begin) return;
+        grain = max<size_t>(1, grain);
+        const size_t chunks = (end - begin + grain - 1) / grain;
+        const size_t tasks = min<size_t>(chunks, size());
+        if (tasks == 1) {
+            body(begin, end);
+            return;
+        }
+
+        atomic<size_t> next{0};
+        TaskGroup group(*this);
+        for (size_t t = 0; t < tasks; ++t) {
+            group.run([&]() {
+                for (size_t c = next++; c < chunks; c = next++) body(begin + c * grain, min(end, begin + (c + 1) * grain));
+            });
+        }
+        group.wait();
+    }
+
+    /**
+     * @brief Maps the chunks of [begin, end) to values in parallel and reduces them, in the order of the chunks.
+     *
+     * @details Chunks are handed out like in parallelFor. As the values are reduced in order, the result is the
+     * same whatever the number of threads, as long as reduce is associative.
+     *
+     * @param begin The first iteration.
+     * @param end One past the last iteration.
+     * @param grain The iterations per chunk; at least 1.
+     * @param identity The value of an empty range.
+     * @param map Called with the bounds [begin, end) of each chunk, returning its value; from several threads.
+     * @param reduce Combines two values, the one of the earlier chunks first.
+     *
+     * @return The reduction of the values of every chunk, identity if the range is empty.
+     *
+     * @throws The first exception thrown by map, once every chunk started is done.
+     */
+    template <class T, class Map, class Reduce>
+    T parallelReduce(size_t begin, size_t end, size_t grain, T identity, const Map &map, const Reduce &reduce) {
+        if (end <= begin) return identity;
+        grain = max<size_t>(1, grain);
+        vector<T> values((end - begin + grain - 1) / grain, identity);
+        parallelFor(begin, end, grain, [&](size_t first, size_t last) { values[(first - begin) / grain] = map(first, last); });
+        T result = identity;
+        for (T &value : values) result = reduce(result, value);
+        return result;
+    }
+
+private:
+    /**
+     * @brief The queue, count and error of a task group, kept alive by the tickets that refer to it.
+     */
+    struct GroupState {
+        mutex queueMutex;
+        deque<function<void()>> queue;
+        atomic<size_t> unfinished{0};
+        mutex doneMutex;
+        condition_variable done;
+        exception_ptr error;
+
+        /**
+         * @brief Runs the next task of the group on the calling thread.
+         *
+         * @return False if no task was left to start.
+         */
+        bool runOne();
+    };
+
+    /**
+     * @brief A worker: its thread and the deque of the tickets added by its tasks.
+     */
+    struct Worker {
+        mutex ticketsMutex;
+        deque<shared_ptr<GroupState>> tickets;
+        thread worker;
+        int threadId = 0;
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    mutex injectedMutex;
+    deque<shared_ptr<GroupState>> injected;     // tickets added by threads outside the pool
+    atomic<size_t> pending{0};                   // tickets in all the deques
+    mutex sleepMutex;
+    condition_variable wake;
+    bool stopping = false;
+    int started = 0;                            // workers that set their thread id, under sleepMutex
+
+    static thread_local ThreadPool *currentPool;
+    static thread_local int currentWorker;
+
+    /**
+     * @brief Hands the pool a ticket for a task of a group: to the deque of the calling worker, or to the queue
+     * of the threads outside the pool.
+     *
+     * @param group The group of the task.
+     */
+    void push(const shared_ptr<GroupState> &group);
+
+    /**
+     * @brief Takes a ticket for a worker: its own newest, else the oldest injected one, else the oldest of another
+     * worker.
+     *
+     * @param self The number of the worker.
+     *
+     * @return The ticket, or nullptr if there is none.
+     */
+    shared_ptr<GroupState> take(int self);
+
+    /**
+     * @brief The loop of a worker: runs tickets, sleeping while there are none, until the pool stops.
+     *
+     * @param self The number of the worker.
+     */
+    void work(int self);
+};
+
+inline thread_local ThreadPool *ThreadPool::currentPool = nullptr;
+inline thread_local int ThreadPool::currentWorker = -1;
+
+
+#endif //FEUP_DA_PROJECT_2_THREADPOOL_H
@@ -0,0 +1,408 @@
+/**
+ * @file Benchmark.cpp
+ * @brief tsp_bench: runs the TSP algorithms over a set of graphs and sizes and reports their scaling as JSON.
+ *
+ * @details Every graph is loaded once per size (the vertices with the first ids in the files, see --sizes) and
+ * every algorithm is run on it a few times after some warmup runs, which are not measured but build the caches
+ * (metric closure, candidate lists) that later runs share. For each graph and algorithm the median and 95th
+ * percentile of the wall-clock time of the algorithm, the tour cost, its gap to the lower bound of the graph (see
+ * Data::lowerBound) and the peak resident memory are reported, together with the profile and the memory report
+ * of the last run (see Instrumentation and Memory) and, with --perf, its CPU counters, followed, for every
+ * algorithm, by the exponent k of the best fit of time ~ |V|^k over the sizes it solved. With --heaps, every graph
+ * is loaded and run again for each priority queue of Prim's and Dijkstra's algorithms (see HeapKind).
+ * Results go to standard output or --output; compare two of them with tsp_compare.
+ */
+
+#include "Data.h"
+
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+#include <unordered_set>
+
+using namespace std;
+
+/**
+ * @brief A graph to benchmark, given by its files.
+ */
+struct BenchGraph {
+    string name;
+    filesystem::path edges;
+    filesystem::path nodes;
+};
+
+/**
+ * @brief The measurements of one algorithm on one graph.
+ */
+struct BenchResult {
+    string graph;
+    int vertices = 0;
+    double loadSeconds = 0;
+    string algorithm;
+    string heap;                // priority queue of prim and of the metric closure, see Data::setHeap
+    bool solved = false;
+    double cost = 0;
+    double lowerBound = 0;      // lower bound on the cost of the tours of the graph, NaN if there is none
+    string error;
+    vector<double> samples;     // wall-clock seconds of the measured runs
+    long peakKB = -1;           // peak resident set size during the runs, -1 if unknown
+    Instrumentation::Snapshot profile;  // phase times and counters of the last run
+    HardwareCounters::Reading hardware; // CPU counters of the last run, with --perf
+    Memory::Report memory;      // structures after the last run and its peak memory
+};
+
+// Quantile of a list of samples, interpolating between the two nearest ranks
+static double quantile(vector<double> samples, double q) {
+    if (samples.empty()) return 0;
+    sort(samples.begin(), samples.end());
+    double rank = q * (samples.size() - 1);
+    size_t below = (size_t) rank;
+    if (below + 1 >= samples.size()) return samples.back();
+    return samples[below] + (rank - below) * (samples[below + 1] - samples[below]);
+}
+
+// Write copies of the files of a graph keeping only the vertices with the first n ids found, to measure sizes;
+// returns false if the graph does not have more than n vertices
+static bool truncateGraph(const BenchGraph &graph, int n, const filesystem::path &folder, BenchGraph &truncated) {
+    truncated = {graph.name + "@" + to_string(n), folder / (graph.name + "_" + to_string(n) + "_edges.csv"),
+                 graph.nodes.empty() ? filesystem::path() : folder / (graph.name + "_" + to_string(n) + "_nodes.csv")};
+    unordered_set<int> kept;
+    string line;
+
+    // Keep the first n vertices of the nodes file, or else the first n found in the edges file
+    auto firstId = [](const string &line, int &id) {
+        try {
+            id = stoi(line.substr(0, line.find(',')));
+            return true;
+        } catch (const exception &) {
+            return false; // Header
+        }
+    };
+    if (!graph.nodes.empty()) {
+        ifstream in(graph.nodes);
+        ofstream out(truncated.nodes);
+        if (!in.is_open() || !out.is_open()) throw runtime_error("Error truncating the nodes file of " + graph.name + ".");
+        while (getline(in, line)) {
+            int id;
+            if (!firstId(line, id)) out << line << '\n';
+            else if ((int) kept.size() < n && kept.insert(id).second) out << line << '\n';
+        }
+    }
+
+    ifstream in(graph.edges);
+    ofstream out(truncated.edges);
+    if (!in.is_open() || !out.is_open()) throw runtime_error("Error truncating the edges file of " + graph.name + ".");
+    while (getline(in, line)) {
+        stringstream ss(line);
+        string origin, dest;
+        getline(ss, origin, ',');
+        getline(ss, dest, ',');
+        int a, b;
+        try {
+            a = stoi(origin);
+            b = stoi(dest);
+        } catch (const exception &) {
+            out << line << '\n'; // Header
+            continue;
+        }
+        if (graph.nodes.empty()) {
+            if ((int) kept.size() < n) kept.insert(a);
+            if ((int) kept.size() < n) kept.insert(b);
+        }
+        if (kept.count(a) && kept.count(b)) out << line << '\n';
+    }
+    if ((int) kept.size() < n) return false;
+
+    // Make sure some vertex was left out
+    if (graph.nodes.empty()) {
+        in.clear();
+        in.seekg(0);
+        while (getline(in, line)) {
+            stringstream ss(line);
+            string origin, dest;
+            getline(ss, origin, ',');
+            getline(ss, dest, ',');
+            try {
+                if (!kept.count(stoi(origin)) || !kept.count(stoi(dest))) return true;
+            } catch (const exception &) {}
+        }
+        return false;
+    }
+    ifstream nodes(graph.nodes);
+    int lines = 0;
+    while (getline(nodes, line)) {
+        int id;
+        if (firstId(line, id)) lines++;
+    }
+    return lines > n;
+}
+
+// Benchmark every algorithm on a graph, with one priority queue
+static void benchmarkGraph(const BenchGraph &graph, const string &heap, const vector<string> &algorithms,
+                           bool algorithmsNamed, int warmup, int repetitions, double timeBudget, unsigned int threads,
+                           bool hardwareCounters, const filesystem::path &indexCacheFolder, vector<BenchResult> &results) {
+    Data data;
+    data.setThreads(threads);
+    data.setHeap(heap);
+    data.setIndexCacheFolder(indexCacheFolder);
+    data.setHardwareCounters(hardwareCounters);
+    data.setEdgesFilePath(graph.edges);
+    if (!graph.nodes.empty()) data.setNodesFilePath(graph.nodes);
+    auto start = chrono::steady_clock::now();
+    data.readFiles();
+    double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    int vertices = data.getAnalysis().vertices;
+    double lowerBound = data.lowerBound();
+    cerr << graph.name << (heap == "default" ? "" : " (" + heap + " heap)") << ": " << vertices << " vertices, loaded in " << fixed << setprecision(2) << loadSeconds
+         << "s" << defaultfloat << endl;
+
+    for (const string &algorithm : algorithms) {
+        BenchResult result;
+        result.graph = graph.name;
+        result.vertices = vertices;
+        result.loadSeconds = loadSeconds;
+        result.lowerBound = lowerBound;
+        result.algorithm = algorithm;
+        result.heap = heap;
+        if (algorithm == "backtracking" && (size_t) vertices > Data::EXACT_MAX_VERTICES) {
+            result.error = "Skipped: more than " + to_string(Data::EXACT_MAX_VERTICES) + " vertices.";
+            results.push_back(result);
+            continue;
+        }
+        if (!algorithmsNamed && (algorithm == "cheapest-insertion" || algorithm == "farthest-insertion")
+            && (size_t) vertices > Data::INSERTION_MAX_VERTICES) {
+            result.error = "Skipped: more than " + to_string(Data::INSERTION_MAX_VERTICES) + " vertices (name it to run it).";
+            results.push_back(result);
+            continue;
+        }
+
+        for (int i = 0; i < warmup + repetitions; i++) {
+            TSPRun run = data.solve(algorithm, 0, timeBudget, threads);
+            result.solved = run.solved;
+            result.cost = run.cost;
+            result.error = run.error;
+            if (!run.solved) break; // Failures are deterministic
+            if (i >= warmup) result.samples.push_back(run.seconds);
+            result.profile = run.profile;
+            result.hardware = run.hardware;
+            result.memory = run.memory;
+            result.peakKB = max(result.peakKB, run.memory.peakResidentKB);
+        }
+
+        cerr << "  " << algorithm << ": ";
+        if (result.solved) cerr << fixed << setprecision(4) << quantile(result.samples, 0.5) << "s median" << defaultfloat << endl;
+        else cerr << result.error << endl;
+        results.push_back(result);
+    }
+}
+
+// Fit time ~ |V|^k by least squares on the logarithms, over the graphs an algorithm solved with a heap
+static bool scalingExponent(const vector<BenchResult> &results, const string &algorithm, const string &heap,
+                            double &exponent, int &points) {
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    points = 0;
+    for (const BenchResult &result : results) {
+        double median = quantile(result.samples, 0.5);
+        if (result.algorithm != algorithm || result.heap != heap || !result.solved || result.vertices < 2 || median <= 0) continue;
+        double x = log((double) result.vertices), y = log(median);
+        sx += x; sy += y; sxx += x * x; sxy += x * y;
+        points++;
+    }
+    double denominator = points * sxx - sx * sx;
+    if (points < 2 || fabs(denominator) < 1e-12) return false;
+    exponent = (points * sxy - sx * sy) / denominator;
+    return true;
+}
+
+// Write the results as a JSON document
+static void writeJson(ostream &out, const vector<BenchResult> &results, const vector<string> &algorithms,
+                      const vector<string> &heaps, int warmup, int repetitions, double timeBudget, unsigned int threads) {
+    out << setprecision(9);
+    out << "{" << endl;
+    out << "  \"warmup\": " << warmup << "," << endl;
+    out << "  \"repetitions\": " << repetitions << "," << endl;
+    out << "  \"timeBudget\": " << timeBudget << "," << endl;
+    out << "  \"threads\": " << threads << "," << endl;
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        out << (i ? "," : "") << endl << "    {";
+        out << "\"graph\": " << Instrumentation::jsonString(r.graph) << ", \"vertices\": " << r.vertices;
+        out << ", \"loadSeconds\": " << r.loadSeconds;
+        out << ", \"algorithm\": " << Instrumentation::jsonString(r.algorithm);
+        out << ", \"heap\": " << Instrumentation::jsonString(r.heap);
+        out << ", \"solved\": " << (r.solved ? "true" : "false") << ", \"lowerBound\": ";
+        if (isnan(r.lowerBound)) out << "null";
+        else out << r.lowerBound;
+        if (r.solved) {
+            out << ", \"cost\": " << r.cost << ", \"gap\": ";
+            if (r.lowerBound > 0) out << r.cost / r.lowerBound - 1;
+            else out << "null";
+            out << ", \"median\": " << quantile(r.samples, 0.5);
+            out << ", \"p95\": " << quantile(r.samples, 0.95) << ", \"samples\": [";
+            for (size_t j = 0; j < r.samples.size(); j++) out << (j ? ", " : "") << r.samples[j];
+            out << "]";
+        }
+        else out << ", \"error\": " << Instrumentation::jsonString(r.error);
+        out << ", \"peakRssKB\": " << r.peakKB << ", ";
+        Instrumentation::writeJson(out, r.profile);
+        out << ", ";
+        Memory::writeJson(out, r.memory);
+        if (r.hardware.enabled) {
+            out << ", ";
+            HardwareCounters::writeJson(out, r.hardware);
+        }
+        out << "}";
+    }
+    out << endl << "  ]," << endl;
+
+    out << "  \"scaling\": [";
+    bool first = true;
+    for (const string &heap : heaps) {
+        for (const string &algorithm : algorithms) {
+            double exponent;
+            int points;
+            if (!scalingExponent(results, algorithm, heap, exponent, points)) continue;
+            out << (first ? "" : ",") << endl << "    {\"algorithm\": " << Instrumentation::jsonString(algorithm)
+                << ", \"heap\": " << Instrumentation::jsonString(heap) << ", \"exponent\": " << setprecision(3)
+                << exponent << setprecision(9) << ", \"points\": " << points << "}";
+            first = false;
+        }
+    }
+    out << endl << "  ]" << endl << "}" << endl;
+}
+
+// Print the command-line usage
+static void usage(ostream &out) {
+    out << "Usage: tsp_bench --graph EDGES[,NODES] [--graph ...] [options]" << endl << endl;
+    out << "  --graph EDGES[,NODES]  graph to benchmark; repeat for more graphs" << endl;
+    out << "  --sizes N,N,...        also run on the vertices with the first N ids of every graph" << endl;
+    out << "  --algorithm NAMES      comma-separated algorithms (default: all, without the insertion heuristics above "
+        << Data::INSERTION_MAX_VERTICES << " vertices)" << endl;
+    out << "  --heaps NAMES          comma-separated priority queues of Prim and Dijkstra, each run in turn (default: default)" << endl;
+    out << "  --warmup N             unmeasured runs before the measured ones (default: 1)" << endl;
+    out << "  --repetitions N        measured runs (default: 5)" << endl;
+    out << "  --time SECONDS         time budget of the metaheuristics (default: 1)" << endl;
+    out << "  --threads N            threads of the shared pool and replicas of the metaheuristics, 0 for all (default: 0)" << endl;
+    out << "  --perf                 measure the runs with the CPU performance counters (Linux)" << endl;
+    out << "  --index-cache DIR      save the shortest path index of large road networks in DIR, and reuse it" << endl;
+    out << "  --output FILE          write the results to FILE instead of standard output" << endl << endl;
+    out << "Algorithms:";
+    for (const string &name : Data::algorithmNames()) out << ' ' << name;
+    out << endl << "Heaps:";
+    for (const string &name : Data::heapNames()) out << ' ' << name;
+    out << endl;
+}
+
+int main(int argc, char *argv[]) {
+    vector<BenchGraph> graphs;
+    vector<int> sizes;
+    vector<string> algorithms;
+    vector<string> heaps;
+    int warmup = 1, repetitions = 5;
+    double timeBudget = 1;
+    unsigned int threads = 0;
+    filesystem::path outputFilePath, indexCacheFolder;
+    bool hardwareCounters = false;
+
+    // Parse the arguments
+    try {
+        for (int i = 1; i < argc; i++) {
+            string option = argv[i];
+            if (option == "--help" || option == "-h") {
+                usage(cout);
+                return 0;
+            }
+            if (option == "--perf") {
+                hardwareCounters = true;
+                continue;
+            }
+            if (i + 1 == argc) throw runtime_error("Missing value for " + option + ".");
+            string value = argv[++i];
+            stringstream ss(value);
+            string item;
+
+            if (option == "--graph") {
+                BenchGraph graph;
+                getline(ss, item, ',');
+                graph.edges = item;
+                if (getline(ss, item, ',')) graph.nodes = item;
+                graph.name = graph.edges.stem().string();
+                graphs.push_back(graph);
+            }
+            else if (option == "--sizes") {
+                while (getline(ss, item, ',')) sizes.push_back(stoi(item));
+            }
+            else if (option == "--algorithm") {
+                while (getline(ss, item, ',')) {
+                    const vector<string> &names = Data::algorithmNames();
+                    if (find(names.begin(), names.end(), item) == names.end())
+                        throw runtime_error("Unknown algorithm: " + item + ".");
+                    algorithms.push_back(item);
+                }
+            }
+            else if (option == "--heaps") {
+                while (getline(ss, item, ',')) {
+                    const vector<string> &names = Data::heapNames();
+                    if (find(names.begin(), names.end(), item) == names.end())
+                        throw runtime_error("Unknown heap: " + item + ".");
+                    heaps.push_back(item);
+                }
+            }
+            else if (option == "--warmup") warmup = stoi(value);
+            else if (option == "--repetitions") repetitions = stoi(value);
+            else if (option == "--time") timeBudget = stod(value);
+            else if (option == "--threads") threads = stoi(value);
+            else if (option == "--output") outputFilePath = value;
+            else if (option == "--index-cache") indexCacheFolder = value;
+            else throw runtime_error("Unknown option: " + option + ".");
+        }
+        if (graphs.empty()) throw runtime_error("No graph given (--graph).");
+        if (warmup < 0 || repetitions < 1 || !(timeBudget > 0)) throw runtime_error("Invalid run counts or time budget.");
+    } catch (const exception &e) {
+        cerr << e.what() << endl << endl;
+        usage(cerr);
+        return 2;
+    }
+    const bool algorithmsNamed = !algorithms.empty();
+    if (!algorithmsNamed) algorithms = Data::algorithmNames();
+    if (heaps.empty()) heaps.emplace_back("default");
+    sort(sizes.begin(), sizes.end());
+
+    // Open the output file first, so that a bad path does not throw away the runs
+    ofstream outputFile;
+    if (!outputFilePath.empty()) {
+        outputFile.open(outputFilePath);
+        if (!outputFile.is_open()) {
+            cerr << "Error opening the output file." << endl;
+            return 1;
+        }
+    }
+
+    // Run every algorithm on every size of every graph, smallest first, with every heap
+    vector<BenchResult> results;
+    filesystem::path folder = filesystem::temp_directory_path() / ("tsp_bench_" + to_string(chrono::steady_clock::now().time_since_epoch().count()));
+    try {
+        if (!sizes.empty()) filesystem::create_directories(folder);
+        for (const BenchGraph &graph : graphs) {
+            for (int n : sizes) {
+                BenchGraph truncated;
+                if (!truncateGraph(graph, n, folder, truncated)) continue;
+                for (const string &heap : heaps)
+                    benchmarkGraph(truncated, heap, algorithms, algorithmsNamed, warmup, repetitions, timeBudget, threads, hardwareCounters,
+                                   indexCacheFolder, results);
+            }
+            for (const string &heap : heaps)
+                benchmarkGraph(graph, heap, algorithms, algorithmsNamed, warmup, repetitions, timeBudget, threads, hardwareCounters,
+                               indexCacheFolder, results);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        filesystem::remove_all(folder);
+        return 1;
+    }
+    filesystem::remove_all(folder);
+
+    writeJson(outputFilePath.empty() ? cout : outputFile, results, algorithms, heaps, warmup, repetitions, timeBudget, threads);
+    return 0;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file Compare.cpp
+ * @brief tsp_compare: diffs two tsp_bench result files and flags regressions.
+ *
+ * @details Results are matched by graph, algorithm and heap (see tsp_bench --heaps). A run regresses when its median
+ * time grew by more than the time tolerance (and by more than a minimum absolute amount, so that microsecond runs do
+ * not flag noise), when its tour got longer by more than the cost tolerance, when it stopped being solved, or when
+ * it is missing from the candidate file. The exit status is 1 if anything regressed, so the tool can gate scripts.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief A parsed JSON value; only what tsp_bench writes is supported.
+ */
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+    bool boolean = false;
+    double number = 0;
+    string text;
+    vector<JsonValue> items;
+    map<string, JsonValue> members;
+
+    /**
+     * @brief Gets a member of an object.
+     *
+     * @param key The name of the member.
+     *
+     * @return The member, or a null value if there is none.
+     */
+    const JsonValue &operator[](const string &key) const {
+        static const JsonValue none;
+        auto it = members.find(key);
+        return it == members.end() ? none : it->second;
+    }
+};
+
+/**
+ * @brief A recursive descent parser of JSON documents.
+ */
+class JsonParser {
+    const string &s;
+    size_t i = 0;
+
+    // Skip whitespace
+    void skip() {
+        while (i < s.size() && isspace((unsigned char) s[i])) i++;
+    }
+
+    // Consume the expected character
+    void expect(char c) {
+        skip();
+        if (i >= s.size() || s[i] != c) throw runtime_error(string("Invalid JSON: expected '") + c + "' at offset " + to_string(i) + ".");
+        i++;
+    }
+
+    // Parse a string, after its opening quote
+    string parseString() {
+        string text;
+        while (i < s.size() && s[i] != '"') {
+            if (s[i] == '\\' && i + 1 < s.size()) {
+                i++;
+                switch (s[i]) {
+                    case 'n': text += '\n'; break;
+                    case 't': text += '\t'; break;
+                    case 'r': text += '\r'; break;
+                    case 'u': text += '?'; i += 4; break;
+                    default: text += s[i];
+                }
+            }
+            else text += s[i];
+            i++;
+        }
+        expect('"');
+        return text;
+    }
+
+public:
+    explicit JsonParser(const string &s) : s(s) {}
+
+    // Parse a value
+    JsonValue parse() {
+        JsonValue value;
+        skip();
+        if (i >= s.size()) throw runtime_error("Invalid JSON: unexpected end.");
+        char c = s[i];
+        if (c == '{') {
+            value.type = JsonValue::Object;
+            i++;
+            skip();
+            if (s[i] == '}') { i++; return value; }
+            do {
+                expect('"');
+                string key = parseString();
+                expect(':');
+                value.members[key] = parse();
+                skip();
+            } while (s[i] == ',' && ++i);
+            expect('}');
+        }
+        else if (c == '[') {
+            value.type = JsonValue::Array;
+            i++;
+            skip();
+            if (s[i] == ']') { i++; return value; }
+            do {
+                value.items.push_back(parse());
+                skip();
+            } while (s[i] == ',' && ++i);
+            expect(']');
+        }
+        else if (c == '"') {
+            value.type = JsonValue::String;
+            i++;
+            value.text = parseString();
+        }
+        else if (s.compare(i, 4, "true") == 0) { value.type = JsonValue::Bool; value.boolean = true; i += 4; }
+        else if (s.compare(i, 5, "false") == 0) { value.type = JsonValue::Bool; i += 5; }
+        else if (s.compare(i, 4, "null") == 0) { i += 4; }
+        else {
+            size_t end;
+            value.type = JsonValue::Number;
+            value.number = stod(s.substr(i, 32), &end);
+            i += end;
+        }
+        return value;
+    }
+};
+
+// Read and parse a JSON file
+static JsonValue readJson(const string &path) {
+    ifstream file(path);
+    if (!file.is_open()) throw runtime_error("Error opening " + path + ".");
+    stringstream buffer;
+    buffer << file.rdbuf();
+    string text = buffer.str();
+    return JsonParser(text).parse();
+}
+
+// Index the results of a tsp_bench file by graph and algorithm, the heap appended to the algorithm unless it is
+// the default one (or missing, in files written before the heaps could be chosen)
+static map<pair<string, string>, const JsonValue *> indexResults(const JsonValue &document) {
+    map<pair<string, string>, const JsonValue *> index;
+    for (const JsonValue &result : document["results"].items) {
+        const string &heap = result["heap"].text;
+        string algorithm = result["algorithm"].text;
+        if (!heap.empty() && heap != "default") algorithm += " (" + heap + ")";
+        index[{result["graph"].text, algorithm}] = &result;
+    }
+    return index;
+}
+
+int main(int argc, char *argv[]) {
+    double timeTolerance = 0.10, costTolerance = 0.001, minSeconds = 0.001;
+    vector<string> files;
+    try {
+        for (int i = 1; i < argc; i++) {
+            string option = argv[i];
+            if (option == "--time-tolerance" && i + 1 < argc) timeTolerance = stod(argv[++i]) / 100;
+            else if (option == "--cost-tolerance" && i + 1 < argc) costTolerance = stod(argv[++i]) / 100;
+            else if (option == "--min-seconds" && i + 1 < argc) minSeconds = stod(argv[++i]);
+            else if (option.rfind("--", 0) == 0) throw runtime_error("Unknown option: " + option + ".");
+            else files.push_back(option);
+        }
+        if (files.size() != 2) throw runtime_error("Two result files are needed.");
+    } catch (const exception &e) {
+        cerr << e.what() << endl << endl;
+        cerr << "Usage: tsp_compare BASELINE.json CANDIDATE.json [options]" << endl << endl;
+        cerr << "  --time-tolerance PERCENT  allowed growth of the median time (default: 10)" << endl;
+        cerr << "  --cost-tolerance PERCENT  allowed growth of the tour cost (default: 0.1)" << endl;
+        cerr << "  --min-seconds SECONDS     ignore time changes smaller than this (default: 0.001)" << endl;
+        return 2;
+    }
+
+    JsonValue baseline, candidate;
+    try {
+        baseline = readJson(files[0]);
+        candidate = readJson(files[1]);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+    auto before = indexResults(baseline), after = indexResults(candidate);
+
+    int regressions = 0, improvements = 0;
+    cout << left << setw(24) << "graph" << setw(30) << "algorithm" << right << setw(12) << "median"
+         << setw(12) << "new" << setw(9) << "time" << setw(9) << "cost" << "  verdict" << endl;
+    for (auto &[key, newResult] : after) {
+        auto it = before.find(key);
+        if (it == before.end()) continue;
+        const JsonValue &oldResult = *it->second;
+        bool oldSolved = oldResult["solved"].boolean, newSolved = (*newResult)["solved"].boolean;
+        if (!oldSolved && !newSolved) continue;
+
+        string verdict = "ok";
+        double oldMedian = oldResult["median"].number, newMedian = (*newResult)["median"].number;
+        double timeChange = oldMedian > 0 ? newMedian / oldMedian - 1 : 0;
+        double oldCost = oldResult["cost"].number, newCost = (*newResult)["cost"].number;
+        double costChange = oldCost > 0 ? newCost / oldCost - 1 : 0;
+        if (oldSolved && !newSolved) verdict = "REGRESSION (no longer solved)";
+        else if (!oldSolved) verdict = "improvement (now solved)";
+        else if (costChange > costTolerance) verdict = "REGRESSION (cost)";
+        else if (timeChange > timeTolerance && newMedian - oldMedian > minSeconds) verdict = "REGRESSION (time)";
+        else if (costChange < -costTolerance || (timeChange < -timeTolerance && oldMedian - newMedian > minSeconds))
+            verdict = "improvement";
+        if (verdict.rfind("REGRESSION", 0) == 0) regressions++;
+        else if (verdict.rfind("improvement", 0) == 0) improvements++;
+
+        cout << left << setw(24) << key.first << setw(30) << key.second << right << fixed << setprecision(4)
+             << setw(12) << oldMedian << setw(12) << newMedian << setprecision(1) << setw(8) << timeChange * 100 << '%'
+             << setw(8) << costChange * 100 << '%' << "  " << verdict << endl;
+    }
+    for (auto &[key, result] : before) {
+        if (after.count(key)) continue;
+        cout << left << setw(24) << key.first << setw(30) << key.second << "REGRESSION (missing from " << files[1] << ")" << endl;
+        regressions++;
+    }
+
+    cout << endl << regressions << " regression(s), " << improvements << " improvement(s)." << endl;
+    return regressions ? 1 : 0;
+}
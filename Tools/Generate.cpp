@@ -0,0 +1,357 @@
+/**
+ * @file Generate.cpp
+ * @brief tsp_generate: writes synthetic graphs in the format read by Data::readNodesFile and Data::readEdgesFile.
+ *
+ * @details Vertices get the ids 0 .. n - 1 and coordinates in a square around a centre point (Porto by default),
+ * and edges are weighted with the haversine distance in meters, like the distances the program computes itself
+ * for missing edges, so heuristics that mix both stay consistent. Four kinds of graphs are available:
+ *  - uniform: points spread uniformly, each joined to its k nearest neighbours;
+ *  - clustered: points drawn around random cluster centres, each joined to its k nearest neighbours;
+ *  - grid: a jittered lattice joined like a road network: a random spanning tree of the lattice (so the graph
+ *    is connected) plus random lattice edges, diagonals last, until the average degree is reached, with edge
+ *    weights up to 20% longer than the straight line;
+ *  - complete: points spread uniformly, every pair joined.
+ * The k-nearest-neighbour graphs get an edge between consecutive components, by longitude, if they are not
+ * connected. The same seed always writes the same files.
+ */
+
+#include "Graph.h"
+#include "UnionFind.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <numeric>
+
+using namespace std;
+
+/**
+ * @brief Number of vertices above which complete graphs get a warning about the size of the edges file.
+ */
+static constexpr int COMPLETE_WARNING_VERTICES = 10000;
+
+/**
+ * @brief Meters per degree of latitude.
+ */
+static constexpr double METERS_PER_DEGREE = 111195;
+
+/**
+ * @brief A generated vertex.
+ */
+struct Point {
+    double longitude, latitude;
+};
+
+/**
+ * @brief A generated edge, between vertex indices.
+ */
+struct GeneratedEdge {
+    int a, b;
+    double weight;
+};
+
+/**
+ * @brief The options of the generator.
+ */
+struct GeneratorOptions {
+    string kind = "uniform";
+    int n = 1000;
+    unsigned long long seed = 1;
+    int neighbours = 6;             // k of the k-nearest-neighbour graphs
+    double degree = 3;              // average degree of the grid graphs
+    int clusters = 0;               // 0 picks about one cluster per 1000 vertices
+    double widthKm = 0;             // 0 picks a width with a constant density of vertices
+    double centreLongitude = -8.61, centreLatitude = 41.15;
+    string output;
+};
+
+// Straight-line distance between two points, in meters
+static double distance(const Point &p, const Point &q) {
+    return haversine(p.latitude, p.longitude, q.latitude, q.longitude);
+}
+
+// Points spread uniformly over the square
+static vector<Point> uniformPoints(const GeneratorOptions &options, double halfWidth, mt19937_64 &rng) {
+    double halfLongitude = halfWidth / cos(convert_to_radians(options.centreLatitude));
+    uniform_real_distribution<double> dx(-halfLongitude, halfLongitude), dy(-halfWidth, halfWidth);
+    vector<Point> points(options.n);
+    for (Point &p : points) {
+        p.longitude = options.centreLongitude + dx(rng);
+        p.latitude = options.centreLatitude + dy(rng);
+    }
+    return points;
+}
+
+// Points drawn around cluster centres spread uniformly over the square
+static vector<Point> clusteredPoints(const GeneratorOptions &options, double halfWidth, mt19937_64 &rng) {
+    int clusters = options.clusters > 0 ? options.clusters : max(1, options.n / 1000);
+    GeneratorOptions centreOptions = options;
+    centreOptions.n = clusters;
+    vector<Point> centres = uniformPoints(centreOptions, halfWidth, rng);
+
+    double spread = halfWidth / sqrt((double) clusters) / 2;
+    double longitudeScale = 1 / cos(convert_to_radians(options.centreLatitude));
+    normal_distribution<double> offset(0, spread);
+    uniform_int_distribution<int> pick(0, clusters - 1);
+    vector<Point> points(options.n);
+    for (Point &p : points) {
+        const Point &centre = centres[pick(rng)];
+        p.longitude = centre.longitude + offset(rng) * longitudeScale;
+        p.latitude = centre.latitude + offset(rng);
+    }
+    return points;
+}
+
+// Join every point to its k nearest neighbours, found through a grid of buckets, then connect the components
+static vector<GeneratedEdge> nearestNeighbourEdges(const vector<Point> &points, int k) {
+    int n = (int) points.size();
+    double scale = cos(convert_to_radians(points[0].latitude));
+    double minX = numeric_limits<double>::max(), minY = minX, maxX = -minX, maxY = -minX;
+    for (const Point &p : points) {
+        minX = min(minX, p.longitude * scale); maxX = max(maxX, p.longitude * scale);
+        minY = min(minY, p.latitude); maxY = max(maxY, p.latitude);
+    }
+
+    // About two points per bucket
+    int side = max(1, (int) sqrt(n / 2.0));
+    double cellX = (maxX - minX) / side + 1e-12, cellY = (maxY - minY) / side + 1e-12;
+    auto cellOf = [&](const Point &p, int &cx, int &cy) {
+        cx = min(side - 1, (int) ((p.longitude * scale - minX) / cellX));
+        cy = min(side - 1, (int) ((p.latitude - minY) / cellY));
+    };
+    vector<int> start(side * side + 1, 0), order(n);
+    for (const Point &p : points) {
+        int cx, cy;
+        cellOf(p, cx, cy);
+        start[cy * side + cx + 1]++;
+    }
+    for (int c = 0; c < side * side; c++) start[c + 1] += start[c];
+    vector<int> fill(start.begin(), start.end() - 1);
+    for (int i = 0; i < n; i++) {
+        int cx, cy;
+        cellOf(points[i], cx, cy);
+        order[fill[cy * side + cx]++] = i;
+    }
+
+    vector<pair<int, int>> pairs;
+    pairs.reserve((size_t) n * k);
+    vector<pair<double, int>> candidates;
+    for (int i = 0; i < n; i++) {
+        int cx, cy;
+        cellOf(points[i], cx, cy);
+        // Grow the ring of buckets until it holds k points and the next ring cannot hold closer ones
+        candidates.clear();
+        for (int r = 0; r <= side; r++) {
+            for (int y = cy - r; y <= cy + r; y++) {
+                if (y < 0 || y >= side) continue;
+                for (int x = cx - r; x <= cx + r; x++) {
+                    if (x < 0 || x >= side || (abs(x - cx) != r && abs(y - cy) != r)) continue;
+                    for (int s = start[y * side + x]; s < start[y * side + x + 1]; s++) {
+                        int j = order[s];
+                        if (j == i) continue;
+                        double ddx = (points[j].longitude - points[i].longitude) * scale;
+                        double ddy = points[j].latitude - points[i].latitude;
+                        candidates.emplace_back(ddx * ddx + ddy * ddy, j);
+                    }
+                }
+            }
+            if ((int) candidates.size() >= k) {
+                nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end());
+                double reach = r * min(cellX, cellY);
+                if (candidates[k - 1].first <= reach * reach) break;
+            }
+        }
+        int found = min(k, (int) candidates.size());
+        partial_sort(candidates.begin(), candidates.begin() + found, candidates.end());
+        for (int c = 0; c < found; c++) pairs.emplace_back(min(i, candidates[c].second), max(i, candidates[c].second));
+    }
+    sort(pairs.begin(), pairs.end());
+    pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+
+    vector<GeneratedEdge> edges;
+    edges.reserve(pairs.size());
+    UnionFind components(n);
+    for (auto &[a, b] : pairs) {
+        edges.push_back({a, b, distance(points[a], points[b])});
+        components.unite(a, b);
+    }
+
+    // Join consecutive components, by the longitude of their westernmost point
+    vector<int> firsts;
+    vector<char> seen(n, 0);
+    vector<int> byLongitude(n);
+    iota(byLongitude.begin(), byLongitude.end(), 0);
+    sort(byLongitude.begin(), byLongitude.end(), [&](int a, int b) { return points[a].longitude < points[b].longitude; });
+    for (int v : byLongitude) {
+        int root = components.find(v);
+        if (!seen[root]) {
+            seen[root] = 1;
+            firsts.push_back(v);
+        }
+    }
+    for (size_t c = 1; c < firsts.size(); c++)
+        edges.push_back({firsts[c - 1], firsts[c], distance(points[firsts[c - 1]], points[firsts[c]])});
+    return edges;
+}
+
+// A jittered lattice joined like a road network, with the given average degree
+static vector<GeneratedEdge> gridGraph(const GeneratorOptions &options, double halfWidth, mt19937_64 &rng, vector<Point> &points) {
+    int n = options.n;
+    int columns = (int) ceil(sqrt((double) n));
+    double spacing = 2 * halfWidth / columns;
+    double longitudeScale = 1 / cos(convert_to_radians(options.centreLatitude));
+    uniform_real_distribution<double> jitter(-0.3 * spacing, 0.3 * spacing);
+    points.resize(n);
+    for (int i = 0; i < n; i++) {
+        int row = i / columns, column = i % columns;
+        points[i].longitude = options.centreLongitude + (-halfWidth + (column + 0.5) * spacing + jitter(rng)) * longitudeScale;
+        points[i].latitude = options.centreLatitude + (-halfWidth + (row + 0.5) * spacing + jitter(rng));
+    }
+
+    // Lattice edges: orthogonal ones, then diagonal ones, each group shuffled
+    vector<pair<int, int>> orthogonal, diagonal;
+    for (int i = 0; i < n; i++) {
+        int column = i % columns;
+        if (column + 1 < columns && i + 1 < n) orthogonal.emplace_back(i, i + 1);
+        if (i + columns < n) orthogonal.emplace_back(i, i + columns);
+        if (column + 1 < columns && i + columns + 1 < n) diagonal.emplace_back(i, i + columns + 1);
+        if (column > 0 && i + columns - 1 < n) diagonal.emplace_back(i, i + columns - 1);
+    }
+    shuffle(orthogonal.begin(), orthogonal.end(), rng);
+    shuffle(diagonal.begin(), diagonal.end(), rng);
+
+    // A random spanning tree first, so that the graph is connected, then the rest up to the average degree
+    size_t target = max((size_t) (n - 1), (size_t) (options.degree * n / 2));
+    vector<pair<int, int>> chosen, rest;
+    UnionFind components(n);
+    for (auto &e : orthogonal) {
+        if (components.unite(e.first, e.second)) chosen.push_back(e);
+        else rest.push_back(e);
+    }
+    rest.insert(rest.end(), diagonal.begin(), diagonal.end());
+    for (size_t r = 0; r < rest.size() && chosen.size() < target; r++) chosen.push_back(rest[r]);
+
+    uniform_real_distribution<double> detour(1, 1.2);
+    vector<GeneratedEdge> edges;
+    edges.reserve(chosen.size());
+    for (auto &[a, b] : chosen) edges.push_back({a, b, distance(points[a], points[b]) * detour(rng)});
+    return edges;
+}
+
+// Write the nodes file
+static void writeNodes(const string &path, const vector<Point> &points) {
+    ofstream file(path);
+    if (!file.is_open()) throw runtime_error("Error opening " + path + ".");
+    file << "id,longitude,latitude\n" << fixed << setprecision(9);
+    for (size_t i = 0; i < points.size(); i++) file << i << ',' << points[i].longitude << ',' << points[i].latitude << '\n';
+}
+
+// Write the edges file
+static void writeEdges(const string &path, const vector<GeneratedEdge> &edges) {
+    ofstream file(path);
+    if (!file.is_open()) throw runtime_error("Error opening " + path + ".");
+    file << "origem,destino,distancia\n" << fixed << setprecision(1);
+    for (const GeneratedEdge &e : edges) file << e.a << ',' << e.b << ',' << e.weight << '\n';
+}
+
+// Write every pair of points, without holding the edges in memory
+static size_t writeCompleteEdges(const string &path, const vector<Point> &points) {
+    ofstream file(path);
+    if (!file.is_open()) throw runtime_error("Error opening " + path + ".");
+    file << "origem,destino,distancia\n" << fixed << setprecision(1);
+    size_t count = 0;
+    for (size_t a = 0; a < points.size(); a++) {
+        for (size_t b = a + 1; b < points.size(); b++, count++)
+            file << a << ',' << b << ',' << distance(points[a], points[b]) << '\n';
+    }
+    return count;
+}
+
+// Print the command-line usage
+static void usage(ostream &out) {
+    out << "Usage: tsp_generate --kind uniform|clustered|grid|complete --vertices N --output PREFIX [options]" << endl;
+    out << "Writes PREFIX_nodes.csv and PREFIX_edges.csv." << endl << endl;
+    out << "  --seed S            random seed (default: 1)" << endl;
+    out << "  --neighbours K      nearest neighbours of uniform and clustered graphs (default: 6)" << endl;
+    out << "  --degree D          average degree of grid graphs, 2 to 8 (default: 3)" << endl;
+    out << "  --clusters C        clusters of clustered graphs (default: one per 1000 vertices)" << endl;
+    out << "  --width KM          side of the square (default: 0.15 km times the square root of N)" << endl;
+    out << "  --centre LON,LAT    centre of the square (default: -8.61,41.15)" << endl;
+}
+
+int main(int argc, char *argv[]) {
+    GeneratorOptions options;
+    try {
+        for (int i = 1; i < argc; i++) {
+            string option = argv[i];
+            if (option == "--help" || option == "-h") {
+                usage(cout);
+                return 0;
+            }
+            if (i + 1 == argc) throw runtime_error("Missing value for " + option + ".");
+            string value = argv[++i];
+            if (option == "--kind") options.kind = value;
+            else if (option == "--vertices") options.n = stoi(value);
+            else if (option == "--output") options.output = value;
+            else if (option == "--seed") options.seed = stoull(value);
+            else if (option == "--neighbours") options.neighbours = stoi(value);
+            else if (option == "--degree") options.degree = stod(value);
+            else if (option == "--clusters") options.clusters = stoi(value);
+            else if (option == "--width") options.widthKm = stod(value);
+            else if (option == "--centre") {
+                size_t comma = value.find(',');
+                if (comma == string::npos) throw runtime_error("Invalid centre: " + value + ".");
+                options.centreLongitude = stod(value.substr(0, comma));
+                options.centreLatitude = stod(value.substr(comma + 1));
+            }
+            else throw runtime_error("Unknown option: " + option + ".");
+        }
+        if (options.kind != "uniform" && options.kind != "clustered" && options.kind != "grid" && options.kind != "complete")
+            throw runtime_error("Unknown kind: " + options.kind + ".");
+        if (options.output.empty()) throw runtime_error("The output prefix is missing (--output).");
+        if (options.n < 2 || options.neighbours < 1 || options.degree < 2 || options.degree > 8 || options.widthKm < 0)
+            throw runtime_error("Invalid size, neighbours, degree or width.");
+    } catch (const exception &e) {
+        cerr << e.what() << endl << endl;
+        usage(cerr);
+        return 2;
+    }
+
+    mt19937_64 rng(options.seed);
+    double widthKm = options.widthKm > 0 ? options.widthKm : max(1.0, 0.15 * sqrt((double) options.n));
+    double halfWidth = widthKm * 1000 / 2 / METERS_PER_DEGREE; // In degrees of latitude
+    string nodesPath = options.output + "_nodes.csv", edgesPath = options.output + "_edges.csv";
+
+    try {
+        vector<Point> points;
+        size_t edgeCount;
+        if (options.kind == "grid") {
+            vector<GeneratedEdge> edges = gridGraph(options, halfWidth, rng, points);
+            writeEdges(edgesPath, edges);
+            edgeCount = edges.size();
+        }
+        else {
+            points = options.kind == "clustered" ? clusteredPoints(options, halfWidth, rng) : uniformPoints(options, halfWidth, rng);
+            if (options.kind == "complete") {
+                if (options.n > COMPLETE_WARNING_VERTICES)
+                    cerr << "Warning: " << (size_t) options.n * (options.n - 1) / 2 << " edges will be written." << endl;
+                edgeCount = writeCompleteEdges(edgesPath, points);
+            }
+            else {
+                vector<GeneratedEdge> edges = nearestNeighbourEdges(points, min(options.neighbours, options.n - 1));
+                writeEdges(edgesPath, edges);
+                edgeCount = edges.size();
+            }
+        }
+        writeNodes(nodesPath, points);
+        cerr << options.kind << " graph: " << points.size() << " vertices, " << edgeCount << " edges, written to "
+             << nodesPath << " and " << edgesPath << endl;
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+#ifndef FEUP_DA_PROJECT_2_UNION_FIND
+#define FEUP_DA_PROJECT_2_UNION_FIND
+
+#include <vector>
+#include <numeric>
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief A disjoint-set (union-find) data structure over the elements 0 .. n - 1.
+ *
+ * @complexity Find and Unite: O(α(n)) amortized, using union by size and path halving.
+ */
+
+class UnionFind {
+        std::vector<int> representative;
+        std::vector<int> setSize;
+        public:
+        explicit UnionFind(int n);
+        int find(int x);
+        bool unite(int a, int b);
+        bool connected(int a, int b);
+        int componentSize(int x);
+};
+
+/**
+ * @brief Constructs a new UnionFind object where every element is in its own set.
+ *
+ * @param n The number of elements.
+ */
+inline UnionFind::UnionFind(int n) : representative(n), setSize(n, 1) {
+    std::iota(representative.begin(), representative.end(), 0);
+}
+
+/**
+ * @brief Finds the representative of the set that contains an element.
+ *
+ * @param x The element.
+ *
+ * @return The representative of the set of x.
+ */
+inline int UnionFind::find(int x) {
+    while (representative[x] != x) {
+        representative[x] = representative[representative[x]]; // path halving
+        x = representative[x];
+    }
+    return x;
+}
+
+/**
+ * @brief Merges the sets that contain two elements.
+ *
+ * @param a The first element.
+ * @param b The second element.
+ *
+ * @return True if the sets were merged, false if both elements were already in the same set.
+ */
+inline bool UnionFind::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return false;
+    if (setSize[a] < setSize[b]) std::swap(a, b);
+    representative[b] = a;
+    setSize[a] += setSize[b];
+    return true;
+}
+
+/**
+ * @brief Checks if two elements are in the same set.
+ *
+ * @param a The first element.
+ * @param b The second element.
+ *
+ * @return True if both elements are in the same set, otherwise false.
+ */
+inline bool UnionFind::connected(int a, int b) {
+    return find(a) == find(b);
+}
+
+/**
+ * @brief Gets the number of elements in the set that contains an element.
+ *
+ * @param x The element.
+ *
+ * @return The size of the set of x.
+ */
+inline int UnionFind::componentSize(int x) {
+    return setSize[find(x)];
+}
+
+/**
+ * @brief A disjoint-set (union-find) data structure over the elements 0 .. n - 1 that several threads can use at once.
+ *
+ * @details Representatives are atomic and every change is a single compare-and-swap, so no lock is needed. A root is
+ * always linked under a root with a smaller index, which keeps concurrent unions from ever creating a cycle, and finds
+ * halve the paths they walk as UnionFind does (a lost race only leaves a path longer than it could be).
+ *
+ * @complexity Find and Unite: O(log n) amortized, lock-free.
+ */
+
+class ConcurrentUnionFind {
+        std::unique_ptr<std::atomic<int>[]> representative;
+        public:
+        explicit ConcurrentUnionFind(int n);
+        int find(int x);
+        bool unite(int a, int b);
+        bool connected(int a, int b);
+};
+
+/**
+ * @brief Constructs a new ConcurrentUnionFind object where every element is in its own set.
+ *
+ * @param n The number of elements.
+ */
+inline ConcurrentUnionFind::ConcurrentUnionFind(int n) : representative(new std::atomic<int>[n]) {
+    for (int i = 0; i < n; ++i) representative[i].store(i, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Finds the representative of the set that contains an element.
+ *
+ * @param x The element.
+ *
+ * @return The representative of the set of x, which may be outdated if other threads are uniting sets.
+ */
+inline int ConcurrentUnionFind::find(int x) {
+    while (true) {
+        int up = representative[x].load(std::memory_order_acquire);
+        if (up == x) return x;
+        int upUp = representative[up].load(std::memory_order_acquire);
+        if (up != upUp) representative[x].compare_exchange_weak(up, upUp, std::memory_order_acq_rel); // path halving
+        x = upUp;
+    }
+}
+
+/**
+ * @brief Merges the sets that contain two elements.
+ *
+ * @param a The first element.
+ * @param b The second element.
+ *
+ * @return True if this call merged the sets, false if both elements were already in the same set.
+ */
+inline bool ConcurrentUnionFind::unite(int a, int b) {
+    while (true) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (a < b) std::swap(a, b);
+        int expected = a;
+        if (representative[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return true;
+        // a stopped being a root in the meantime: retry from the new roots
+    }
+}
+
+/**
+ * @brief Checks if two elements are in the same set.
+ *
+ * @param a The first element.
+ * @param b The second element.
+ *
+ * @return True if both elements are in the same set, otherwise false.
+ */
+inline bool ConcurrentUnionFind::connected(int a, int b) {
+    return find(a) == find(b);
+}
+
+#endif /* FEUP_DA_PROJECT_2_UNION_FIND */
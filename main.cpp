@@ -1,10 +1,14 @@
 #include "App.h"
+#include "Batch.h"
 #include "Data.h"
 
 using namespace std;
 
-int main()
+int main(int argc, char *argv[])
 {
+    // With arguments, run without the menus (see Batch::usage)
+    if (argc > 1) return Batch::run(argc, argv);
+
     App* app = App::getInstance();
 
     // Display the main menu
@@ -17,4 +21,4 @@ int main()
     delete app;
 
     return 0;
-}
\ No newline at end of file
+}